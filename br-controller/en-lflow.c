@@ -116,6 +116,7 @@ void *en_lflow_output_init(struct engine_node *node OVS_UNUSED,
     ovn_extend_table_init(&lflow_data->group_table, "group-table", 0);
     ovn_extend_table_init(&lflow_data->meter_table, "meter-table", 0);
     br_controller_extend_symtab(&lflow_data->pd.symtab);
+    expr_symtab_freeze(&lflow_data->pd.symtab);
 
     return lflow_data;
 }
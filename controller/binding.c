@@ -532,6 +532,94 @@ ovs_qos_entries_gc(struct ovsdb_idl_txn *ovs_idl_txn,
     }
 }
 
+/* Fills 'installed_queues' with the queues of the OVN owned QoS rows that are
+ * attached to a port, indexed by their "ovn_port". */
+static void
+collect_installed_qos_queues(struct ovsdb_idl_index *ovsrec_port_by_qos,
+                             const struct ovsrec_qos_table *qos_table,
+                             struct shash *installed_queues)
+{
+    const struct ovsrec_qos *qos;
+    OVSREC_QOS_TABLE_FOR_EACH (qos, qos_table) {
+        if (!smap_get_bool(&qos->external_ids, "ovn_qos", false)
+            || !ovsport_lookup_by_qos(ovsrec_port_by_qos, qos)) {
+            continue;
+        }
+        for (size_t i = 0; i < qos->n_queues; i++) {
+            const struct ovsrec_queue *queue = qos->value_queues[i];
+            const char *port =
+                queue ? smap_get(&queue->external_ids, "ovn_port") : NULL;
+            if (port) {
+                shash_add_once(installed_queues, port, queue);
+            }
+        }
+    }
+}
+
+/* Returns true if the queue that was installed for 'q' is in
+ * 'installed_queues' with the rates recorded in 'q'. */
+static bool
+qos_queue_is_installed(const struct qos_queue *q,
+                       const struct shash *installed_queues)
+{
+    const struct ovsrec_queue *queue = shash_find_data(installed_queues,
+                                                       q->port);
+    if (!queue) {
+        return false;
+    }
+
+    const struct smap *cfg = &queue->other_config;
+    return smap_get_ullong(cfg, "max-rate", 0) == q->max_rate
+           && smap_get_ullong(cfg, "min-rate", 0) == q->min_rate
+           && smap_get_ullong(cfg, "burst", 0) == q->burst;
+}
+
+/* Handles changes to the OVS QoS and Queue tables.  The only runtime data
+ * that depends on them is 'qos_map', which records the queues installed by
+ * ovn-controller.  Changes to other QoS rows are ignored; if one of ours was
+ * modified or removed by someone else, forget about it so that update_qos()
+ * installs it again. */
+void
+binding_handle_ovs_qos_changes(struct binding_ctx_in *b_ctx_in,
+                               struct binding_ctx_out *b_ctx_out)
+{
+    bool ovn_qos_changed = false;
+
+    const struct ovsrec_qos *qos;
+    OVSREC_QOS_TABLE_FOR_EACH_TRACKED (qos, b_ctx_in->qos_table) {
+        if (smap_get_bool(&qos->external_ids, "ovn_qos", false)) {
+            ovn_qos_changed = true;
+            break;
+        }
+    }
+
+    const struct ovsrec_queue *queue;
+    OVSREC_QUEUE_TABLE_FOR_EACH_TRACKED (queue, b_ctx_in->queue_table) {
+        if (smap_get(&queue->external_ids, "ovn_port")) {
+            ovn_qos_changed = true;
+            break;
+        }
+    }
+
+    if (!ovn_qos_changed) {
+        return;
+    }
+
+    struct shash installed_queues = SHASH_INITIALIZER(&installed_queues);
+    collect_installed_qos_queues(b_ctx_in->ovsrec_port_by_qos,
+                                 b_ctx_in->qos_table, &installed_queues);
+
+    struct qos_queue *q;
+    HMAP_FOR_EACH_SAFE (q, node, b_ctx_out->qos_map) {
+        if (!qos_queue_is_installed(q, &installed_queues)) {
+            add_or_del_qos_port(q->port, true);
+            hmap_remove(b_ctx_out->qos_map, &q->node);
+            qos_queue_erase_entry(q);
+        }
+    }
+    shash_destroy(&installed_queues);
+}
+
 /*
  * Get the encap from the chassis for this port. The interface
  * may have an external_ids:encap-ip=<encap-ip> set; if so we
@@ -1451,26 +1539,32 @@ claim_lport(const struct sbrec_port_binding *pb,
 
     if (can_bind == CAN_BIND_AS_MAIN) {
         if (pb->chassis != chassis_rec) {
-            long long int now = time_msec();
-            if (pb->chassis) {
-                if (lport_maybe_postpone(pb, chassis_rec, now,
-                                         postponed_ports)) {
-                    return true;
+            if (if_status_mgr_claim_is_held(if_mgr, pb->logical_port)) {
+                /* Already claimed, pb->chassis is updated when the claim
+                 * batch is sent. */
+                update_tracked = true;
+            } else {
+                long long int now = time_msec();
+                if (pb->chassis) {
+                    if (lport_maybe_postpone(pb, chassis_rec, now,
+                                             postponed_ports)) {
+                        return true;
+                    }
                 }
-            }
-            if (is_additional_chassis(pb, chassis_rec)) {
-                if (sb_readonly) {
-                    return false;
+                if (is_additional_chassis(pb, chassis_rec)) {
+                    if (sb_readonly) {
+                        return false;
+                    }
+                    remove_additional_chassis(pb, chassis_rec);
                 }
-                remove_additional_chassis(pb, chassis_rec);
-            }
-            update_tracked = true;
+                update_tracked = true;
 
-            if_status_mgr_claim_iface(if_mgr, pb, chassis_rec, iface_rec,
-                                      sb_readonly, can_bind, is_vif,
-                                      parent_pb);
-            register_claim_timestamp(pb->logical_port, now);
-            sset_find_and_delete(postponed_ports, pb->logical_port);
+                if_status_mgr_claim_iface(if_mgr, pb, chassis_rec, iface_rec,
+                                          sb_readonly, can_bind, is_vif,
+                                          parent_pb);
+                register_claim_timestamp(pb->logical_port, now);
+                sset_find_and_delete(postponed_ports, pb->logical_port);
+            }
         } else {
             update_tracked = true;
             if ((pb->n_up && !pb->up[0]) ||
@@ -1483,7 +1577,8 @@ claim_lport(const struct sbrec_port_binding *pb,
             }
         }
     } else if (can_bind == CAN_BIND_AS_ADDITIONAL) {
-        if (!is_additional_chassis(pb, chassis_rec)) {
+        if (!is_additional_chassis(pb, chassis_rec) &&
+            !if_status_mgr_claim_is_held(if_mgr, pb->logical_port)) {
             if_status_mgr_claim_iface(if_mgr, pb, chassis_rec, iface_rec,
                                       sb_readonly, can_bind, is_vif,
                                       parent_pb);
@@ -33,6 +33,7 @@ struct ovsdb_idl_txn;
 struct ovsrec_bridge;
 struct ovsrec_port_table;
 struct ovsrec_qos_table;
+struct ovsrec_queue_table;
 struct ovsrec_bridge_table;
 struct ovsrec_open_vswitch_table;
 struct sbrec_chassis;
@@ -51,6 +52,7 @@ struct binding_ctx_in {
     struct ovsdb_idl_index *ovsrec_port_by_qos;
     struct ovsdb_idl_index *ovsrec_queue_by_external_ids;
     const struct ovsrec_qos_table *qos_table;
+    const struct ovsrec_queue_table *queue_table;
     const struct sbrec_port_binding_table *port_binding_table;
     const struct ovsrec_bridge *br_int;
     const struct sbrec_chassis *chassis_rec;
@@ -205,6 +207,8 @@ bool binding_handle_ovs_interface_changes(struct binding_ctx_in *,
                                           struct binding_ctx_out *);
 bool binding_handle_port_binding_changes(struct binding_ctx_in *,
                                          struct binding_ctx_out *);
+void binding_handle_ovs_qos_changes(struct binding_ctx_in *,
+                                    struct binding_ctx_out *);
 void binding_tracked_dp_destroy(struct hmap *tracked_datapaths);
 
 void binding_dump_local_bindings(struct local_binding_data *, struct ds *);
@@ -34,7 +34,7 @@ static void ct_zone_add_pending(struct shash *pending_ct_zones,
 static int ct_zone_get_snat(const struct sbrec_datapath_binding *dp);
 static bool ct_zone_assign_unused(struct ct_zone_ctx *ctx,
                                   const char *zone_name,
-                                  int *scan_start, int scan_stop);
+                                  int min_ct_zone, int max_ct_zone);
 static bool ct_zone_remove(struct ct_zone_ctx *ctx, const char *name);
 static void ct_zone_add(struct ct_zone_ctx *ctx, const char *name,
                         uint16_t zone, bool set_pending);
@@ -54,6 +54,7 @@ ct_zone_ctx_init(struct ct_zone_ctx *ctx)
 {
     shash_init(&ctx->pending);
     shash_init(&ctx->current);
+    ctx->first_free = 1;
 }
 
 void
@@ -71,6 +72,7 @@ ct_zones_restore(struct ct_zone_ctx *ctx,
 {
     memset(ctx->bitmap, 0, sizeof ctx->bitmap);
     bitmap_set1(ctx->bitmap, 0); /* Zone 0 is reserved. */
+    ctx->first_free = 1;
 
     struct shash_node *pending_node;
     SHASH_FOR_EACH (pending_node, &ctx->pending) {
@@ -278,7 +280,7 @@ ct_zones_update(const struct simap *local_lports,
             continue;
         }
 
-        ct_zone_assign_unused(ctx, user, &min_ct_zone, max_ct_zone);
+        ct_zone_assign_unused(ctx, user, min_ct_zone, max_ct_zone);
     }
 
     simap_destroy(&req_snat_zones);
@@ -287,6 +289,29 @@ ct_zones_update(const struct simap *local_lports,
     bitmap_free(unreq_snat_zones_map);
 }
 
+/* Returns the CT_Zone of 'ovs_dp' for 'zone', if any.  The keys of the
+ * "ct_zones" map are kept sorted by the IDL. */
+static struct ovsrec_ct_zone *
+ct_zone_find_ovs_zone(const struct ovsrec_datapath *ovs_dp, uint16_t zone)
+{
+    size_t lo = 0;
+    size_t hi = ovs_dp->n_ct_zones;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int64_t key = ovs_dp->key_ct_zones[mid];
+
+        if (key == zone) {
+            return ovs_dp->value_ct_zones[mid];
+        } else if (key < zone) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return NULL;
+}
+
 void
 ct_zones_commit(const struct ovsrec_bridge *br_int,
                 const struct ovsrec_datapath *ovs_dp,
@@ -297,12 +322,6 @@ ct_zones_commit(const struct ovsrec_bridge *br_int,
         return;
     }
 
-    struct ovsrec_ct_zone **all_zones =
-            xzalloc(sizeof *all_zones * (MAX_CT_ZONES + 1));
-    for (size_t i = 0; i < ovs_dp->n_ct_zones; i++) {
-        all_zones[ovs_dp->key_ct_zones[i]] = ovs_dp->value_ct_zones[i];
-    }
-
     struct shash_node *iter;
     SHASH_FOR_EACH (iter, &ctx->pending) {
         struct ct_zone_pending_entry *ctzpe = iter->data;
@@ -333,7 +352,8 @@ ct_zones_commit(const struct ovsrec_bridge *br_int,
         }
         free(user_str);
 
-        struct ovsrec_ct_zone *ovs_zone = all_zones[ct_zone->zone];
+        struct ovsrec_ct_zone *ovs_zone = ct_zone_find_ovs_zone(ovs_dp,
+                                                               ct_zone->zone);
         if ((!ctzpe->add || ct_zone->limit < 0) && ovs_zone) {
             ovsrec_datapath_update_ct_zones_delkey(ovs_dp, ct_zone->zone);
         } else if (ctzpe->add && ct_zone->limit >= 0) {
@@ -347,8 +367,6 @@ ct_zones_commit(const struct ovsrec_bridge *br_int,
 
         ctzpe->state = CT_ZONE_DB_SENT;
     }
-
-    free(all_zones);
 }
 
 void
@@ -408,8 +426,8 @@ ct_zone_handle_dp_update(struct ct_zone_ctx *ctx,
 bool
 ct_zone_handle_port_update(struct ct_zone_ctx *ctx,
                            const struct sbrec_port_binding *pb,
-                           bool updated, int *scan_start,
-                           int min_ct_zone, int max_ct_zone)
+                           bool updated, int min_ct_zone,
+                           int max_ct_zone)
 {
     struct shash_node *node = shash_find(&ctx->current, pb->logical_port);
 
@@ -424,7 +442,7 @@ ct_zone_handle_port_update(struct ct_zone_ctx *ctx,
     if (updated) {
         if (!node) {
             ct_zone_assign_unused(ctx, pb->logical_port,
-                                  scan_start, max_ct_zone);
+                                  min_ct_zone, max_ct_zone);
         }
         ct_zone_limit_update(ctx, pb->logical_port, ct_zone_get_pb_limit(pb));
         return true;
@@ -462,19 +480,26 @@ ct_zones_limits_sync(struct ct_zone_ctx *ctx,
     }
 }
 
+/* Assigns to 'zone_name' the lowest unused zone in the
+ * ['min_ct_zone', 'max_ct_zone'] range.  The scan starts at
+ * 'ctx->first_free' so that the allocated zones at the bottom of the range
+ * aren't scanned again for every new port. */
 static bool
 ct_zone_assign_unused(struct ct_zone_ctx *ctx, const char *zone_name,
-                      int *scan_start, int scan_stop)
+                      int min_ct_zone, int max_ct_zone)
 {
     /* We assume that there are 64K zones and that we own them all. */
-    int zone = bitmap_scan(ctx->bitmap, 0, *scan_start, scan_stop + 1);
-    if (zone == scan_stop + 1) {
+    int scan_start = MAX(min_ct_zone, ctx->first_free);
+    int zone = bitmap_scan(ctx->bitmap, 0, scan_start, max_ct_zone + 1);
+    if (zone == max_ct_zone + 1) {
         static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 1);
         VLOG_WARN_RL(&rl, "exhausted all ct zones");
         return false;
     }
 
-    *scan_start = zone + 1;
+    if (scan_start == ctx->first_free) {
+        ctx->first_free = zone + 1;
+    }
     ct_zone_add(ctx, zone_name, zone, true);
 
     return true;
@@ -495,6 +520,7 @@ ct_zone_remove(struct ct_zone_ctx *ctx, const char *name)
     ct_zone_add_pending(&ctx->pending, CT_ZONE_OF_QUEUED,
                         ct_zone, false, name);
     bitmap_set0(ctx->bitmap, ct_zone->zone);
+    ctx->first_free = MIN(ctx->first_free, ct_zone->zone);
     shash_delete(&ctx->current, node);
     free(ct_zone);
 
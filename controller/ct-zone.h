@@ -35,6 +35,9 @@
 struct ct_zone_ctx {
     unsigned long bitmap[BITMAP_SIZE]; /* Bitmap indication of allocated
                                         * zones. */
+    int first_free;                    /* All the zones below are allocated,
+                                        * scans for unused zones start here.
+                                        */
     struct shash pending;              /* Pending entries,
                                         * 'struct ct_zone_pending_entry'
                                         * by name. */
@@ -84,8 +87,8 @@ bool ct_zone_handle_dp_update(struct ct_zone_ctx *ctx,
                               const struct shash *local_lports);
 bool ct_zone_handle_port_update(struct ct_zone_ctx *ctx,
                                 const struct sbrec_port_binding *pb,
-                                bool updated, int *scan_start,
-                                int min_ct_zone, int max_ct_zone);
+                                bool updated, int min_ct_zone,
+                                int max_ct_zone);
 uint16_t ct_zone_find_zone(const struct shash *ct_zones, const char *name);
 void ct_zones_limits_sync(struct ct_zone_ctx *ctx,
                           const struct hmap *local_datapaths,
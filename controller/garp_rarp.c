@@ -278,16 +278,30 @@ garp_rarp_lookup(const struct eth_addr ea, ovs_be32 ipv4, uint32_t dp_key,
     return NULL;
 }
 
+static void
+garp_rarp_data_bump_seqno(void)
+{
+    uint64_t orig;
+    atomic_add(&garp_rarp_data.seqno, 1, &orig);
+}
+
 void
 garp_rarp_node_reset_timers(const char *logical_port)
 {
     struct garp_rarp_node *grn;
+    bool reset = false;
+
     CMAP_FOR_EACH (grn, cmap_node, &garp_rarp_data.data) {
         if (grn->logical_port && !strcmp(grn->logical_port, logical_port)) {
             atomic_store(&grn->announce_time, time_msec() + 1000);
             atomic_store(&grn->backoff, 1000);
+            reset = true;
         }
     }
+
+    if (reset) {
+        garp_rarp_data_bump_seqno();
+    }
 }
 
 static void
@@ -325,6 +339,7 @@ garp_rarp_node_add(const struct eth_addr ea, ovs_be32 ip,
     grn->stale = false;
     cmap_insert(&garp_rarp_data.data, &grn->cmap_node,
                 garp_rarp_node_hash_struct(grn));
+    garp_rarp_data_bump_seqno();
     garp_rarp_data_has_changed = true;
 }
 
@@ -542,17 +557,24 @@ garp_rarp_run(struct garp_rarp_ctx_in *r_ctx_in)
         garp_rarp_max_timeout != garp_rarp_data.max_timeout ||
         garp_rarp_continuous != garp_rarp_data.continuous);
 
+    bool changed = false;
     CMAP_FOR_EACH (grn, cmap_node, &garp_rarp_data.data) {
         if (grn->stale) {
             cmap_remove(&garp_rarp_data.data, &grn->cmap_node,
                         garp_rarp_node_hash_struct(grn));
             ovsrcu_postpone(garp_rarp_node_free, grn);
+            changed = true;
         } else if (reset_timers) {
             atomic_store(&grn->announce_time, time_msec() + 1000);
             atomic_store(&grn->backoff, 1000);
+            changed = true;
         }
     }
 
+    if (changed) {
+        garp_rarp_data_bump_seqno();
+    }
+
     garp_rarp_data.max_timeout = garp_rarp_max_timeout;
     garp_rarp_data.continuous = garp_rarp_continuous;
 }
@@ -563,6 +585,14 @@ garp_rarp_get_data(void)
     return &garp_rarp_data;
 }
 
+uint64_t
+garp_rarp_data_get_seqno(void)
+{
+    uint64_t seqno;
+    atomic_read(&garp_rarp_data.seqno, &seqno);
+    return seqno;
+}
+
 bool
 garp_rarp_data_changed(void) {
     bool ret = garp_rarp_data_has_changed;
@@ -581,6 +611,7 @@ struct ed_type_garp_rarp *
 garp_rarp_init(void)
 {
     cmap_init(&garp_rarp_data.data);
+    atomic_init(&garp_rarp_data.seqno, 0);
     garp_rarp_data.max_timeout = GARP_RARP_DEF_MAX_TIMEOUT;
     garp_rarp_data.continuous = false;
 
@@ -19,6 +19,7 @@
 #define GARP_RARP_H 1
 
 #include "cmap.h"
+#include "heap.h"
 #include "sset.h"
 #include "openvswitch/types.h"
 #include "if-status.h"
@@ -38,12 +39,19 @@ struct garp_rarp_node {
     bool stale;                  /* Used during sync to remove stale
                                   * information. */
     char *logical_port;          /* Name of the cr logical_port, if any */
+    struct heap_node heap_node;  /* In pinctrl's announcement schedule,
+                                  * pinctrl_handler thread only. */
 };
 
 /* Contains all required data for pinctrl to actually send garps. */
 struct garp_rarp_data {
     struct cmap data;
 
+    /* Changes every time a node is added or removed, or the timers of a
+     * node are reset, so that readers know they have to re-read the
+     * announcement times. */
+    atomic_uint64_t seqno;
+
     long long int max_timeout;
     bool continuous;
 };
@@ -73,6 +81,7 @@ struct ed_type_garp_rarp {
 void garp_rarp_run(struct garp_rarp_ctx_in *);
 void garp_rarp_node_free(struct garp_rarp_node *);
 const struct garp_rarp_data *garp_rarp_get_data(void);
+uint64_t garp_rarp_data_get_seqno(void);
 bool garp_rarp_data_changed(void);
 
 struct ed_type_garp_rarp *garp_rarp_init(void);
@@ -24,6 +24,8 @@
 
 #include "lib/hmapx.h"
 #include "lib/util.h"
+#include "openvswitch/dynamic-string.h"
+#include "openvswitch/poll-loop.h"
 #include "timeval.h"
 #include "openvswitch/vlog.h"
 #include "lib/vswitch-idl.h"
@@ -54,6 +56,15 @@ VLOG_DEFINE_THIS_MODULE(if_status);
  * C. At every iteration, based on ofctrl_seqno updates, handled in
  *    if_status_mgr_run():
  * - the flows for a previously claimed interface have been installed in OVS.
+ *
+ * If claim batching is enabled (if_status_mgr_set_claim_batch_msec()), newly
+ * claimed interfaces stay in OIF_CLAIMED, without their pb->chassis being
+ * updated, until the batch latency expires.  Then all of them are updated in
+ * the same SB transaction and wait for the same ofctrl seqno.
+ *
+ * The time each interface spends in every state, from the moment it is
+ * claimed until it is marked "up", is recorded in per-state latency
+ * histograms, see if_status_mgr_format_latency().
  */
 
 enum if_state {
@@ -103,6 +114,32 @@ static const char *if_state_names[] = {
     [OIF_UPDATE_PORT]      = "UPDATE_PORT",
 };
 
+/* States an interface goes through between being claimed and being
+ * installed, in order. */
+static const enum if_state if_bringup_states[] = {
+    OIF_CLAIMED,
+    OIF_WAITING_SB_COND,
+    OIF_INSTALL_FLOWS,
+    OIF_REM_OLD_OVN_INST,
+    OIF_MARK_UP,
+};
+
+/* Number of buckets of the bring-up latency histograms.  The upper bounds of
+ * the buckets, in milliseconds, are listed in if_latency_bounds_ms; the last
+ * bucket counts all the longer samples. */
+#define IF_LATENCY_N_BUCKETS 11
+
+static const uint64_t if_latency_bounds_ms[IF_LATENCY_N_BUCKETS - 1] = {
+    10, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 30000,
+};
+
+struct if_latency_stats {
+    uint64_t n_samples;
+    uint64_t total_msec;
+    uint64_t max_msec;
+    uint64_t buckets[IF_LATENCY_N_BUCKETS];
+};
+
 /*
  *       +----------------------+
  * +---> |                      |
@@ -209,6 +246,20 @@ struct ovs_iface {
     uint16_t mtu;           /* Extracted from OVS interface.mtu field. */
     enum can_bind bind_type;/* CAN_BIND_AS_MAIN or CAN_BIND_AS_ADDITIONAL */
     bool is_vif;            /* Vifs, container or virtual ports */
+
+    /* Bring-up latency tracing. */
+    long long int state_msec;     /* Time at which 'state' was entered. */
+    long long int claim_msec;     /* Time at which the interface was last
+                                   * claimed, 0 if the bring-up was
+                                   * aborted. */
+    long long int installed_msec; /* Time at which the interface reached
+                                   * OIF_INSTALLED, 0 if it didn't yet. */
+    long long int time_in_state[OIF_MAX]; /* Milliseconds spent in each
+                                           * state since 'claim_msec'. */
+    long long int state_entry_msec[OIF_MAX]; /* Time at which each state
+                                              * was first entered since
+                                              * 'claim_msec', 0 if it
+                                              * wasn't. */
 };
 
 static uint64_t ifaces_usage;
@@ -235,6 +286,24 @@ struct if_status_mgr {
      * interfaces have been installed.
      */
     uint32_t iface_seqno;
+
+    /* Maximum time, in milliseconds, newly claimed interfaces are held in
+     * OIF_CLAIMED so that the Port_Binding updates of all interfaces that
+     * show up together are sent in a single SB transaction and share a
+     * single flow installation barrier.  0 disables batching. */
+    unsigned int claim_batch_msec;
+    /* Time at which the first interface of the current batch was
+     * claimed. */
+    long long int claim_batch_start;
+    /* True if the Port_Binding updates of the interfaces in OIF_CLAIMED
+     * have been deferred to the end of the batch. */
+    bool claims_deferred;
+
+    /* Latency of the completed bring-ups, as a whole and per state. */
+    struct if_latency_stats bringup_latency;
+    struct if_latency_stats state_latency[OIF_MAX];
+    /* Number of bring-ups interrupted before OIF_INSTALLED. */
+    uint64_t n_aborted_bringups;
 };
 
 static struct ovs_iface *
@@ -283,6 +352,7 @@ if_status_mgr_clear(struct if_status_mgr *mgr)
     ovs_assert(shash_is_empty(&mgr->ifaces));
 
     sset_clear(&mgr->claimed_cr);
+    mgr->claims_deferred = false;
 
     SHASH_FOR_EACH_SAFE (node, &mgr->ovn_uninstall_hash) {
         ovn_uninstall_hash_destroy(mgr, node);
@@ -327,6 +397,7 @@ if_status_mgr_claim_iface(struct if_status_mgr *mgr,
 {
     const char *iface_id = pb->logical_port;
     struct ovs_iface *iface = shash_find_data(&mgr->ifaces, iface_id);
+    bool new_batch = hmapx_is_empty(&mgr->ifaces_per_state[OIF_CLAIMED]);
 
     if (!iface) {
         iface = ovs_iface_create(mgr, iface_id, iface_rec, OIF_CLAIMED);
@@ -343,13 +414,6 @@ if_status_mgr_claim_iface(struct if_status_mgr *mgr,
         !strcmp(pb->type, "chassisredirect")) {
         sset_add(&mgr->claimed_cr, pb->logical_port);
     }
-    if (!sb_readonly) {
-        if (bind_type == CAN_BIND_AS_MAIN) {
-            set_pb_chassis_in_sbrec(pb, chassis_rec, true);
-        } else if (bind_type == CAN_BIND_AS_ADDITIONAL) {
-            set_pb_additional_chassis_in_sbrec(pb, chassis_rec, true);
-        }
-    }
 
     switch (iface->state) {
     case OIF_CLAIMED:
@@ -369,6 +433,65 @@ if_status_mgr_claim_iface(struct if_status_mgr *mgr,
         OVS_NOT_REACHED();
         break;
     }
+
+    if (mgr->claim_batch_msec && iface->state == OIF_CLAIMED) {
+        /* Defer the Port_Binding update to the end of the batch, see
+         * if_status_mgr_update(). */
+        if (new_batch) {
+            mgr->claim_batch_start = time_msec();
+        }
+        mgr->claims_deferred = true;
+    } else if (!sb_readonly) {
+        if (bind_type == CAN_BIND_AS_MAIN) {
+            set_pb_chassis_in_sbrec(pb, chassis_rec, true);
+        } else if (bind_type == CAN_BIND_AS_ADDITIONAL) {
+            set_pb_additional_chassis_in_sbrec(pb, chassis_rec, true);
+        }
+    }
+}
+
+/* Sets the maximum time, in milliseconds, the Port_Binding updates of newly
+ * claimed interfaces may be delayed in order to batch them.  0 disables
+ * batching. */
+void
+if_status_mgr_set_claim_batch_msec(struct if_status_mgr *mgr,
+                                   unsigned int batch_msec)
+{
+    mgr->claim_batch_msec = batch_msec;
+}
+
+/* Returns true if the claims of the interfaces in OIF_CLAIMED must still be
+ * held back, otherwise sends their deferred Port_Binding updates, if any. */
+static bool
+if_status_mgr_hold_claims(struct if_status_mgr *mgr,
+                          struct shash *bindings,
+                          const struct sbrec_chassis *chassis_rec,
+                          const struct sbrec_port_binding_table *pb_table)
+{
+    if (!mgr->claims_deferred) {
+        return false;
+    }
+
+    if (mgr->claim_batch_msec &&
+        time_msec() < mgr->claim_batch_start + mgr->claim_batch_msec) {
+        return true;
+    }
+
+    struct hmapx_node *node;
+    HMAPX_FOR_EACH (node, &mgr->ifaces_per_state[OIF_CLAIMED]) {
+        struct ovs_iface *iface = node->data;
+        if (iface->is_vif) {
+            local_binding_set_pb(bindings, iface->id, chassis_rec, NULL,
+                                 true, iface->bind_type);
+        } else {
+            port_binding_set_pb(chassis_rec, pb_table, iface->id,
+                                &iface->pb_uuid, iface->bind_type);
+        }
+    }
+    VLOG_DBG("Sending %"PRIuSIZE" batched claims",
+             hmapx_count(&mgr->ifaces_per_state[OIF_CLAIMED]));
+    mgr->claims_deferred = false;
+    return false;
 }
 
 bool
@@ -377,6 +500,19 @@ if_status_mgr_iface_is_present(struct if_status_mgr *mgr, const char *iface_id)
     return !!shash_find_data(&mgr->ifaces, iface_id);
 }
 
+/* Returns true if 'iface_id' was claimed but its Port_Binding update is held
+ * until the current claim batch is sent. */
+bool
+if_status_mgr_claim_is_held(struct if_status_mgr *mgr, const char *iface_id)
+{
+    if (!mgr->claims_deferred) {
+        return false;
+    }
+
+    struct ovs_iface *iface = shash_find_data(&mgr->ifaces, iface_id);
+    return iface && iface->state == OIF_CLAIMED;
+}
+
 bool
 if_status_reclaimed(struct if_status_mgr *mgr, const char *iface_id)
 {
@@ -475,7 +611,9 @@ if_status_handle_claims(struct if_status_mgr *mgr,
                         struct hmap *tracked_datapath,
                         const struct sbrec_port_binding_table *pb_table)
 {
-    if (!binding_data) {
+    /* Deferred claims are sent by if_status_mgr_update() when the batch
+     * expires. */
+    if (!binding_data || mgr->claims_deferred) {
         return false;
     }
 
@@ -640,11 +778,13 @@ if_status_mgr_update(struct if_status_mgr *mgr,
     /* Move newly claimed interfaces from OIF_CLAIMED to OIF_WAITING_SB_COND.
      */
     bool new_ifaces = false;
-    if (!sb_readonly) {
+    if (!sb_readonly && !if_status_mgr_hold_claims(mgr, bindings,
+                                                   chassis_rec, pb_table)) {
         HMAPX_FOR_EACH_SAFE (node, &mgr->ifaces_per_state[OIF_CLAIMED]) {
             struct ovs_iface *iface = node->data;
             /* No need to update pb->chassis as already done
-             * in if_status_handle_claims or if_status_mgr_claim_iface
+             * in if_status_handle_claims, if_status_mgr_claim_iface or
+             * if_status_mgr_hold_claims.
              */
             if (iface->is_vif) {
                 ovs_iface_set_state(mgr, iface, OIF_WAITING_SB_COND);
@@ -652,7 +792,7 @@ if_status_mgr_update(struct if_status_mgr *mgr,
                 ovs_iface_set_state(mgr, iface, OIF_MARK_UP);
             }
         }
-    } else {
+    } else if (sb_readonly) {
         HMAPX_FOR_EACH_SAFE (node, &mgr->ifaces_per_state[OIF_CLAIMED]) {
             struct ovs_iface *iface = node->data;
             static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(5, 1);
@@ -717,6 +857,14 @@ if_status_mgr_update(struct if_status_mgr *mgr,
     }
 }
 
+void
+if_status_mgr_wait(struct if_status_mgr *mgr)
+{
+    if (mgr->claims_deferred && mgr->claim_batch_msec) {
+        poll_timer_wait_until(mgr->claim_batch_start + mgr->claim_batch_msec);
+    }
+}
+
 void
 if_status_mgr_remove_ovn_installed(struct if_status_mgr *mgr,
                                    const struct ovsrec_interface *iface_rec)
@@ -894,6 +1042,79 @@ ovn_uninstall_hash_destroy(struct if_status_mgr *mgr, struct shash_node *node)
     free(node_name);
 }
 
+static void
+if_latency_record(struct if_latency_stats *stats, long long int msec)
+{
+    uint64_t sample = MAX(msec, 0);
+    size_t i;
+
+    for (i = 0; i < ARRAY_SIZE(if_latency_bounds_ms); i++) {
+        if (sample <= if_latency_bounds_ms[i]) {
+            break;
+        }
+    }
+    stats->buckets[i]++;
+    stats->n_samples++;
+    stats->total_msec += sample;
+    stats->max_msec = MAX(stats->max_msec, sample);
+}
+
+static bool
+if_state_is_bringup(enum if_state state)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(if_bringup_states); i++) {
+        if (if_bringup_states[i] == state) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Accounts the time 'iface' spent in its current state, 'now' being the
+ * time at which it moves to 'state'. */
+static void
+ovs_iface_trace_state(struct if_status_mgr *mgr, struct ovs_iface *iface,
+                      enum if_state state, long long int now)
+{
+    bool in_bringup = iface->claim_msec && !iface->installed_msec;
+
+    if (in_bringup) {
+        iface->time_in_state[iface->state] += now - iface->state_msec;
+    }
+    iface->state_msec = now;
+
+    if (state == OIF_CLAIMED) {
+        memset(iface->time_in_state, 0, sizeof iface->time_in_state);
+        memset(iface->state_entry_msec, 0, sizeof iface->state_entry_msec);
+        iface->state_entry_msec[state] = now;
+        iface->claim_msec = now;
+        iface->installed_msec = 0;
+    } else if (!in_bringup) {
+        return;
+    } else if (if_state_is_bringup(state)) {
+        if (!iface->state_entry_msec[state]) {
+            iface->state_entry_msec[state] = now;
+        }
+    } else if (state == OIF_INSTALLED) {
+        iface->installed_msec = now;
+        if_latency_record(&mgr->bringup_latency, now - iface->claim_msec);
+        /* States the interface skipped, e.g., REM_OLD_OVN_INST when it
+         * had no stale ovn-installed, are not accounted. */
+        for (size_t i = 0; i < ARRAY_SIZE(if_bringup_states); i++) {
+            enum if_state s = if_bringup_states[i];
+            if (iface->state_entry_msec[s]) {
+                if_latency_record(&mgr->state_latency[s],
+                                  iface->time_in_state[s]);
+            }
+        }
+        VLOG_DBG("Interface %s installed %lldms after being claimed",
+                 iface->id, now - iface->claim_msec);
+    } else {
+        iface->claim_msec = 0;
+        mgr->n_aborted_bringups++;
+    }
+}
+
 static void
 ovs_iface_set_state(struct if_status_mgr *mgr, struct ovs_iface *iface,
                     enum if_state state)
@@ -902,6 +1123,7 @@ ovs_iface_set_state(struct if_status_mgr *mgr, struct ovs_iface *iface,
              if_state_names[iface->state],
              if_state_names[state]);
 
+    ovs_iface_trace_state(mgr, iface, state, time_msec());
     hmapx_find_and_delete(&mgr->ifaces_per_state[iface->state], iface);
     iface->state = state;
     hmapx_add(&mgr->ifaces_per_state[iface->state], iface);
@@ -1006,3 +1228,91 @@ if_status_is_port_claimed(const struct if_status_mgr *mgr,
     }
 }
 
+
+static void
+if_latency_format(struct ds *s, const struct if_latency_stats *stats)
+{
+    ds_put_format(s, "samples: %"PRIu64", avg: %"PRIu64"ms, "
+                  "max: %"PRIu64"ms\n", stats->n_samples,
+                  stats->n_samples ? stats->total_msec / stats->n_samples : 0,
+                  stats->max_msec);
+    if (!stats->n_samples) {
+        return;
+    }
+
+    ds_put_cstr(s, "    histogram (ms):");
+    for (size_t i = 0; i < IF_LATENCY_N_BUCKETS; i++) {
+        if (i < ARRAY_SIZE(if_latency_bounds_ms)) {
+            ds_put_format(s, " <=%"PRIu64": %"PRIu64,
+                          if_latency_bounds_ms[i], stats->buckets[i]);
+        } else {
+            ds_put_format(s, " >%"PRIu64": %"PRIu64,
+                          if_latency_bounds_ms[i - 1], stats->buckets[i]);
+        }
+    }
+    ds_put_char(s, '\n');
+}
+
+/* Formats into 's' the latency histograms of the interfaces that completed
+ * their bring-up, i.e., went from being claimed to OIF_INSTALLED, as a whole
+ * and for each of the states they went through. */
+void
+if_status_mgr_format_latency(const struct if_status_mgr *mgr, struct ds *s)
+{
+    ds_put_format(s, "Aborted bring-ups: %"PRIu64"\n",
+                  mgr->n_aborted_bringups);
+    ds_put_cstr(s, "Claimed to installed: ");
+    if_latency_format(s, &mgr->bringup_latency);
+    for (size_t i = 0; i < ARRAY_SIZE(if_bringup_states); i++) {
+        enum if_state state = if_bringup_states[i];
+        ds_put_format(s, "- %s: ", if_state_names[state]);
+        if_latency_format(s, &mgr->state_latency[state]);
+    }
+}
+
+void
+if_status_mgr_clear_latency(struct if_status_mgr *mgr)
+{
+    memset(&mgr->bringup_latency, 0, sizeof mgr->bringup_latency);
+    memset(mgr->state_latency, 0, sizeof mgr->state_latency);
+    mgr->n_aborted_bringups = 0;
+}
+
+/* Formats into 's' the state of every interface, with the time spent in
+ * each state of its last bring-up, in milliseconds. */
+void
+if_status_mgr_dump_ifaces(const struct if_status_mgr *mgr, struct ds *s)
+{
+    const struct shash_node **nodes = shash_sort(&mgr->ifaces);
+    long long int now = time_msec();
+
+    for (size_t i = 0; i < shash_count(&mgr->ifaces); i++) {
+        const struct ovs_iface *iface = nodes[i]->data;
+
+        ds_put_format(s, "%s: name %s, state %s for %lldms", iface->id,
+                      iface->name ? iface->name : "<none>",
+                      if_state_names[iface->state], now - iface->state_msec);
+        if (!iface->claim_msec) {
+            ds_put_char(s, '\n');
+            continue;
+        }
+
+        bool in_bringup = !iface->installed_msec;
+        for (size_t j = 0; j < ARRAY_SIZE(if_bringup_states); j++) {
+            enum if_state state = if_bringup_states[j];
+            long long int msec = iface->time_in_state[state];
+            if (in_bringup && state == iface->state) {
+                msec += now - iface->state_msec;
+            }
+            ds_put_format(s, ", %s %lldms", if_state_names[state], msec);
+        }
+        if (in_bringup) {
+            ds_put_format(s, ", claimed %lldms ago\n",
+                          now - iface->claim_msec);
+        } else {
+            ds_put_format(s, ", installed in %lldms\n",
+                          iface->installed_msec - iface->claim_msec);
+        }
+    }
+    free(nodes);
+}
@@ -23,6 +23,7 @@
 #include "binding.h"
 #include "lport.h"
 
+struct ds;
 struct if_status_mgr;
 struct simap;
 
@@ -36,6 +37,8 @@ void if_status_mgr_claim_iface(struct if_status_mgr *,
                                bool sb_readonly, enum can_bind bind_type,
                                bool notify_up,
                                const struct sbrec_port_binding *parent_pb);
+void if_status_mgr_set_claim_batch_msec(struct if_status_mgr *,
+                                        unsigned int batch_msec);
 void if_status_mgr_release_iface(struct if_status_mgr *, const char *iface_id);
 void if_status_mgr_delete_iface(struct if_status_mgr *, const char *iface_id,
                                 const struct ovsrec_interface *iface_rec);
@@ -53,10 +56,16 @@ void if_status_mgr_run(struct if_status_mgr *mgr, struct local_binding_data *,
                        const struct ovsrec_interface_table *iface_table,
                        const struct sbrec_port_binding_table *pb_table,
                        bool sb_readonly, bool ovs_readonly);
+void if_status_mgr_wait(struct if_status_mgr *);
 void if_status_mgr_get_memory_usage(struct if_status_mgr *mgr,
                                     struct simap *usage);
+void if_status_mgr_format_latency(const struct if_status_mgr *, struct ds *);
+void if_status_mgr_clear_latency(struct if_status_mgr *);
+void if_status_mgr_dump_ifaces(const struct if_status_mgr *, struct ds *);
 bool if_status_mgr_iface_is_present(struct if_status_mgr *mgr,
                                     const char *iface_id);
+bool if_status_mgr_claim_is_held(struct if_status_mgr *mgr,
+                                 const char *iface_id);
 bool if_status_handle_claims(struct if_status_mgr *mgr,
                              struct local_binding_data *binding_data,
                              const struct sbrec_chassis *chassis_rec,
@@ -18,6 +18,7 @@
 #include "lflow.h"
 #include "coverage.h"
 #include "ha-chassis.h"
+#include "hash.h"
 #include "lb.h"
 #include "lflow-cache.h"
 #include "local_data.h"
@@ -45,6 +46,9 @@ VLOG_DEFINE_THIS_MODULE(lflow);
 
 COVERAGE_DEFINE(lflow_run);
 COVERAGE_DEFINE(consider_logical_flow);
+COVERAGE_DEFINE(lflow_actions_cache_hit);
+COVERAGE_DEFINE(lflow_actions_cache_miss);
+COVERAGE_DEFINE(lflow_actions_cache_evict);
 
 /* Symbol table. */
 
@@ -59,11 +63,54 @@ static struct shash symtab;
  */
 static struct shash acl_ct_symtab;
 
+/* Actions cache.
+ *
+ * Most logical flows share a handful of action strings, e.g. "next;",
+ * "output;", "drop;", "ct_next;" or register loads of constants, and their
+ * OpenFlow encoding is the same for every logical flow and datapath.  For
+ * such actions (see ovnacts_encode_is_context_free()) the prerequisites and
+ * the encoded OpenFlow actions are cached, keyed by the template-expanded
+ * actions string and by the parameters their parsing and encoding depend on,
+ * so that they are parsed and encoded only once.
+ *
+ * Cached actions never refer to ports, groups or meters, so entries don't
+ * need to be invalidated when those change. */
+struct lflow_actions_cache_node {
+    struct hmap_node hmap_node;
+    struct ovs_list lru_node;   /* In 'lflow_actions_cache_lru'. */
+    char *actions;              /* Template-expanded actions. */
+    bool ingress;
+    uint8_t table_id;
+    bool is_switch;
+    struct expr *prereqs;       /* Prerequisites, may be NULL. */
+    struct ofpbuf ofpacts;      /* Encoded OpenFlow actions. */
+};
+
+static struct hmap lflow_actions_cache =
+    HMAP_INITIALIZER(&lflow_actions_cache);
+
+/* Cache entries, the most recently used first.  When the cache is full, the
+ * least recently used entry is evicted, which also drops the entries of
+ * action strings that are not used anymore. */
+static struct ovs_list lflow_actions_cache_lru =
+    OVS_LIST_INITIALIZER(&lflow_actions_cache_lru);
+
+/* Maximum number of cached action strings, 0 disables the cache. */
+static size_t lflow_actions_cache_max = LFLOW_ACTIONS_CACHE_DEF_MAX;
+
+/* Memo of normalized subexpressions, mostly address set expansions, shared by
+ * the logical flows that refer to the same address sets. */
+#define LFLOW_EXPR_MEMO_MAX_SIZE (32 * 1024 * 1024)
+static struct expr_memo *expr_memo;
+
 void
 lflow_init(void)
 {
     ovn_init_symtab(&symtab);
+    expr_symtab_freeze(&symtab);
     ovn_init_acl_ct_symtab(&acl_ct_symtab);
+    expr_symtab_freeze(&acl_ct_symtab);
+    expr_memo = expr_memo_create(LFLOW_EXPR_MEMO_MAX_SIZE);
 }
 
 struct lookup_port_aux {
@@ -100,6 +147,7 @@ add_matches_to_flow_table(const struct sbrec_logical_flow *,
                           const struct local_datapath *,
                           struct hmap *matches, uint8_t ptable,
                           uint8_t output_ptable, struct ofpbuf *ovnacts,
+                          const struct ofpbuf *cached_ofpacts,
                           bool ingress, struct lflow_ctx_in *,
                           struct lflow_ctx_out *);
 static void
@@ -189,6 +237,12 @@ tunnel_ofport_cb(const void *aux_, const char *port_name, ofp_port_t *ofport)
         return false;
     }
 
+    /* Store the chassis whose tunnel was looked up to lflow reference, so
+     * that in the future when the tunnels to that chassis change the logical
+     * flow can be reprocessed. */
+    objdep_mgr_add(aux->deps_mgr, OBJDEP_TYPE_CHASSIS, pb->chassis->name,
+                   &aux->lflow->header_.uuid);
+
     if (!get_chassis_tunnel_ofport(aux->chassis_tunnels, pb->chassis->name,
                                    ofport)) {
         return false;
@@ -363,12 +417,126 @@ store_lflow_template_refs(struct objdep_mgr *lflow_deps_mgr,
     }
 }
 
+static uint32_t
+lflow_actions_cache_hash(const char *actions, bool ingress, uint8_t table_id,
+                         bool is_switch)
+{
+    uint32_t hash = hash_string(actions, 0);
+    hash = hash_int(table_id, hash);
+    return hash_int((ingress << 1) | is_switch, hash);
+}
+
+static struct lflow_actions_cache_node *
+lflow_actions_cache_find(const char *actions, bool ingress, uint8_t table_id,
+                         bool is_switch, uint32_t hash)
+{
+    struct lflow_actions_cache_node *node;
+    HMAP_FOR_EACH_WITH_HASH (node, hmap_node, hash, &lflow_actions_cache) {
+        if (node->ingress == ingress && node->table_id == table_id
+            && node->is_switch == is_switch
+            && !strcmp(node->actions, actions)) {
+            return node;
+        }
+    }
+    return NULL;
+}
+
+static void
+lflow_actions_cache_delete(struct lflow_actions_cache_node *node)
+{
+    hmap_remove(&lflow_actions_cache, &node->hmap_node);
+    ovs_list_remove(&node->lru_node);
+    free(node->actions);
+    expr_destroy(node->prereqs);
+    ofpbuf_uninit(&node->ofpacts);
+    free(node);
+}
+
+/* Evicts the least recently used entries until the cache has room for
+ * 'n_free' more entries. */
+static void
+lflow_actions_cache_evict(size_t n_free)
+{
+    while (!ovs_list_is_empty(&lflow_actions_cache_lru)
+           && hmap_count(&lflow_actions_cache) + n_free
+              > lflow_actions_cache_max) {
+        struct lflow_actions_cache_node *node =
+            CONTAINER_OF(ovs_list_back(&lflow_actions_cache_lru),
+                         struct lflow_actions_cache_node, lru_node);
+        lflow_actions_cache_delete(node);
+        COVERAGE_INC(lflow_actions_cache_evict);
+    }
+}
+
+/* Sets the maximum number of entries of the actions cache to 'max', 0 to
+ * disable the cache. */
+void
+lflow_actions_cache_set_limit(unsigned int max)
+{
+    if (max != lflow_actions_cache_max) {
+        lflow_actions_cache_max = max;
+        lflow_actions_cache_evict(0);
+    }
+}
+
+/* Encodes 'ovnacts', whose encoding must not depend on the logical flow or
+ * datapath, and caches the result together with a copy of 'prereqs'. */
+static struct lflow_actions_cache_node *
+lflow_actions_cache_add(const char *actions, bool ingress, uint8_t table_id,
+                        bool is_switch, uint32_t hash,
+                        const struct ofpbuf *ovnacts, struct expr *prereqs)
+{
+    lflow_actions_cache_evict(1);
+
+    struct lflow_actions_cache_node *node = xmalloc(sizeof *node);
+    node->actions = xstrdup(actions);
+    node->ingress = ingress;
+    node->table_id = table_id;
+    node->is_switch = is_switch;
+    node->prereqs = prereqs ? expr_clone(prereqs) : NULL;
+    ofpbuf_init(&node->ofpacts, 0);
+
+    /* These are the only encoding parameters context free actions use. */
+    struct ovnact_encode_params ep = {
+        .is_switch = is_switch,
+        .pipeline = ingress ? OVNACT_P_INGRESS : OVNACT_P_EGRESS,
+        .ingress_ptable = OFTABLE_LOG_INGRESS_PIPELINE,
+        .egress_ptable = OFTABLE_LOG_EGRESS_PIPELINE,
+        .output_ptable = ingress ? OFTABLE_OUTPUT_INIT : OFTABLE_SAVE_INPORT,
+    };
+    ovnacts_encode(ovnacts->data, ovnacts->size, &ep, &node->ofpacts);
+
+    hmap_insert(&lflow_actions_cache, &node->hmap_node, hash);
+    ovs_list_push_front(&lflow_actions_cache_lru, &node->lru_node);
+    return node;
+}
+
+static void
+lflow_actions_cache_flush(void)
+{
+    struct lflow_actions_cache_node *node;
+    HMAP_FOR_EACH_SAFE (node, hmap_node, &lflow_actions_cache) {
+        lflow_actions_cache_delete(node);
+    }
+}
+
+/* Parses the actions of 'lflow' into 'ovnacts_out' and their prerequisites
+ * into '*prereqs_out'.
+ *
+ * If 'ldp' is nonnull, the actions cache is used for the datapath 'ldp' and,
+ * if the encoding of the actions doesn't depend on the logical flow or
+ * datapath, '*ofpacts_out' is set to the cached OpenFlow encoding of the
+ * actions, which the caller must not modify.  On a cache hit, 'ovnacts_out'
+ * is left empty.  Otherwise '*ofpacts_out' is set to NULL and the caller
+ * needs to encode 'ovnacts_out' itself. */
 static bool
 lflow_parse_actions(const struct sbrec_logical_flow *lflow,
                     const struct lflow_ctx_in *l_ctx_in,
+                    const struct local_datapath *ldp,
                     struct sset *template_vars_ref,
                     struct ofpbuf *ovnacts_out,
-                    struct expr **prereqs_out)
+                    struct expr **prereqs_out,
+                    const struct ofpbuf **ofpacts_out)
 {
     bool ingress = !strcmp(lflow->pipeline, "ingress");
     struct ovnact_parse_params pp = {
@@ -385,6 +553,10 @@ lflow_parse_actions(const struct sbrec_logical_flow *lflow,
         .cur_ltable = lflow->table_id,
     };
 
+    if (ofpacts_out) {
+        *ofpacts_out = NULL;
+    }
+
     struct lex_str actions_s;
     if (!lexer_parse_template_string(&actions_s, lflow->actions,
                                      l_ctx_in->template_vars,
@@ -395,16 +567,47 @@ lflow_parse_actions(const struct sbrec_logical_flow *lflow,
         return false;
     }
 
-    char *error = ovnacts_parse_string(lex_str_get(&actions_s), &pp,
-                                       ovnacts_out, prereqs_out);
-    lex_str_free(&actions_s);
+    const char *actions = lex_str_get(&actions_s);
+    uint32_t hash = 0;
+    if (ldp) {
+        hash = lflow_actions_cache_hash(actions, ingress, lflow->table_id,
+                                        ldp->is_switch);
+        struct lflow_actions_cache_node *node =
+            lflow_actions_cache_find(actions, ingress, lflow->table_id,
+                                     ldp->is_switch, hash);
+        if (node) {
+            COVERAGE_INC(lflow_actions_cache_hit);
+            ovs_list_remove(&node->lru_node);
+            ovs_list_push_front(&lflow_actions_cache_lru, &node->lru_node);
+            *prereqs_out = node->prereqs ? expr_clone(node->prereqs) : NULL;
+            *ofpacts_out = &node->ofpacts;
+            lex_str_free(&actions_s);
+            return true;
+        }
+    }
+
+    char *error = ovnacts_parse_string(actions, &pp, ovnacts_out,
+                                       prereqs_out);
     if (error) {
         static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 1);
         VLOG_WARN_RL(&rl, "error parsing actions \"%s\": %s",
                      lflow->actions, error);
         free(error);
+        lex_str_free(&actions_s);
         return false;
     }
+
+    if (ldp && lflow_actions_cache_max
+        && ovnacts_encode_is_context_free(ovnacts_out->data,
+                                          ovnacts_out->size)) {
+        COVERAGE_INC(lflow_actions_cache_miss);
+        struct lflow_actions_cache_node *node =
+            lflow_actions_cache_add(actions, ingress, lflow->table_id,
+                                    ldp->is_switch, hash, ovnacts_out,
+                                    *prereqs_out);
+        *ofpacts_out = &node->ofpacts;
+    }
+    lex_str_free(&actions_s);
     return true;
 }
 
@@ -461,8 +664,10 @@ consider_lflow_for_added_as_ips__(
     struct sset template_vars_ref = SSET_INITIALIZER(&template_vars_ref);
     struct expr *prereqs = NULL;
 
-    if (!lflow_parse_actions(lflow, l_ctx_in, &template_vars_ref,
-                             &ovnacts, &prereqs)) {
+    const struct ofpbuf *cached_ofpacts;
+
+    if (!lflow_parse_actions(lflow, l_ctx_in, ldp, &template_vars_ref,
+                             &ovnacts, &prereqs, &cached_ofpacts)) {
         ovnacts_free(ovnacts.data, ovnacts.size);
         ofpbuf_uninit(&ovnacts);
         store_lflow_template_refs(l_ctx_out->lflow_deps_mgr,
@@ -601,7 +806,8 @@ consider_lflow_for_added_as_ips__(
         expr_matches_prepare(&matches, start_conj_id - 1);
     }
     add_matches_to_flow_table(lflow, ldp, &matches, ptable, output_ptable,
-                              &ovnacts, ingress, l_ctx_in, l_ctx_out);
+                              &ovnacts, cached_ofpacts, ingress, l_ctx_in,
+                              l_ctx_out);
 done:
     expr_destroy(prereqs);
     ovnacts_free(ovnacts.data, ovnacts.size);
@@ -748,9 +954,9 @@ lflow_handle_addr_set_update(const char *as_name,
     *changed = false;
 
     bool ret = true;
-    struct object_to_resources_list_node *resource_list_node;
-    RESOURCE_FOR_EACH_OBJ (resource_list_node, resource_node) {
-        const struct uuid *obj_uuid = &resource_list_node->obj_uuid;
+    struct objdep_obj_ref *obj_ref;
+    RESOURCE_FOR_EACH_OBJ (obj_ref, resource_node) {
+        const struct uuid *obj_uuid = &obj_ref->obj_node->obj_uuid;
         if (uuidset_find(l_ctx_out->objs_processed, obj_uuid)) {
             VLOG_DBG("lflow "UUID_FMT"has been processed, skip.",
                      UUID_ARGS(obj_uuid));
@@ -778,7 +984,7 @@ lflow_handle_addr_set_update(const char *as_name,
                 }
                 if (!ofctrl_remove_flows_for_as_ip(
                         l_ctx_out->flow_table, obj_uuid, &as_info,
-                        resource_list_node->ref_count)) {
+                        obj_ref->ref_count)) {
                     ret = false;
                     goto done;
                 }
@@ -787,7 +993,7 @@ lflow_handle_addr_set_update(const char *as_name,
 
         if (as_diff->added) {
             if (!consider_lflow_for_added_as_ips(lflow, as_name,
-                                                 resource_list_node->ref_count,
+                                                 obj_ref->ref_count,
                                                  as_diff->added,
                                                  l_ctx_in, l_ctx_out)) {
                 ret = false;
@@ -891,6 +1097,7 @@ add_matches_to_flow_table(const struct sbrec_logical_flow *lflow,
                           const struct local_datapath *ldp,
                           struct hmap *matches, uint8_t ptable,
                           uint8_t output_ptable, struct ofpbuf *ovnacts,
+                          const struct ofpbuf *cached_ofpacts,
                           bool ingress, struct lflow_ctx_in *l_ctx_in,
                           struct lflow_ctx_out *l_ctx_out)
 {
@@ -953,7 +1160,11 @@ add_matches_to_flow_table(const struct sbrec_logical_flow *lflow,
         .ctrl_meter_id = ctrl_meter_id,
         .common_nat_ct_zone = get_common_nat_zone(ldp),
     };
-    ovnacts_encode(ovnacts->data, ovnacts->size, &ep, &ofpacts);
+    if (cached_ofpacts) {
+        ofpbuf_put(&ofpacts, cached_ofpacts->data, cached_ofpacts->size);
+    } else {
+        ovnacts_encode(ovnacts->data, ovnacts->size, &ep, &ofpacts);
+    }
 
     struct expr_match *m;
     HMAP_FOR_EACH (m, hmap_node, matches) {
@@ -1130,8 +1341,10 @@ consider_logical_flow__(const struct sbrec_logical_flow *lflow,
     struct sset template_vars_ref = SSET_INITIALIZER(&template_vars_ref);
     struct expr *prereqs = NULL;
 
-    if (!lflow_parse_actions(lflow, l_ctx_in, &template_vars_ref,
-                             &ovnacts, &prereqs)) {
+    const struct ofpbuf *cached_ofpacts;
+
+    if (!lflow_parse_actions(lflow, l_ctx_in, ldp, &template_vars_ref,
+                             &ovnacts, &prereqs, &cached_ofpacts)) {
         ovnacts_free(ovnacts.data, ovnacts.size);
         ofpbuf_uninit(&ovnacts);
         store_lflow_template_refs(l_ctx_out->lflow_deps_mgr,
@@ -1219,7 +1432,7 @@ consider_logical_flow__(const struct sbrec_logical_flow *lflow,
     case LCACHE_T_EXPR:
         expr = expr_evaluate_condition(expr, is_chassis_resident_cb,
                                        &cond_aux);
-        expr = expr_normalize(expr);
+        expr = expr_normalize_memo(expr, expr_memo);
         break;
     case LCACHE_T_MATCHES:
         break;
@@ -1256,7 +1469,8 @@ consider_logical_flow__(const struct sbrec_logical_flow *lflow,
     }
 
     add_matches_to_flow_table(lflow, ldp, matches, ptable, output_ptable,
-                              &ovnacts, ingress, l_ctx_in, l_ctx_out);
+                              &ovnacts, cached_ofpacts, ingress, l_ctx_in,
+                              l_ctx_out);
 
     /* Update cache if needed. */
     switch (lcv_type) {
@@ -2050,6 +2264,10 @@ lflow_run(struct lflow_ctx_in *l_ctx_in, struct lflow_ctx_out *l_ctx_out)
 {
     COVERAGE_INC(lflow_run);
 
+    /* Drop the memoized expressions of address sets that may not exist
+     * anymore, they are rebuilt as the logical flows are processed. */
+    expr_memo_clear(expr_memo);
+
     add_logical_flows(l_ctx_in, l_ctx_out);
     add_neighbor_flows(l_ctx_in->sbrec_port_binding_by_name,
                        l_ctx_in->mac_binding_table,
@@ -2088,6 +2306,9 @@ lflow_handle_cached_flows(struct lflow_cache *lc,
 void
 lflow_destroy(void)
 {
+    lflow_actions_cache_flush();
+    expr_memo_destroy(expr_memo);
+    expr_memo = NULL;
     expr_symtab_destroy(&symtab);
     shash_destroy(&symtab);
     expr_symtab_destroy(&acl_ct_symtab);
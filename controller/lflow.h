@@ -156,7 +156,11 @@ struct lflow_ctx_out {
     struct uuidset *objs_processed;
 };
 
+/* Default maximum number of entries of the encoded actions cache. */
+#define LFLOW_ACTIONS_CACHE_DEF_MAX 4096
+
 void lflow_init(void);
+void lflow_actions_cache_set_limit(unsigned int max);
 void lflow_run(struct lflow_ctx_in *, struct lflow_ctx_out *);
 void lflow_handle_cached_flows(struct lflow_cache *,
                                const struct sbrec_logical_flow_table *);
@@ -19,6 +19,7 @@
 #include "include/openvswitch/json.h"
 #include "lib/hmapx.h"
 #include "lib/flow.h"
+#include "lib/sset.h"
 #include "lib/util.h"
 #include "lib/vswitch-idl.h"
 #include "openvswitch/vlog.h"
@@ -592,6 +593,58 @@ chassis_tunnels_destroy(struct hmap *chassis_tunnels)
     hmap_destroy(chassis_tunnels);
 }
 
+static bool
+chassis_tunnel_equal(const struct chassis_tunnel *a,
+                     const struct chassis_tunnel *b)
+{
+    return !strcmp(a->chassis_id, b->chassis_id)
+           && a->ofport == b->ofport
+           && a->type == b->type
+           && a->is_ipv6 == b->is_ipv6
+           && a->is_ramp_tunnel == b->is_ramp_tunnel;
+}
+
+static bool
+chassis_tunnels_contains(const struct hmap *chassis_tunnels,
+                         const struct chassis_tunnel *tun)
+{
+    const struct chassis_tunnel *other;
+    HMAP_FOR_EACH_WITH_HASH (other, hmap_node, tun->hmap_node.hash,
+                             chassis_tunnels) {
+        if (chassis_tunnel_equal(tun, other)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void
+chassis_tunnels_add_missing(const struct hmap *a, const struct hmap *b,
+                            struct sset *changed_chassis)
+{
+    const struct chassis_tunnel *tun;
+    HMAP_FOR_EACH (tun, hmap_node, a) {
+        if (chassis_tunnels_contains(b, tun)) {
+            continue;
+        }
+
+        char *chassis_name = NULL;
+        if (encaps_tunnel_id_parse(tun->chassis_id, &chassis_name,
+                                   NULL, NULL)) {
+            sset_add_and_free(changed_chassis, chassis_name);
+        }
+    }
+}
+
+/* Adds to 'changed_chassis' the names of the chassis whose tunnels were
+ * added, removed or updated between 'old' and 'new'. */
+void
+chassis_tunnels_diff(const struct hmap *old, const struct hmap *new,
+                     struct sset *changed_chassis)
+{
+    chassis_tunnels_add_missing(old, new, changed_chassis);
+    chassis_tunnels_add_missing(new, old, changed_chassis);
+}
 
 /*
  * This function looks up the list of tunnel ports (provided by
@@ -790,6 +843,20 @@ flow_based_tunnels_destroy(struct flow_based_tunnel *flow_tunnels)
     }
 }
 
+bool
+flow_based_tunnels_equal(const struct flow_based_tunnel *a,
+                         const struct flow_based_tunnel *b)
+{
+    for (size_t i = 0; i < TUNNEL_TYPE_MAX; i++) {
+        if (a[i].ofport != b[i].ofport
+            || a[i].is_ipv6 != b[i].is_ipv6
+            || !nullable_string_is_equal(a[i].port_name, b[i].port_name)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 ofp_port_t
 get_flow_based_tunnel_port(enum chassis_tunnel_type type,
                            const struct flow_based_tunnel *flow_tunnels)
@@ -33,6 +33,7 @@ struct ovsdb_idl_index;
 struct ovsrec_bridge;
 struct ovsrec_interface_table;
 struct sbrec_load_balancer;
+struct sset;
 
 struct peer_ports {
     const struct sbrec_port_binding *local;
@@ -178,10 +179,14 @@ bool get_chassis_tunnel_ofport(const struct hmap *chassis_tunnels,
                                ofp_port_t *ofport);
 
 void chassis_tunnels_destroy(struct hmap *chassis_tunnels);
+void chassis_tunnels_diff(const struct hmap *old, const struct hmap *new,
+                          struct sset *changed_chassis);
 
 /* Flow-based tunnel management functions. */
 void flow_based_tunnels_init(struct flow_based_tunnel *);
 void flow_based_tunnels_destroy(struct flow_based_tunnel *);
+bool flow_based_tunnels_equal(const struct flow_based_tunnel *a,
+                              const struct flow_based_tunnel *b);
 ofp_port_t get_flow_based_tunnel_port(
     enum chassis_tunnel_type, const struct flow_based_tunnel *);
 
@@ -27,6 +27,7 @@
 #include "ovn/logical-fields.h"
 #include "ovn-sb-idl.h"
 #include "pinctrl.h"
+#include "simap.h"
 
 VLOG_DEFINE_THIS_MODULE(mac_cache);
 
@@ -34,6 +35,9 @@ VLOG_DEFINE_THIS_MODULE(mac_cache);
 #define BUFFER_QUEUE_DEPTH          4
 #define BUFFERED_PACKETS_TIMEOUT_MS 10000
 #define BUFFERED_PACKETS_LOOKUP_MS  100
+/* Packets up to this size are stored in recycled pool buffers. */
+#define BP_POOL_BUF_SIZE            2048
+#define BP_POOL_MAX_FREE            256
 
 static uint32_t
 mac_binding_data_hash(const struct mac_binding_data *mb_data);
@@ -543,18 +547,284 @@ fdb_stats_run(struct vector *stats_vec, uint64_t *req_delay, void *data)
 
 /* Packet buffering. */
 void
-bp_packet_data_destroy(struct bp_packet_data *pd) {
-    free(pd->pin.packet);
+buffered_packets_ctx_init(struct buffered_packets_ctx *ctx)
+{
+    cmap_init(&ctx->map);
+    hmap_init(&ctx->dp_usage);
+    ctx->pool = VECTOR_EMPTY_INITIALIZER(void *);
+    ctx->n_bytes = 0;
+    ctx->n_busy_dps = 0;
+    atomic_init(&ctx->usage_bytes, 0);
+    atomic_init(&ctx->n_packets, 0);
+    atomic_init(&ctx->n_evicted, 0);
+    atomic_init(&ctx->max_bytes, BUFFERED_PACKETS_DEF_MAX_KB * 1024);
+}
+
+/* Must be called only once the handler thread doesn't access 'ctx'
+ * anymore. */
+void
+buffered_packets_ctx_destroy(struct buffered_packets_ctx *ctx)
+{
+    struct buffered_packets *bp;
+    CMAP_FOR_EACH (bp, cmap_node, &ctx->map) {
+        struct bp_packet_data *pd;
+        VECTOR_FOR_EACH_PTR (&bp->queue, pd) {
+            bp_packet_data_destroy(ctx, pd);
+        }
+        vector_clear(&bp->queue);
+
+        cmap_remove(&ctx->map, &bp->cmap_node,
+                    mac_binding_data_hash(&bp->mb_data));
+        ovsrcu_postpone(buffered_packets_free, bp);
+    }
+    cmap_destroy(&ctx->map);
+
+    struct bp_dp_usage *dpu;
+    HMAP_FOR_EACH_POP (dpu, hmap_node, &ctx->dp_usage) {
+        free(dpu);
+    }
+    hmap_destroy(&ctx->dp_usage);
+
+    void *buf;
+    VECTOR_FOR_EACH (&ctx->pool, buf) {
+        free(buf);
+    }
+    vector_destroy(&ctx->pool);
+}
+
+void
+buffered_packets_ctx_set_max_bytes(struct buffered_packets_ctx *ctx,
+                                   uint64_t max_bytes)
+{
+    atomic_store_relaxed(&ctx->max_bytes, max_bytes);
+}
+
+void
+buffered_packets_ctx_get_memory_usage(struct buffered_packets_ctx *ctx,
+                                      struct simap *usage)
+{
+    uint64_t usage_bytes, n_packets, n_evicted;
+
+    atomic_read_relaxed(&ctx->usage_bytes, &usage_bytes);
+    atomic_read_relaxed(&ctx->n_packets, &n_packets);
+    atomic_read_relaxed(&ctx->n_evicted, &n_evicted);
+
+    simap_increase(usage, "buffered_packets", n_packets);
+    simap_increase(usage, "buffered_packets_evicted", n_evicted);
+    simap_increase(usage, "buffered_packets_usage-KB",
+                   ROUND_UP(usage_bytes, 1024) / 1024);
+}
+
+/* Handler thread only. */
+static void *
+bp_pool_alloc(struct buffered_packets_ctx *ctx, size_t size)
+{
+    if (size > BP_POOL_BUF_SIZE) {
+        return xmalloc(size);
+    }
+
+    if (vector_is_empty(&ctx->pool)) {
+        return xmalloc(BP_POOL_BUF_SIZE);
+    }
+
+    void *buf;
+    vector_pop(&ctx->pool, &buf);
+    return buf;
+}
+
+/* Handler thread only. */
+static void
+bp_pool_free(struct buffered_packets_ctx *ctx, void *buf, size_t size)
+{
+    if (size > BP_POOL_BUF_SIZE
+        || vector_len(&ctx->pool) >= BP_POOL_MAX_FREE) {
+        free(buf);
+        return;
+    }
+    vector_push(&ctx->pool, &buf);
+}
+
+/* Returns the size of the buffer that bp_pool_alloc() hands out for a
+ * packet of 'packet_len' bytes. */
+static size_t
+bp_pool_buf_size(size_t packet_len)
+{
+    return packet_len > BP_POOL_BUF_SIZE ? packet_len : BP_POOL_BUF_SIZE;
+}
+
+static size_t
+bp_packet_data_size(const struct bp_packet_data *pd)
+{
+    return sizeof *pd + bp_pool_buf_size(pd->pin.packet_len)
+           + pd->continuation->allocated;
+}
+
+void
+bp_packet_data_destroy(struct buffered_packets_ctx *ctx,
+                       struct bp_packet_data *pd)
+{
+    bp_pool_free(ctx, pd->pin.packet, pd->pin.packet_len);
     ofpbuf_delete(pd->continuation);
 }
 
+static struct bp_dp_usage *
+bp_dp_usage_find(struct buffered_packets_ctx *ctx, uint32_t dp_key)
+{
+    struct bp_dp_usage *dpu;
+    HMAP_FOR_EACH_WITH_HASH (dpu, hmap_node, hash_int(dp_key, 0),
+                             &ctx->dp_usage) {
+        if (dpu->dp_key == dp_key) {
+            return dpu;
+        }
+    }
+    return NULL;
+}
+
+static struct bp_dp_usage *
+bp_dp_usage_get(struct buffered_packets_ctx *ctx, uint32_t dp_key)
+{
+    struct bp_dp_usage *dpu = bp_dp_usage_find(ctx, dp_key);
+    if (!dpu) {
+        dpu = xmalloc(sizeof *dpu);
+        dpu->dp_key = dp_key;
+        dpu->n_bytes = 0;
+        ovs_list_init(&dpu->bps);
+        hmap_insert(&ctx->dp_usage, &dpu->hmap_node, hash_int(dp_key, 0));
+    }
+    return dpu;
+}
+
+static void
+bp_account(struct buffered_packets_ctx *ctx, struct bp_dp_usage *dpu,
+           const struct bp_packet_data *pd, bool add)
+{
+    size_t size = bp_packet_data_size(pd);
+
+    if (add) {
+        if (!dpu->n_bytes) {
+            ctx->n_busy_dps++;
+        }
+        ctx->n_bytes += size;
+        dpu->n_bytes += size;
+    } else {
+        ctx->n_bytes -= size;
+        dpu->n_bytes -= size;
+        if (!dpu->n_bytes) {
+            ctx->n_busy_dps--;
+        }
+    }
+
+    uint64_t orig;
+    atomic_store_relaxed(&ctx->usage_bytes, ctx->n_bytes);
+    if (add) {
+        atomic_add_relaxed(&ctx->n_packets, 1, &orig);
+    } else {
+        atomic_sub_relaxed(&ctx->n_packets, 1, &orig);
+    }
+}
+
+/* Drops the oldest packet queued in 'bp'. */
+static void
+bp_drop_oldest(struct buffered_packets_ctx *ctx, struct bp_dp_usage *dpu,
+               struct buffered_packets *bp)
+{
+    struct bp_packet_data pd;
+
+    if (!vector_remove(&bp->queue, 0, &pd)) {
+        return;
+    }
+    bp_account(ctx, dpu, &pd, false);
+    bp_packet_data_destroy(ctx, &pd);
+
+    if (vector_is_empty(&bp->queue)) {
+        ovs_list_remove(&bp->list_node);
+        ovs_list_init(&bp->list_node);
+    }
+}
+
+/* Accounts all packets in 'bp' as released and detaches 'bp' from the
+ * per datapath list.  The packets themselves are left in the queue. */
+static void
+bp_release_all(struct buffered_packets_ctx *ctx, struct buffered_packets *bp)
+{
+    if (vector_is_empty(&bp->queue)) {
+        return;
+    }
+
+    struct bp_dp_usage *dpu = bp_dp_usage_find(ctx, bp->mb_data.dp_key);
+    ovs_assert(dpu);
+
+    struct bp_packet_data *pd;
+    VECTOR_FOR_EACH_PTR (&bp->queue, pd) {
+        bp_account(ctx, dpu, pd, false);
+    }
+    ovs_list_remove(&bp->list_node);
+    ovs_list_init(&bp->list_node);
+}
+
+static struct bp_dp_usage *
+bp_dp_usage_largest(struct buffered_packets_ctx *ctx)
+{
+    struct bp_dp_usage *largest = NULL;
+    struct bp_dp_usage *dpu;
+
+    HMAP_FOR_EACH (dpu, hmap_node, &ctx->dp_usage) {
+        if (!ovs_list_is_empty(&dpu->bps)
+            && (!largest || dpu->n_bytes > largest->n_bytes)) {
+            largest = dpu;
+        }
+    }
+    return largest;
+}
+
+/* Evicts buffered packets until 'size' more bytes fit in the memory budget.
+ * A datapath that is over its fair share of the budget evicts its own
+ * oldest packets, otherwise the oldest packets of the datapath that uses
+ * most memory are evicted.  The budget is shared only among the datapaths
+ * that have packets queued, including 'dpu'.  Returns false if there is no
+ * way to make enough room. */
+static bool
+bp_make_room(struct buffered_packets_ctx *ctx, struct bp_dp_usage *dpu,
+             size_t size)
+{
+    uint64_t max_bytes;
+    atomic_read_relaxed(&ctx->max_bytes, &max_bytes);
+    if (size > max_bytes) {
+        return false;
+    }
+
+    while (ctx->n_bytes + size > max_bytes) {
+        size_t n_dps = ctx->n_busy_dps + (dpu->n_bytes ? 0 : 1);
+        size_t fair_share = max_bytes / n_dps;
+        struct bp_dp_usage *victim = dpu;
+
+        if (dpu->n_bytes + size <= fair_share
+            || ovs_list_is_empty(&dpu->bps)) {
+            victim = bp_dp_usage_largest(ctx);
+        }
+        if (!victim) {
+            return false;
+        }
+
+        struct buffered_packets *oldest =
+            CONTAINER_OF(ovs_list_front(&victim->bps),
+                         struct buffered_packets, list_node);
+        bp_drop_oldest(ctx, victim, oldest);
+
+        uint64_t orig;
+        atomic_add_relaxed(&ctx->n_evicted, 1, &orig);
+    }
+    return true;
+}
+
 struct buffered_packets *
-buffered_packets_add(struct cmap *bp_map, struct mac_binding_data mb_data) {
+buffered_packets_add(struct buffered_packets_ctx *ctx,
+                     struct mac_binding_data mb_data) {
     uint32_t hash = mac_binding_data_hash(&mb_data);
 
-    struct buffered_packets *bp = buffered_packets_find(bp_map, &mb_data);
+    struct buffered_packets *bp = buffered_packets_find(&ctx->map, &mb_data);
     if (!bp) {
-        if (cmap_count(bp_map) >= MAX_BUFFERED_PACKETS) {
+        if (cmap_count(&ctx->map) >= MAX_BUFFERED_PACKETS) {
             return NULL;
         }
 
@@ -566,7 +836,8 @@ buffered_packets_add(struct cmap *bp_map, struct mac_binding_data mb_data) {
         bp->lookup_at_ms = 0;
         bp->queue = VECTOR_CAPACITY_INITIALIZER(struct bp_packet_data,
                                                 BUFFER_QUEUE_DEPTH);
-        cmap_insert(bp_map, &bp->cmap_node, hash);
+        ovs_list_init(&bp->list_node);
+        cmap_insert(&ctx->map, &bp->cmap_node, hash);
     }
 
     bp->expire_at_ms = time_msec() + BUFFERED_PACKETS_TIMEOUT_MS;
@@ -574,20 +845,26 @@ buffered_packets_add(struct cmap *bp_map, struct mac_binding_data mb_data) {
     return bp;
 }
 
-void
-buffered_packets_packet_data_enqueue(struct buffered_packets *bp,
+/* Queues a copy of 'pin' and 'continuation' in 'bp'.  Returns false if the
+ * packet was dropped because it doesn't fit in the memory budget. */
+bool
+buffered_packets_packet_data_enqueue(struct buffered_packets_ctx *ctx,
+                                     struct buffered_packets *bp,
                                      const struct ofputil_packet_in *pin,
                                      const struct ofpbuf *continuation)
 {
+    struct bp_dp_usage *dpu = bp_dp_usage_get(ctx, bp->mb_data.dp_key);
+
     if (vector_len(&bp->queue) == BUFFER_QUEUE_DEPTH) {
-        struct bp_packet_data pd;
-        vector_remove(&bp->queue, 0, &pd);
-        bp_packet_data_destroy(&pd);
+        bp_drop_oldest(ctx, dpu, bp);
     }
 
+    void *packet = bp_pool_alloc(ctx, pin->packet_len);
+    memcpy(packet, pin->packet, pin->packet_len);
+
     struct bp_packet_data pd = (struct bp_packet_data) {
         .pin = (struct ofputil_packet_in) {
-            .packet = xmemdup(pin->packet, pin->packet_len),
+            .packet = packet,
             .packet_len = pin->packet_len,
             .flow_metadata = pin->flow_metadata,
             .reason = pin->reason,
@@ -601,11 +878,23 @@ buffered_packets_packet_data_enqueue(struct buffered_packets *bp,
         .continuation = ofpbuf_clone(continuation),
     };
 
+    if (!bp_make_room(ctx, dpu, bp_packet_data_size(&pd))) {
+        bp_packet_data_destroy(ctx, &pd);
+        return false;
+    }
+
+    if (vector_is_empty(&bp->queue)) {
+        ovs_list_push_back(&dpu->bps, &bp->list_node);
+    }
     vector_push(&bp->queue, &pd);
+    bp_account(ctx, dpu, &pd, true);
+
+    return true;
 }
 
 bool
-buffered_packets_lookup_run(struct cmap *bp_map, const struct hmap *recent_mbs,
+buffered_packets_lookup_run(struct buffered_packets_ctx *ctx,
+                            const struct hmap *recent_mbs,
                             struct ovsdb_idl_index *sbrec_pb_by_key,
                             struct ovsdb_idl_index *sbrec_dp_by_key,
                             struct ovsdb_idl_index *sbrec_pb_by_name,
@@ -615,7 +904,7 @@ buffered_packets_lookup_run(struct cmap *bp_map, const struct hmap *recent_mbs,
     bool updated = false;
 
     struct buffered_packets *bp;
-    CMAP_FOR_EACH (bp, cmap_node, bp_map) {
+    CMAP_FOR_EACH (bp, cmap_node, &ctx->map) {
         uint64_t mac64;
         atomic_read(&bp->resolved_mac, &mac64);
         /* MAC for given entry was already resolved,
@@ -651,18 +940,29 @@ buffered_packets_lookup_run(struct cmap *bp_map, const struct hmap *recent_mbs,
     return updated;
 }
 
+/* Moves packets of all resolved entries into 'rpd', the caller is
+ * responsible for destroying them with bp_packet_data_destroy().
+ * Handler thread only. */
 void
-buffered_packets_run(struct cmap *bp_map, struct vector *rpd)
+buffered_packets_run(struct buffered_packets_ctx *ctx, struct vector *rpd)
 {
     long long now = time_msec();
 
     struct buffered_packets *bp;
-    CMAP_FOR_EACH (bp, cmap_node, bp_map) {
+    CMAP_FOR_EACH (bp, cmap_node, &ctx->map) {
         uint32_t hash = mac_binding_data_hash(&bp->mb_data);
 
         /* Remove expired buffered packets. */
         if (now > bp->expire_at_ms) {
-            cmap_remove(bp_map, &bp->cmap_node, hash);
+            bp_release_all(ctx, bp);
+
+            struct bp_packet_data *pd;
+            VECTOR_FOR_EACH_PTR (&bp->queue, pd) {
+                bp_packet_data_destroy(ctx, pd);
+            }
+            vector_clear(&bp->queue);
+
+            cmap_remove(&ctx->map, &bp->cmap_node, hash);
             ovsrcu_postpone(buffered_packets_free, bp);
             continue;
         }
@@ -685,25 +985,23 @@ buffered_packets_run(struct cmap *bp_map, struct vector *rpd)
             eth->eth_dst = mac;
         }
 
+        bp_release_all(ctx, bp);
         vector_push_array(rpd, vector_get_array(&bp->queue),
                           vector_len(&bp->queue));
         vector_clear(&bp->queue);
 
-        cmap_remove(bp_map, &bp->cmap_node, hash);
+        cmap_remove(&ctx->map, &bp->cmap_node, hash);
         ovsrcu_postpone(buffered_packets_free, bp);
     }
-}
 
-void
-buffered_packets_map_destroy(struct cmap *bp_map) {
-    struct buffered_packets *bp;
-    CMAP_FOR_EACH (bp, cmap_node, bp_map) {
-        cmap_remove(bp_map, &bp->cmap_node,
-                    mac_binding_data_hash(&bp->mb_data));
-        ovsrcu_postpone(buffered_packets_free, bp);
+    /* Forget datapaths that don't have any packets buffered anymore. */
+    struct bp_dp_usage *dpu;
+    HMAP_FOR_EACH_SAFE (dpu, hmap_node, &ctx->dp_usage) {
+        if (ovs_list_is_empty(&dpu->bps)) {
+            hmap_remove(&ctx->dp_usage, &dpu->hmap_node);
+            free(dpu);
+        }
     }
-
-    cmap_destroy(bp_map);
 }
 
 static uint32_t
@@ -800,13 +1098,10 @@ buffered_packets_find(struct cmap *bp_map,
     return NULL;
 }
 
+/* The queued packets are released by the handler thread before 'bp' is
+ * removed from the map, only the entry itself is freed here. */
 static void
 buffered_packets_free(struct buffered_packets *bp) {
-    struct bp_packet_data *pd;
-    VECTOR_FOR_EACH_PTR (&bp->queue, pd) {
-        bp_packet_data_destroy(pd);
-    }
-
     vector_destroy(&bp->queue);
     free(bp);
 }
@@ -20,6 +20,7 @@
 
 #include "cmap.h"
 #include "dp-packet.h"
+#include "ovs-atomic.h"
 #include "openvswitch/hmap.h"
 #include "openvswitch/list.h"
 #include "openvswitch/ofpbuf.h"
@@ -28,6 +29,7 @@
 #include "ovn-sb-idl.h"
 
 struct ovsdb_idl_index;
+struct simap;
 struct vector;
 
 struct mac_cache_data {
@@ -119,10 +121,14 @@ struct buffered_packets {
 
     struct mac_binding_data mb_data;  /* Immutable after insert. */
 
-    /* Queue of packet_data associated with this struct.
+    /* Queue of packet_data associated with this struct, oldest first.
      * Handler thread only. */
     struct vector queue;
 
+    /* In 'struct bp_dp_usage' 'bps' list while 'queue' is not empty.
+     * Handler thread only. */
+    struct ovs_list list_node;
+
     /* Timestamp in ms when the buffered packet should expire.
      * Handler thread only. */
     long long int expire_at_ms;
@@ -136,6 +142,43 @@ struct buffered_packets {
     long long int lookup_at_ms;
 };
 
+/* Default memory budget for all buffered packets. */
+#define BUFFERED_PACKETS_DEF_MAX_KB (16 * 1024)
+
+/* Per datapath accounting of buffered packets memory. */
+struct bp_dp_usage {
+    struct hmap_node hmap_node;
+    uint32_t dp_key;
+    size_t n_bytes;
+    /* 'struct buffered_packets' with non-empty queue, ordered by the time
+     * their queue became non-empty. */
+    struct ovs_list bps;
+};
+
+struct buffered_packets_ctx {
+    /* 'struct buffered_packets' by 'struct mac_binding_data'. */
+    struct cmap map;
+
+    /* 'struct bp_dp_usage' by datapath tunnel key.  Handler thread only. */
+    struct hmap dp_usage;
+    /* Recycled packet buffers of BP_POOL_BUF_SIZE bytes.
+     * Handler thread only. */
+    struct vector pool;
+    /* Total memory used by queued packets.  Handler thread only. */
+    size_t n_bytes;
+    /* Number of 'dp_usage' entries with packets queued.
+     * Handler thread only. */
+    size_t n_busy_dps;
+
+    /* Statistics, written by the handler thread. */
+    atomic_uint64_t usage_bytes;
+    atomic_uint64_t n_packets;
+    atomic_uint64_t n_evicted;
+
+    /* Memory budget for all queued packets, written by the main thread. */
+    atomic_uint64_t max_bytes;
+};
+
 /* Thresholds. */
 void mac_cache_threshold_add(struct mac_cache_data *data,
                              const struct sbrec_datapath_binding *dp);
@@ -208,26 +251,33 @@ void fdb_stats_process_flow_stats(struct vector *stats_vec,
 void fdb_stats_run(struct vector *stats_vec, uint64_t *req_delay, void *data);
 
 /* Packet buffering. */
-void bp_packet_data_destroy(struct bp_packet_data *pd);
+void buffered_packets_ctx_init(struct buffered_packets_ctx *);
+void buffered_packets_ctx_destroy(struct buffered_packets_ctx *);
+void buffered_packets_ctx_set_max_bytes(struct buffered_packets_ctx *,
+                                        uint64_t max_bytes);
+void buffered_packets_ctx_get_memory_usage(struct buffered_packets_ctx *,
+                                           struct simap *usage);
+
+void bp_packet_data_destroy(struct buffered_packets_ctx *,
+                            struct bp_packet_data *pd);
 
 struct buffered_packets *
-buffered_packets_add(struct cmap *bp_map,
+buffered_packets_add(struct buffered_packets_ctx *,
                      struct mac_binding_data mb_data);
 
-void buffered_packets_packet_data_enqueue(struct buffered_packets *bp,
+bool buffered_packets_packet_data_enqueue(struct buffered_packets_ctx *,
+                                          struct buffered_packets *bp,
                                           const struct ofputil_packet_in *pin,
                                           const struct ofpbuf *continuation);
 
-bool buffered_packets_lookup_run(struct cmap *bp_map,
+bool buffered_packets_lookup_run(struct buffered_packets_ctx *,
                                  const struct hmap *recent_mbs,
                                  struct ovsdb_idl_index *sbrec_pb_by_key,
                                  struct ovsdb_idl_index *sbrec_dp_by_key,
                                  struct ovsdb_idl_index *sbrec_pb_by_name,
                                  struct ovsdb_idl_index *sbrec_mb_by_lport_ip);
 
-void buffered_packets_run(struct cmap *bp_map, struct vector *rpd);
-
-void buffered_packets_map_destroy(struct cmap *bp_map);
+void buffered_packets_run(struct buffered_packets_ctx *, struct vector *rpd);
 
 void mac_binding_probe_stats_process_flow_stats(
         struct vector *stats_vec,
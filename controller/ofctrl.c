@@ -411,6 +411,10 @@ static enum mf_field_id mff_ovn_geneve;
  * (e.g. after OVS restart). */
 static bool ofctrl_initial_clear;
 
+/* CT zones flushed by the current ofctrl_put() call, indexed by zone.  All
+ * bits are cleared again before ofctrl_put() returns. */
+static unsigned long *flushed_ct_zones;
+
 static ovs_be32 queue_msg(struct ofpbuf *);
 
 static struct ofpbuf *encode_flow_mod(struct ofputil_flow_mod *);
@@ -436,9 +440,11 @@ ofctrl_init(struct ovn_extend_table *group_table,
     ecmp_nexthop_init();
     ovs_list_init(&flow_updates);
     ovn_init_symtab(&symtab);
+    expr_symtab_freeze(&symtab);
     groups = group_table;
     meters = meter_table;
     shash_init(&meter_bands);
+    flushed_ct_zones = bitmap_allocate(MAX_CT_ZONES + 1);
 }
 
 /* S_NEW, for a new connection.
@@ -889,6 +895,7 @@ ofctrl_destroy(void)
     shash_destroy(&symtab);
     ofctrl_meter_bands_destroy();
     ecmp_nexthop_destroy();
+    bitmap_free(flushed_ct_zones);
 }
 
 uint64_t
@@ -2826,16 +2833,25 @@ ofctrl_put(struct ovn_desired_flow_table *lflow_table,
         return;
     }
 
-    /* Iterate through ct zones that need to be flushed. */
+    /* Iterate through ct zones that need to be flushed.  A zone released by
+     * a port and assigned to another one in the same batch shows up twice,
+     * it's flushed only once. */
     struct shash_node *iter;
     SHASH_FOR_EACH(iter, pending_ct_zones) {
         struct ct_zone_pending_entry *ctzpe = iter->data;
         if (ctzpe->state == CT_ZONE_OF_QUEUED) {
-            add_ct_flush_zone(ctzpe->ct_zone.zone, &msgs);
+            if (!bitmap_is_set(flushed_ct_zones, ctzpe->ct_zone.zone)) {
+                bitmap_set1(flushed_ct_zones, ctzpe->ct_zone.zone);
+                add_ct_flush_zone(ctzpe->ct_zone.zone, &msgs);
+            }
             ctzpe->state = CT_ZONE_OF_SENT;
             ctzpe->of_xid = 0;
         }
     }
+    SHASH_FOR_EACH(iter, pending_ct_zones) {
+        struct ct_zone_pending_entry *ctzpe = iter->data;
+        bitmap_set0(flushed_ct_zones, ctzpe->ct_zone.zone);
+    }
 
     if (ofctrl_initial_clear) {
         /* Send a meter_mod to delete all meters.
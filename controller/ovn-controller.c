@@ -121,8 +121,12 @@ static unixctl_cb_func debug_dump_local_template_vars;
 static unixctl_cb_func debug_dump_local_mac_bindings;
 static unixctl_cb_func debug_dump_peer_ports;
 static unixctl_cb_func debug_dump_lflow_conj_ids;
+static unixctl_cb_func debug_dump_if_status;
+static unixctl_cb_func if_status_show_latency_cmd;
+static unixctl_cb_func if_status_clear_latency_cmd;
 static unixctl_cb_func lflow_cache_flush_cmd;
 static unixctl_cb_func lflow_cache_show_stats_cmd;
+static unixctl_cb_func statctrl_show_stats_cmd;
 static unixctl_cb_func debug_delay_nb_cfg_report;
 
 #define DEFAULT_BRIDGE_NAME "br-int"
@@ -813,6 +817,16 @@ update_sb_db(struct ovsdb_idl *ovs_idl, struct ovsdb_idl *ovnsb_idl,
                 &cfg->external_ids, chassis_id,
                 "ovn-trim-timeout-ms",
                 DEFAULT_LFLOW_CACHE_TRIM_TO_MS));
+        lflow_actions_cache_set_limit(
+            get_chassis_external_id_value_uint(
+                &cfg->external_ids, chassis_id,
+                "ovn-limit-lflow-actions-cache",
+                LFLOW_ACTIONS_CACHE_DEF_MAX));
+        if_status_mgr_set_claim_batch_msec(
+            ctx->if_mgr,
+            get_chassis_external_id_value_uint(
+                &cfg->external_ids, chassis_id,
+                "ovn-port-claim-batch-max-latency-ms", 0));
     }
 }
 
@@ -991,6 +1005,10 @@ ctrl_register_ovs_idl(struct ovsdb_idl *ovs_idl)
     ovsdb_idl_track_add_column(ovs_idl, &ovsrec_port_col_name);
     ovsdb_idl_track_add_column(ovs_idl, &ovsrec_port_col_interfaces);
     ovsdb_idl_track_add_column(ovs_idl, &ovsrec_port_col_external_ids);
+    ovsdb_idl_track_add_column(ovs_idl, &ovsrec_qos_col_external_ids);
+    ovsdb_idl_track_add_column(ovs_idl, &ovsrec_qos_col_queues);
+    ovsdb_idl_track_add_column(ovs_idl, &ovsrec_queue_col_other_config);
+    ovsdb_idl_track_add_column(ovs_idl, &ovsrec_queue_col_external_ids);
     ovsdb_idl_track_add_column(ovs_idl,
                                &ovsrec_flow_sample_collector_set_col_bridge);
     ovsdb_idl_track_add_column(ovs_idl,
@@ -1317,6 +1335,9 @@ struct ed_type_runtime_data {
     /* runtime data engine private data. */
     struct hmap qos_map;
     struct smap local_iface_ids;
+    /* Summary of the OVS configuration the bindings were last computed
+     * with, see runtime_data_ovs_config(). */
+    char *ovs_config;
 
     /* Tracked data. See below for more details and comments. */
     bool tracked;
@@ -1439,6 +1460,7 @@ en_runtime_data_cleanup(void *data)
     shash_destroy(&rt_data->local_active_ports_ipv6_pd);
     shash_destroy(&rt_data->local_active_ports_ras);
     local_binding_data_destroy(&rt_data->lbinding_data);
+    free(rt_data->ovs_config);
 }
 
 static void
@@ -1471,6 +1493,9 @@ init_binding_ctx(struct engine_node *node,
     const struct ovsrec_qos_table *qos_table =
         EN_OVSDB_GET(engine_get_input("OVS_qos", node));
 
+    const struct ovsrec_queue_table *queue_table =
+        EN_OVSDB_GET(engine_get_input("OVS_queue", node));
+
     const struct sbrec_port_binding_table *pb_table =
         EN_OVSDB_GET(engine_get_input("SB_port_binding", node));
 
@@ -1510,6 +1535,7 @@ init_binding_ctx(struct engine_node *node,
     b_ctx_in->iface_table_external_ids_old =
         &iface_shadow->iface_table_external_ids_old;
     b_ctx_in->qos_table = qos_table;
+    b_ctx_in->queue_table = queue_table;
     b_ctx_in->port_binding_table = pb_table;
     b_ctx_in->br_int = br_int;
     b_ctx_in->chassis_rec = chassis;
@@ -1537,6 +1563,40 @@ init_binding_ctx(struct engine_node *node,
     b_ctx_out->localnet_learn_fdb_changed = false;
 }
 
+/* Returns a string that summarizes the parts of the local OVS configuration
+ * that the bindings depend on: the integration bridge, the chassis name and
+ * the bridges the physical networks are mapped to.  The caller must free the
+ * returned string. */
+static char *
+runtime_data_ovs_config(const struct ovsrec_open_vswitch_table *ovs_table,
+                        const struct ovsrec_bridge_table *bridge_table)
+{
+    const struct ovsrec_bridge *br_int = get_br_int(bridge_table, ovs_table);
+    const char *chassis_id = get_ovs_chassis_id(ovs_table);
+    struct ds config = DS_EMPTY_INITIALIZER;
+
+    if (!br_int || !chassis_id) {
+        return ds_steal_cstr(&config);
+    }
+
+    ds_put_format(&config, UUID_FMT" %s",
+                  UUID_ARGS(&br_int->header_.uuid), chassis_id);
+
+    struct shash bridge_mappings = SHASH_INITIALIZER(&bridge_mappings);
+    add_ovs_bridge_mappings(ovs_table, bridge_table, &bridge_mappings);
+
+    const struct shash_node **mappings = shash_sort(&bridge_mappings);
+    for (size_t i = 0; i < shash_count(&bridge_mappings); i++) {
+        const struct ovsrec_bridge *br = mappings[i]->data;
+        ds_put_format(&config, " %s:"UUID_FMT,
+                      mappings[i]->name, UUID_ARGS(&br->header_.uuid));
+    }
+    free(mappings);
+    shash_destroy(&bridge_mappings);
+
+    return ds_steal_cstr(&config);
+}
+
 static enum engine_node_state
 en_runtime_data_run(struct engine_node *node, void *data)
 {
@@ -1594,6 +1654,10 @@ en_runtime_data_run(struct engine_node *node, void *data)
     binding_run(&b_ctx_in, &b_ctx_out);
     rt_data->localnet_learn_fdb = b_ctx_out.localnet_learn_fdb;
 
+    free(rt_data->ovs_config);
+    rt_data->ovs_config = runtime_data_ovs_config(b_ctx_in.ovs_table,
+                                                  b_ctx_in.bridge_table);
+
     return EN_UPDATED;
 }
 
@@ -1665,6 +1729,60 @@ runtime_data_sb_ro_handler(struct engine_node *node, void *data)
     return result;
 }
 
+/* Handles changes to the local Open_vSwitch and Bridge records.  Only a
+ * change of the integration bridge, the chassis name or the bridge mappings
+ * affects the bindings. */
+static enum engine_input_handler_result
+runtime_data_ovs_handler(struct engine_node *node, void *data)
+{
+    struct ed_type_runtime_data *rt_data = data;
+
+    char *ovs_config = runtime_data_ovs_config(
+        EN_OVSDB_GET(engine_get_input("OVS_open_vswitch", node)),
+        EN_OVSDB_GET(engine_get_input("OVS_bridge", node)));
+    bool changed = !rt_data->ovs_config
+                   || strcmp(ovs_config, rt_data->ovs_config);
+    free(ovs_config);
+
+    return changed ? EN_UNHANDLED : EN_HANDLED_UNCHANGED;
+}
+
+static enum engine_input_handler_result
+runtime_data_ovs_qos_handler(struct engine_node *node, void *data)
+{
+    struct ed_type_runtime_data *rt_data = data;
+    struct binding_ctx_in b_ctx_in;
+    struct binding_ctx_out b_ctx_out;
+    init_binding_ctx(node, rt_data, &b_ctx_in, &b_ctx_out);
+
+    binding_handle_ovs_qos_changes(&b_ctx_in, &b_ctx_out);
+
+    /* 'qos_map' is private to the runtime data, nothing else changed. */
+    return EN_HANDLED_UNCHANGED;
+}
+
+/* Only the local chassis record is relevant for the bindings.  Remote chassis
+ * are referenced through the Port_Binding records, whose changes are handled
+ * by runtime_data_sb_port_binding_handler(). */
+static enum engine_input_handler_result
+runtime_data_sb_chassis_handler(struct engine_node *node,
+                                void *data OVS_UNUSED)
+{
+    const struct sbrec_chassis_table *chassis_table =
+        EN_OVSDB_GET(engine_get_input("SB_chassis", node));
+    const char *chassis_id = get_ovs_chassis_id(
+        EN_OVSDB_GET(engine_get_input("OVS_open_vswitch", node)));
+
+    const struct sbrec_chassis *ch;
+    SBREC_CHASSIS_TABLE_FOR_EACH_TRACKED (ch, chassis_table) {
+        if (!chassis_id || !strcmp(ch->name, chassis_id)) {
+            return EN_UNHANDLED;
+        }
+    }
+
+    return EN_HANDLED_UNCHANGED;
+}
+
 static enum engine_input_handler_result
 runtime_data_ovs_interface_shadow_handler(struct engine_node *node, void *data)
 {
@@ -2021,6 +2139,37 @@ template_vars_sb_chassis_template_var_handler(struct engine_node *node,
     return result;
 }
 
+/* Returns true if the local chassis record was created or deleted. */
+static bool
+local_chassis_is_new_or_deleted(struct engine_node *node)
+{
+    const struct sbrec_chassis_table *chassis_table =
+        EN_OVSDB_GET(engine_get_input("SB_chassis", node));
+    const char *chassis_id = get_ovs_chassis_id(
+        EN_OVSDB_GET(engine_get_input("OVS_open_vswitch", node)));
+
+    const struct sbrec_chassis *ch;
+    SBREC_CHASSIS_TABLE_FOR_EACH_TRACKED (ch, chassis_table) {
+        if ((sbrec_chassis_is_deleted(ch) || sbrec_chassis_is_new(ch))
+            && chassis_id && !strcmp(ch->name, chassis_id)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Only the name of the local chassis is used to look up its template
+ * variables, other chassis are irrelevant. */
+static enum engine_input_handler_result
+template_vars_sb_chassis_handler(struct engine_node *node,
+                                 void *data OVS_UNUSED)
+{
+    if (local_chassis_is_new_or_deleted(node)) {
+        return EN_UNHANDLED;
+    }
+    return EN_HANDLED_UNCHANGED;
+}
+
 static void
 en_template_vars_clear_tracked_data(void *data)
 {
@@ -2557,13 +2706,12 @@ ct_zones_runtime_data_handler(struct engine_node *node, void *data)
     struct ed_type_ct_zones *ct_zones_data = data;
 
     struct hmap *tracked_dp_bindings = &rt_data->tracked_dp_bindings;
-    int scan_start, min_ct_zone, max_ct_zone;
+    int min_ct_zone, max_ct_zone;
     struct tracked_datapath *tdp;
 
     bool updated = false;
 
     ct_zones_parse_range(ovs_table, &min_ct_zone, &max_ct_zone);
-    scan_start = min_ct_zone;
 
     HMAP_FOR_EACH (tdp, node, tracked_dp_bindings) {
         if (tdp->tracked_type == TRACKED_RESOURCE_NEW) {
@@ -2589,8 +2737,7 @@ ct_zones_runtime_data_handler(struct engine_node *node, void *data)
                 !smap_get_bool(&t_lport->pb->options,
                                "enable_router_port_acl", false)) {
                 updated |= ct_zone_handle_port_update(&ct_zones_data->ctx,
-                                                      t_lport->pb,
-                                                      false, &scan_start,
+                                                      t_lport->pb, false,
                                                       min_ct_zone,
                                                       max_ct_zone);
                 continue;
@@ -2599,8 +2746,7 @@ ct_zones_runtime_data_handler(struct engine_node *node, void *data)
                     t_lport->tracked_type == TRACKED_RESOURCE_NEW ||
                     t_lport->tracked_type == TRACKED_RESOURCE_UPDATED;
             updated |= ct_zone_handle_port_update(&ct_zones_data->ctx,
-                                                  t_lport->pb,
-                                                  port_updated, &scan_start,
+                                                  t_lport->pb, port_updated,
                                                   min_ct_zone, max_ct_zone);
         }
     }
@@ -3615,6 +3761,12 @@ struct ed_type_non_vif_data {
                                  /* Array of flow-based tunnels indexed by
                                   * tunnel type. */
     bool use_flow_based_tunnels; /* Enable flow-based tunnels. */
+
+    /* Tracked data.  'tracked' is true if only the tunnels to remote chassis
+     * changed in the last run, and 'changed_chassis' then contains the names
+     * of the chassis whose tunnels were added, removed or updated. */
+    bool tracked;
+    struct sset changed_chassis;
 };
 
 static void *
@@ -3626,6 +3778,8 @@ en_non_vif_data_init(struct engine_node *node OVS_UNUSED,
     hmap_init(&data->chassis_tunnels);
     flow_based_tunnels_init(data->flow_tunnels);
     data->use_flow_based_tunnels = false;
+    data->tracked = false;
+    sset_init(&data->changed_chassis);
     return data;
 }
 
@@ -3636,19 +3790,21 @@ en_non_vif_data_cleanup(void *data OVS_UNUSED)
     simap_destroy(&ed_non_vif_data->patch_ofports);
     chassis_tunnels_destroy(&ed_non_vif_data->chassis_tunnels);
     flow_based_tunnels_destroy(ed_non_vif_data->flow_tunnels);
+    sset_destroy(&ed_non_vif_data->changed_chassis);
+}
+
+static void
+en_non_vif_data_clear_tracked_data(void *data)
+{
+    struct ed_type_non_vif_data *ed_non_vif_data = data;
+    ed_non_vif_data->tracked = false;
+    sset_clear(&ed_non_vif_data->changed_chassis);
 }
 
 static enum engine_node_state
 en_non_vif_data_run(struct engine_node *node, void *data)
 {
     struct ed_type_non_vif_data *ed_non_vif_data = data;
-    simap_destroy(&ed_non_vif_data->patch_ofports);
-    chassis_tunnels_destroy(&ed_non_vif_data->chassis_tunnels);
-    flow_based_tunnels_destroy(ed_non_vif_data->flow_tunnels);
-
-    simap_init(&ed_non_vif_data->patch_ofports);
-    hmap_init(&ed_non_vif_data->chassis_tunnels);
-    flow_based_tunnels_init(ed_non_vif_data->flow_tunnels);
 
     const struct ovsrec_open_vswitch_table *ovs_table =
         EN_OVSDB_GET(engine_get_input("OVS_open_vswitch", node));
@@ -3668,15 +3824,48 @@ en_non_vif_data_run(struct engine_node *node, void *data)
         = chassis_lookup_by_name(sbrec_chassis_by_name, chassis_id);
     ovs_assert(chassis);
 
-    ed_non_vif_data->use_flow_based_tunnels =
+    struct ed_type_non_vif_data new_data;
+    simap_init(&new_data.patch_ofports);
+    hmap_init(&new_data.chassis_tunnels);
+    flow_based_tunnels_init(new_data.flow_tunnels);
+    new_data.use_flow_based_tunnels =
         is_flow_based_tunnels_enabled(ovs_table, chassis);
 
     local_nonvif_data_run(br_int, chassis,
-                          &ed_non_vif_data->patch_ofports,
-                          &ed_non_vif_data->chassis_tunnels,
-                          ed_non_vif_data->flow_tunnels);
+                          &new_data.patch_ofports,
+                          &new_data.chassis_tunnels,
+                          new_data.flow_tunnels);
+
+    /* The inputs of this node (SB Chassis, OVS Open_vSwitch and Bridge)
+     * change far more often than the data derived from them.  Don't make
+     * the dependent nodes recompute if nothing changed, and let them handle
+     * the changes of the tunnels to a few remote chassis (e.g., a chassis
+     * joining or leaving the cluster) incrementally. */
+    chassis_tunnels_diff(&ed_non_vif_data->chassis_tunnels,
+                         &new_data.chassis_tunnels,
+                         &ed_non_vif_data->changed_chassis);
+    ed_non_vif_data->tracked =
+        new_data.use_flow_based_tunnels
+            == ed_non_vif_data->use_flow_based_tunnels
+        && simap_equal(&new_data.patch_ofports,
+                       &ed_non_vif_data->patch_ofports)
+        && flow_based_tunnels_equal(new_data.flow_tunnels,
+                                    ed_non_vif_data->flow_tunnels);
+    bool changed = !ed_non_vif_data->tracked
+                   || !sset_is_empty(&ed_non_vif_data->changed_chassis);
+
+    simap_swap(&ed_non_vif_data->patch_ofports, &new_data.patch_ofports);
+    hmap_swap(&ed_non_vif_data->chassis_tunnels, &new_data.chassis_tunnels);
+    simap_destroy(&new_data.patch_ofports);
+    chassis_tunnels_destroy(&new_data.chassis_tunnels);
 
-    return EN_UPDATED;
+    flow_based_tunnels_destroy(ed_non_vif_data->flow_tunnels);
+    memcpy(ed_non_vif_data->flow_tunnels, new_data.flow_tunnels,
+           sizeof new_data.flow_tunnels);
+    ed_non_vif_data->use_flow_based_tunnels =
+        new_data.use_flow_based_tunnels;
+
+    return changed ? EN_UPDATED : EN_UNCHANGED;
 }
 
 static enum engine_input_handler_result
@@ -4532,6 +4721,43 @@ lflow_output_template_vars_handler(struct engine_node *node, void *data)
     return result;
 }
 
+/* Only the logical flows that output to ports through the tunnels to the
+ * changed chassis (e.g., fwd_group() liveness) depend on non_vif_data. */
+static enum engine_input_handler_result
+lflow_output_non_vif_data_handler(struct engine_node *node, void *data)
+{
+    struct ed_type_non_vif_data *non_vif_data =
+        engine_get_input_data("non_vif_data", node);
+
+    if (!non_vif_data->tracked) {
+        return EN_UNHANDLED;
+    }
+
+    struct ed_type_lflow_output *fo = data;
+    struct lflow_ctx_out l_ctx_out;
+    struct lflow_ctx_in l_ctx_in;
+    init_lflow_ctx(node, fo, &l_ctx_in, &l_ctx_out);
+
+    const char *chassis_name;
+    bool changed;
+    enum engine_input_handler_result result = EN_HANDLED_UNCHANGED;
+
+    SSET_FOR_EACH (chassis_name, &non_vif_data->changed_chassis) {
+        if (!objdep_mgr_handle_change(l_ctx_out.lflow_deps_mgr,
+                                      OBJDEP_TYPE_CHASSIS,
+                                      chassis_name, lflow_handle_changed_ref,
+                                      l_ctx_out.objs_processed,
+                                      &l_ctx_in, &l_ctx_out, &changed)) {
+            return EN_UNHANDLED;
+        }
+        if (changed) {
+            result = EN_HANDLED_UPDATED;
+        }
+    }
+
+    return result;
+}
+
 static enum engine_input_handler_result
 lflow_output_runtime_data_handler(struct engine_node *node,
                                   void *data OVS_UNUSED)
@@ -4639,6 +4865,12 @@ struct ed_type_pflow_output {
     struct physical_debug debug;
     /* Shared group table from lflow_output, set during main loop init. */
     struct ovn_extend_table *group_table;
+    /* Summary of the OVS configuration the flows were last computed with,
+     * see pflow_output_ovs_config(). */
+    char *ovs_config;
+    /* Port bindings and multicast groups that use the tunnels to each remote
+     * chassis. */
+    struct objdep_mgr chassis_deps_mgr;
 };
 
 static void
@@ -4735,6 +4967,11 @@ static void init_physical_ctx(struct engine_node *node,
                 engine_get_input("SB_port_binding", node),
                 "datapath");
 
+    struct ovsdb_idl_index *sbrec_port_binding_by_chassis =
+        engine_ovsdb_node_get_index(
+                engine_get_input("SB_port_binding", node),
+                "chassis");
+
     const struct sbrec_multicast_group_table *multicast_group_table =
         EN_OVSDB_GET(engine_get_input("SB_multicast_group", node));
 
@@ -4786,6 +5023,7 @@ static void init_physical_ctx(struct engine_node *node,
     parse_encap_ips(ovs_table, &p_ctx->n_encap_ips, &p_ctx->encap_ips);
     p_ctx->sbrec_port_binding_by_name = sbrec_port_binding_by_name;
     p_ctx->sbrec_port_binding_by_datapath = sbrec_port_binding_by_datapath;
+    p_ctx->sbrec_port_binding_by_chassis = sbrec_port_binding_by_chassis;
     p_ctx->sbrec_chassis_by_name = sbrec_chassis_by_name;
     p_ctx->port_binding_table = port_binding_table;
     p_ctx->ovs_interface_table = ovs_interface_table;
@@ -4808,6 +5046,7 @@ static void init_physical_ctx(struct engine_node *node,
     p_ctx->evpn_fdbs = &efdb_data->fdbs;
     p_ctx->evpn_arps = &earp_data->arps;
     p_ctx->group_table = data->group_table;
+    p_ctx->chassis_deps_mgr = &data->chassis_deps_mgr;
 
     struct controller_engine_ctx *ctrl_ctx = engine_get_context()->client_ctx;
     p_ctx->if_mgr = ctrl_ctx->if_mgr;
@@ -4832,6 +5071,7 @@ en_pflow_output_init(struct engine_node *node OVS_UNUSED,
 {
     struct ed_type_pflow_output *data = xzalloc(sizeof *data);
     ovn_desired_flow_table_init(&data->flow_table);
+    objdep_mgr_init(&data->chassis_deps_mgr);
     return data;
 }
 
@@ -4840,6 +5080,39 @@ en_pflow_output_cleanup(void *data OVS_UNUSED)
 {
     struct ed_type_pflow_output *pfo = data;
     ovn_desired_flow_table_destroy(&pfo->flow_table);
+    objdep_mgr_destroy(&pfo->chassis_deps_mgr);
+    free(pfo->ovs_config);
+}
+
+/* Returns a string that summarizes the parts of the local OVS configuration
+ * that pflow_output depends on: the integration bridge, the chassis name and
+ * the local encap IPs, in the order they are assigned encap ids.  The caller
+ * must free the returned string. */
+static char *
+pflow_output_ovs_config(const struct ovsrec_open_vswitch_table *ovs_table,
+                        const struct ovsrec_bridge_table *bridge_table)
+{
+    const struct ovsrec_bridge *br_int = get_br_int(bridge_table, ovs_table);
+    const char *chassis_id = get_ovs_chassis_id(ovs_table);
+    struct ds config = DS_EMPTY_INITIALIZER;
+
+    if (!br_int || !chassis_id) {
+        return ds_steal_cstr(&config);
+    }
+
+    ds_put_format(&config, UUID_FMT" %s",
+                  UUID_ARGS(&br_int->header_.uuid), chassis_id);
+
+    size_t n_encap_ips;
+    const char **encap_ips;
+    parse_encap_ips(ovs_table, &n_encap_ips, &encap_ips);
+    for (size_t i = 0; i < n_encap_ips; i++) {
+        ds_put_format(&config, " %s", encap_ips[i]);
+        free((char *) encap_ips[i]);
+    }
+    free(encap_ips);
+
+    return ds_steal_cstr(&config);
 }
 
 static enum engine_node_state
@@ -4852,6 +5125,7 @@ en_pflow_output_run(struct engine_node *node, void *data)
         first_run = false;
     } else {
         ovn_desired_flow_table_clear(pflow_table);
+        objdep_mgr_clear(&pfo->chassis_deps_mgr);
     }
 
     struct ed_type_runtime_data *rt_data =
@@ -4864,6 +5138,11 @@ en_pflow_output_run(struct engine_node *node, void *data)
     physical_run(&p_ctx, pflow_table);
     destroy_physical_ctx(&p_ctx);
 
+    free(pfo->ovs_config);
+    pfo->ovs_config = pflow_output_ovs_config(
+        EN_OVSDB_GET(engine_get_input("OVS_open_vswitch", node)),
+        EN_OVSDB_GET(engine_get_input("OVS_bridge", node)));
+
     return EN_UPDATED;
 }
 
@@ -4971,6 +5250,93 @@ pflow_output_sb_multicast_group_handler(struct engine_node *node, void *data)
     return EN_HANDLED_UPDATED;
 }
 
+static enum engine_input_handler_result
+pflow_output_non_vif_data_handler(struct engine_node *node, void *data)
+{
+    struct ed_type_non_vif_data *non_vif_data =
+        engine_get_input_data("non_vif_data", node);
+
+    if (!non_vif_data->tracked) {
+        return EN_UNHANDLED;
+    }
+    if (sset_is_empty(&non_vif_data->changed_chassis)) {
+        return EN_HANDLED_UNCHANGED;
+    }
+
+    struct ed_type_runtime_data *rt_data =
+        engine_get_input_data("runtime_data", node);
+    struct ed_type_pflow_output *pfo = data;
+
+    struct physical_ctx p_ctx;
+    init_physical_ctx(node, pfo, rt_data, non_vif_data, &p_ctx);
+    physical_handle_tunnel_changes(&p_ctx, &non_vif_data->changed_chassis,
+                                   &pfo->flow_table);
+    destroy_physical_ctx(&p_ctx);
+
+    return EN_HANDLED_UPDATED;
+}
+
+static enum engine_input_handler_result
+pflow_output_sb_encap_handler(struct engine_node *node, void *data)
+{
+    const struct sbrec_encap_table *encap_table =
+        EN_OVSDB_GET(engine_get_input("SB_encap", node));
+    struct ed_type_runtime_data *rt_data =
+        engine_get_input_data("runtime_data", node);
+    struct ed_type_non_vif_data *non_vif_data =
+        engine_get_input_data("non_vif_data", node);
+
+    struct ed_type_pflow_output *pfo = data;
+
+    struct physical_ctx p_ctx;
+    init_physical_ctx(node, pfo, rt_data, non_vif_data, &p_ctx);
+
+    /* Only the flows of ports (and multicast groups) bound to the chassis
+     * whose encaps changed need to be updated.  Changes to the local encaps
+     * affect the tunnel selection for every port, fall back to a full
+     * recompute in that case. */
+    enum engine_input_handler_result result = EN_HANDLED_UNCHANGED;
+    struct sset chassis_names = SSET_INITIALIZER(&chassis_names);
+    const struct sbrec_encap *encap;
+    SBREC_ENCAP_TABLE_FOR_EACH_TRACKED (encap, encap_table) {
+        if (!strcmp(encap->chassis_name, p_ctx.chassis->name)) {
+            result = EN_UNHANDLED;
+            goto out;
+        }
+        sset_add(&chassis_names, encap->chassis_name);
+    }
+
+    if (!sset_is_empty(&chassis_names)) {
+        physical_handle_remote_chassis_changes(&p_ctx, &chassis_names,
+                                               &pfo->flow_table);
+        result = EN_HANDLED_UPDATED;
+    }
+
+out:
+    sset_destroy(&chassis_names);
+    destroy_physical_ctx(&p_ctx);
+    return result;
+}
+
+/* Handles changes to the local Open_vSwitch and Bridge records.  Most of
+ * them (e.g., ports being added to the integration bridge or unrelated
+ * external_ids) don't affect the physical flows, only a change of the
+ * integration bridge, chassis name or local encap IPs requires a
+ * recompute. */
+static enum engine_input_handler_result
+pflow_output_ovs_handler(struct engine_node *node, void *data)
+{
+    struct ed_type_pflow_output *pfo = data;
+
+    char *ovs_config = pflow_output_ovs_config(
+        EN_OVSDB_GET(engine_get_input("OVS_open_vswitch", node)),
+        EN_OVSDB_GET(engine_get_input("OVS_bridge", node)));
+    bool changed = !pfo->ovs_config || strcmp(ovs_config, pfo->ovs_config);
+    free(ovs_config);
+
+    return changed ? EN_UNHANDLED : EN_HANDLED_UNCHANGED;
+}
+
 static enum engine_input_handler_result
 pflow_output_runtime_data_handler(struct engine_node *node, void *data)
 {
@@ -5228,26 +5594,44 @@ controller_output_datapaths_updated_handler(
     return EN_HANDLED_UPDATED;
 }
 
-/* Handles sbrec_chassis changes.
- * If a new chassis is added or removed return false, so that
- * flows are recomputed.  For any updates, there is no need for
- * any flow computation.  Encap changes will also result in
- * sbrec_chassis changes, but we handle encap changes separately.
- */
+/* Handles sbrec_chassis changes.  Remote chassis joining, leaving or
+ * updating their chassis macs or "is-remote" option only affect a few
+ * physical flows of their own.  The tunnels to them are handled through
+ * non_vif_data and the ports bound to them through their Port_Binding
+ * changes.  Encap changes will also result in sbrec_chassis changes, but
+ * we handle encap changes separately. */
 static enum engine_input_handler_result
-pflow_lflow_output_sb_chassis_handler(struct engine_node *node,
-                                      void *data OVS_UNUSED)
+pflow_output_sb_chassis_handler(struct engine_node *node, void *data)
 {
-    const struct sbrec_chassis_table *chassis_table =
-        EN_OVSDB_GET(engine_get_input("SB_chassis", node));
-
-    const struct sbrec_chassis *ch;
-    SBREC_CHASSIS_TABLE_FOR_EACH_TRACKED (ch, chassis_table) {
-        if (sbrec_chassis_is_deleted(ch) || sbrec_chassis_is_new(ch)) {
-            return EN_UNHANDLED;
-        }
+    if (local_chassis_is_new_or_deleted(node)) {
+        return EN_UNHANDLED;
     }
 
+    struct ed_type_runtime_data *rt_data =
+        engine_get_input_data("runtime_data", node);
+    struct ed_type_non_vif_data *non_vif_data =
+        engine_get_input_data("non_vif_data", node);
+
+    struct ed_type_pflow_output *pfo = data;
+
+    struct physical_ctx p_ctx;
+    init_physical_ctx(node, pfo, rt_data, non_vif_data, &p_ctx);
+    physical_handle_chassis_changes(&p_ctx, &pfo->flow_table);
+    destroy_physical_ctx(&p_ctx);
+
+    return EN_HANDLED_UPDATED;
+}
+
+/* Handles sbrec_chassis changes.  The logical flows only depend on remote
+ * chassis through the tunnels to them and the ports bound to them, which
+ * are handled through non_vif_data and Port_Binding changes. */
+static enum engine_input_handler_result
+lflow_output_sb_chassis_handler(struct engine_node *node,
+                                void *data OVS_UNUSED)
+{
+    if (local_chassis_is_new_or_deleted(node)) {
+        return EN_UNHANDLED;
+    }
     return EN_HANDLED_UNCHANGED;
 }
 
@@ -6929,13 +7313,13 @@ static ENGINE_NODE(template_vars, CLEAR_TRACKED_DATA);
 static ENGINE_NODE(ct_zones, CLEAR_TRACKED_DATA, IS_VALID);
 static ENGINE_NODE(ovs_interface_shadow, CLEAR_TRACKED_DATA);
 static ENGINE_NODE(runtime_data, CLEAR_TRACKED_DATA, SB_WRITE);
-static ENGINE_NODE(non_vif_data);
+static ENGINE_NODE(non_vif_data, CLEAR_TRACKED_DATA);
 static ENGINE_NODE(mff_ovn_geneve);
 static ENGINE_NODE(ofctrl_is_connected);
 static ENGINE_NODE(activated_ports, CLEAR_TRACKED_DATA);
 static ENGINE_NODE(postponed_ports);
 static ENGINE_NODE(pflow_output);
-static ENGINE_NODE(lflow_output, CLEAR_TRACKED_DATA);
+static ENGINE_NODE(lflow_output, CLEAR_TRACKED_DATA, RESUMABLE);
 static ENGINE_NODE(controller_output);
 static ENGINE_NODE(addr_sets, CLEAR_TRACKED_DATA);
 static ENGINE_NODE(port_groups, CLEAR_TRACKED_DATA);
@@ -6981,7 +7365,8 @@ inc_proc_ovn_controller_init(
      * on the second argument. */
 
     engine_add_input(&en_template_vars, &en_ovs_open_vswitch, NULL);
-    engine_add_input(&en_template_vars, &en_sb_chassis, NULL);
+    engine_add_input(&en_template_vars, &en_sb_chassis,
+                     template_vars_sb_chassis_handler);
     engine_add_input(&en_template_vars, &en_sb_chassis_template_var,
                      template_vars_sb_chassis_template_var_handler);
 
@@ -7038,12 +7423,12 @@ inc_proc_ovn_controller_init(
      * be handled before any ct_zone changes.
      */
     engine_add_input(&en_pflow_output, &en_non_vif_data,
-                     NULL);
+                     pflow_output_non_vif_data_handler);
     engine_add_input(&en_pflow_output, &en_northd_options, NULL);
     engine_add_input(&en_pflow_output, &en_ct_zones,
                      pflow_output_ct_zones_handler);
     engine_add_input(&en_pflow_output, &en_sb_chassis,
-                     pflow_lflow_output_sb_chassis_handler);
+                     pflow_output_sb_chassis_handler);
 
     engine_add_input(&en_pflow_output, &en_if_status_mgr,
                      pflow_output_if_status_mgr_handler);
@@ -7062,10 +7447,13 @@ inc_proc_ovn_controller_init(
 
     engine_add_input(&en_pflow_output, &en_runtime_data,
                      pflow_output_runtime_data_handler);
-    engine_add_input(&en_pflow_output, &en_sb_encap, NULL);
+    engine_add_input(&en_pflow_output, &en_sb_encap,
+                     pflow_output_sb_encap_handler);
     engine_add_input(&en_pflow_output, &en_mff_ovn_geneve, NULL);
-    engine_add_input(&en_pflow_output, &en_ovs_open_vswitch, NULL);
-    engine_add_input(&en_pflow_output, &en_ovs_bridge, NULL);
+    engine_add_input(&en_pflow_output, &en_ovs_open_vswitch,
+                     pflow_output_ovs_handler);
+    engine_add_input(&en_pflow_output, &en_ovs_bridge,
+                     pflow_output_ovs_handler);
     engine_add_input(&en_pflow_output, &en_ovs_flow_sample_collector_set,
                      pflow_output_debug_handler);
     engine_add_input(&en_pflow_output, &en_sb_sb_global,
@@ -7102,13 +7490,13 @@ inc_proc_ovn_controller_init(
     engine_add_input(&en_lflow_output, &en_runtime_data,
                      lflow_output_runtime_data_handler);
     engine_add_input(&en_lflow_output, &en_non_vif_data,
-                     NULL);
+                     lflow_output_non_vif_data_handler);
 
     engine_add_input(&en_lflow_output, &en_sb_multicast_group,
                      lflow_output_sb_multicast_group_handler);
 
     engine_add_input(&en_lflow_output, &en_sb_chassis,
-                     pflow_lflow_output_sb_chassis_handler);
+                     lflow_output_sb_chassis_handler);
 
     engine_add_input(&en_lflow_output, &en_sb_port_binding,
                      lflow_output_sb_port_binding_handler);
@@ -7150,12 +7538,17 @@ inc_proc_ovn_controller_init(
 
     engine_add_input(&en_runtime_data, &en_ofctrl_is_connected, NULL);
 
-    engine_add_input(&en_runtime_data, &en_ovs_open_vswitch, NULL);
-    engine_add_input(&en_runtime_data, &en_ovs_bridge, NULL);
-    engine_add_input(&en_runtime_data, &en_ovs_qos, NULL);
-    engine_add_input(&en_runtime_data, &en_ovs_queue, NULL);
-
-    engine_add_input(&en_runtime_data, &en_sb_chassis, NULL);
+    engine_add_input(&en_runtime_data, &en_ovs_open_vswitch,
+                     runtime_data_ovs_handler);
+    engine_add_input(&en_runtime_data, &en_ovs_bridge,
+                     runtime_data_ovs_handler);
+    engine_add_input(&en_runtime_data, &en_ovs_qos,
+                     runtime_data_ovs_qos_handler);
+    engine_add_input(&en_runtime_data, &en_ovs_queue,
+                     runtime_data_ovs_qos_handler);
+
+    engine_add_input(&en_runtime_data, &en_sb_chassis,
+                     runtime_data_sb_chassis_handler);
     engine_add_input(&en_runtime_data, &en_sb_datapath_binding,
                      runtime_data_sb_datapath_binding_handler);
     engine_add_input(&en_runtime_data, &en_sb_port_binding,
@@ -7308,6 +7701,12 @@ inc_proc_ovn_controller_init(
     engine_ovsdb_node_add_index(&en_sb_port_binding, "datapath",
                                 sbrec_port_binding_by_datapath);
 
+    struct ovsdb_idl_index *sbrec_port_binding_by_chassis
+        = ovsdb_idl_index_create1(sb_idl_loop->idl,
+                                  &sbrec_port_binding_col_chassis);
+    engine_ovsdb_node_add_index(&en_sb_port_binding, "chassis",
+                                sbrec_port_binding_by_chassis);
+
     engine_ovsdb_node_add_index(&en_sb_datapath_binding, "key",
                                 sbrec_datapath_binding_by_key);
 
@@ -7717,6 +8116,9 @@ main(int argc, char *argv[])
                              lflow_cache_show_stats_cmd,
                              &lflow_output_data->pd);
 
+    unixctl_command_register("statctrl/show-stats", "", 0, 0,
+                             statctrl_show_stats_cmd, NULL);
+
     bool reset_ovnsb_idl_min_index = false;
     unixctl_command_register("sb-cluster-state-reset", "", 0, 0,
                              cluster_state_reset_cmd,
@@ -7776,6 +8178,13 @@ main(int argc, char *argv[])
     };
     struct if_status_mgr *if_mgr = ctrl_engine_ctx.if_mgr;
 
+    unixctl_command_register("if-status/show-latency", "", 0, 0,
+                             if_status_show_latency_cmd, if_mgr);
+    unixctl_command_register("if-status/clear-latency", "", 0, 0,
+                             if_status_clear_latency_cmd, if_mgr);
+    unixctl_command_register("debug/dump-if-status", "", 0, 0,
+                             debug_dump_if_status, if_mgr);
+
     struct shash vif_plug_deleted_iface_ids =
         SHASH_INITIALIZER(&vif_plug_deleted_iface_ids);
     struct shash vif_plug_changed_iface_ids =
@@ -7797,7 +8206,14 @@ main(int argc, char *argv[])
             lflow_cache_get_memory_usage(ctrl_engine_ctx.lflow_cache, &usage);
             ofctrl_get_memory_usage(&usage);
             if_status_mgr_get_memory_usage(if_mgr, &usage);
+            objdep_mgr_get_memory_usage(&lflow_output_data->lflow_deps_mgr,
+                                        "lflow-deps", &usage);
+            objdep_mgr_get_memory_usage(&lb_data->deps_mgr, "lb-deps",
+                                        &usage);
+            objdep_mgr_get_memory_usage(&pflow_output_data->chassis_deps_mgr,
+                                        "pflow-chassis-deps", &usage);
             local_datapath_memory_usage(&usage);
+            pinctrl_get_memory_usage(&usage);
             ovsdb_idl_get_memory_usage(ovnsb_idl_loop.idl, &usage);
             ovsdb_idl_get_memory_usage(ovs_idl_loop.idl, &usage);
             memory_report(&usage);
@@ -8135,6 +8551,8 @@ main(int argc, char *argv[])
                                     sbrec_bfd_table_get(ovnsb_idl_loop.idl),
                                     sbrec_ecmp_nexthop_table_get(
                                         ovnsb_idl_loop.idl),
+                                    sbrec_igmp_group_table_get(
+                                        ovnsb_idl_loop.idl),
                                     chassis,
                                     &runtime_data->local_datapaths,
                                     &runtime_data->local_active_ports_ipv6_pd,
@@ -8278,9 +8696,9 @@ main(int argc, char *argv[])
                              br_int, chassis);
                 }
             } else if (engine_canceled()) {
-                VLOG_DBG("engine was canceled, force recompute next time: "
+                VLOG_DBG("engine was canceled, resume next time: "
                          "br_int %p, chassis %p", br_int, chassis);
-                engine_set_force_recompute_immediate();
+                engine_set_resume_immediate();
             } else {
                 engine_clear_force_recompute();
             }
@@ -8327,6 +8745,7 @@ main(int argc, char *argv[])
             }
 
             binding_wait();
+            if_status_mgr_wait(if_mgr);
             host_if_monitor_wait();
             ovn_netlink_notifiers_wait();
         }
@@ -8758,6 +9177,17 @@ lflow_cache_show_stats_cmd(struct unixctl_conn *conn, int argc OVS_UNUSED,
     ds_destroy(&ds);
 }
 
+static void
+statctrl_show_stats_cmd(struct unixctl_conn *conn, int argc OVS_UNUSED,
+                        const char *argv[] OVS_UNUSED, void *arg OVS_UNUSED)
+{
+    struct ds ds = DS_EMPTY_INITIALIZER;
+
+    statctrl_get_stats(&ds);
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
+}
+
 static void
 cluster_state_reset_cmd(struct unixctl_conn *conn, int argc OVS_UNUSED,
                const char *argv[] OVS_UNUSED, void *idl_reset_)
@@ -8900,3 +9330,31 @@ debug_dump_local_mac_bindings(struct unixctl_conn *conn, int argc OVS_UNUSED,
     unixctl_command_reply(conn, ds_cstr(&mb_str));
     ds_destroy(&mb_str);
 }
+
+static void
+debug_dump_if_status(struct unixctl_conn *conn, int argc OVS_UNUSED,
+                     const char *argv[] OVS_UNUSED, void *if_mgr)
+{
+    struct ds data = DS_EMPTY_INITIALIZER;
+    if_status_mgr_dump_ifaces(if_mgr, &data);
+    unixctl_command_reply(conn, ds_cstr(&data));
+    ds_destroy(&data);
+}
+
+static void
+if_status_show_latency_cmd(struct unixctl_conn *conn, int argc OVS_UNUSED,
+                           const char *argv[] OVS_UNUSED, void *if_mgr)
+{
+    struct ds data = DS_EMPTY_INITIALIZER;
+    if_status_mgr_format_latency(if_mgr, &data);
+    unixctl_command_reply(conn, ds_cstr(&data));
+    ds_destroy(&data);
+}
+
+static void
+if_status_clear_latency_cmd(struct unixctl_conn *conn, int argc OVS_UNUSED,
+                            const char *argv[] OVS_UNUSED, void *if_mgr)
+{
+    if_status_mgr_clear_latency(if_mgr);
+    unixctl_command_reply(conn, NULL);
+}
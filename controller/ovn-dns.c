@@ -19,6 +19,7 @@
 #include "include/openvswitch/shash.h"
 #include "include/openvswitch/thread.h"
 #include "lib/cmap.h"
+#include "lib/hash.h"
 #include "openvswitch/vlog.h"
 
 /* OVN includes. */
@@ -27,20 +28,41 @@
 
 VLOG_DEFINE_THIS_MODULE(ovndns);
 
+/* Lookup index entry, one for every (record name, datapath) pair of every
+ * SB DNS record.  Entries are owned by the 'struct dns_data' that created
+ * them and are read by the pinctrl thread under RCU protection.  'name' and
+ * 'answer' point into the owner's 'records'. */
+struct dns_name_entry {
+    struct cmap_node cmap_node; /* In 'dns_name_index_'. */
+    const char *name;           /* Lowercase query name. */
+    uint64_t dp_key;
+    const char *answer;
+    bool ovn_owned;
+};
+
 /* Internal DNS cache entry for each SB DNS record. */
 struct dns_data {
     struct cmap_node cmap_node;
     struct uuid uuid;
     uint64_t *dps;
     size_t n_dps;
-    struct smap records;
+    struct smap records;        /* Keys are lowercase. */
     struct smap options;
     bool delete;
+
+    /* Index entries that belong to this record. */
+    struct dns_name_entry **entries;
+    size_t n_entries;
 };
 
-/* shash of 'struct dns_data'. */
+/* cmap of 'struct dns_data'. */
 static struct cmap dns_cache_;
 
+/* cmap of 'struct dns_name_entry', hashed by name and datapath key, so that
+ * a lookup costs a single hash probe regardless of the number of DNS
+ * records. */
+static struct cmap dns_name_index_;
+
 static void update_cache_with_dns_rec(const struct sbrec_dns *,
                                       struct dns_data *,
                                       const struct uuid *uuid,
@@ -50,11 +72,15 @@ static struct dns_data *dns_data_find(const struct uuid *uuid,
 static struct dns_data *dns_data_alloc(struct uuid uuid);
 static void dns_data_destroy(struct dns_data *dns_data);
 static void destroy_dns_cache(struct cmap *dns_cache);
+static void dns_data_index(struct dns_data *);
+static void dns_data_unindex(struct dns_data *);
+static uint32_t dns_name_hash(const char *name, uint64_t dp_key);
 
 void
 ovn_dns_cache_init(void)
 {
     cmap_init(&dns_cache_);
+    cmap_init(&dns_name_index_);
 }
 
 void
@@ -62,6 +88,7 @@ ovn_dns_cache_destroy(void)
 {
     destroy_dns_cache(&dns_cache_);
     cmap_destroy(&dns_cache_);
+    cmap_destroy(&dns_name_index_);
 }
 
 void
@@ -83,6 +110,7 @@ ovn_dns_sync_cache(const struct sbrec_dns_table *dns_table)
 
     CMAP_FOR_EACH (existing, cmap_node, &dns_cache_) {
         if (existing->delete) {
+            dns_data_unindex(existing);
             cmap_remove(&dns_cache_, &existing->cmap_node,
                         uuid_hash(&existing->uuid));
             ovsrcu_postpone(dns_data_destroy, existing);
@@ -100,7 +128,11 @@ ovn_dns_update_cache(const struct sbrec_dns_table *dns_table)
         const struct uuid *uuid = &sbrec_dns->header_.uuid;
 
         existing = dns_data_find(uuid, &dns_cache_);
-        if (sbrec_dns_is_deleted(sbrec_dns) && existing) {
+        if (sbrec_dns_is_deleted(sbrec_dns)) {
+            if (!existing) {
+                continue;
+            }
+            dns_data_unindex(existing);
             cmap_remove(&dns_cache_, &existing->cmap_node,
                         uuid_hash(&existing->uuid));
             ovsrcu_postpone(dns_data_destroy, existing);
@@ -114,32 +146,25 @@ ovn_dns_update_cache(const struct sbrec_dns_table *dns_table)
 const char *
 ovn_dns_lookup(const char *query_name, uint64_t dp_key, bool *ovn_owned)
 {
+    const struct dns_name_entry *entry;
     const char *answer_data = NULL;
-    struct dns_data *dns_data;
 
     *ovn_owned = false;
 
-    CMAP_FOR_EACH (dns_data, cmap_node, &dns_cache_) {
-        for (size_t i = 0; i < dns_data->n_dps; i++) {
-            if (dns_data->dps[i] == dp_key) {
-                /* DNS records in SBDB are stored in lowercase. Convert to
-                 * lowercase to perform case insensitive lookup
-                 */
-                char *query_name_lower = str_tolower(query_name);
-                answer_data = smap_get(&dns_data->records, query_name_lower);
-                free(query_name_lower);
-                if (answer_data) {
-                    *ovn_owned = smap_get_bool(&dns_data->options, "ovn-owned",
-                                               false);
-                    break;
-                }
-            }
-        }
-
-        if (answer_data) {
+    /* DNS records in SBDB are stored in lowercase. Convert to
+     * lowercase to perform case insensitive lookup
+     */
+    char *query_name_lower = str_tolower(query_name);
+    uint32_t hash = dns_name_hash(query_name_lower, dp_key);
+    CMAP_FOR_EACH_WITH_HASH (entry, cmap_node, hash, &dns_name_index_) {
+        if (entry->dp_key == dp_key
+            && !strcmp(entry->name, query_name_lower)) {
+            answer_data = entry->answer;
+            *ovn_owned = entry->ovn_owned;
             break;
         }
     }
+    free(query_name_lower);
 
     return answer_data;
 }
@@ -153,7 +178,11 @@ update_cache_with_dns_rec(const struct sbrec_dns *sbrec_dns,
                           struct cmap *dns_cache)
 {
     struct dns_data *dns_data = dns_data_alloc(*uuid);
-    smap_clone(&dns_data->records, &sbrec_dns->records);
+    struct smap_node *node;
+    SMAP_FOR_EACH (node, &sbrec_dns->records) {
+        smap_add_nocopy(&dns_data->records, str_tolower(node->key),
+                        xstrdup(node->value));
+    }
     smap_clone(&dns_data->options, &sbrec_dns->options);
 
     dns_data->n_dps = sbrec_dns->n_datapaths;
@@ -162,15 +191,73 @@ update_cache_with_dns_rec(const struct sbrec_dns *sbrec_dns,
         dns_data->dps[i] = sbrec_dns->datapaths[i]->tunnel_key;
     }
 
+    /* Index the new version before dropping the old one so that concurrent
+     * lookups never miss an unchanged name. */
+    dns_data_index(dns_data);
+
     if (!existing) {
         cmap_insert(dns_cache, &dns_data->cmap_node, uuid_hash(uuid));
     } else {
+        dns_data_unindex(existing);
         cmap_replace(dns_cache, &existing->cmap_node, &dns_data->cmap_node,
                      uuid_hash(uuid));
         ovsrcu_postpone(dns_data_destroy, existing);
     }
 }
 
+static uint32_t
+dns_name_hash(const char *name, uint64_t dp_key)
+{
+    return hash_string(name, hash_uint64(dp_key));
+}
+
+/* Adds an index entry for every record of 'dns_data' on every datapath it
+ * is applied to. */
+static void
+dns_data_index(struct dns_data *dns_data)
+{
+    bool ovn_owned = smap_get_bool(&dns_data->options, "ovn-owned", false);
+    size_t n_records = smap_count(&dns_data->records);
+
+    dns_data->n_entries = 0;
+    dns_data->entries = xcalloc(n_records * dns_data->n_dps,
+                                sizeof *dns_data->entries);
+
+    struct smap_node *node;
+    SMAP_FOR_EACH (node, &dns_data->records) {
+        for (size_t i = 0; i < dns_data->n_dps; i++) {
+            struct dns_name_entry *entry = xmalloc(sizeof *entry);
+            *entry = (struct dns_name_entry) {
+                .name = node->key,
+                .dp_key = dns_data->dps[i],
+                .answer = node->value,
+                .ovn_owned = ovn_owned,
+            };
+            cmap_insert(&dns_name_index_, &entry->cmap_node,
+                        dns_name_hash(entry->name, entry->dp_key));
+            dns_data->entries[dns_data->n_entries++] = entry;
+        }
+    }
+}
+
+/* Removes all index entries of 'dns_data'.  The entries are freed after an
+ * RCU grace period, as the pinctrl thread might still be looking at them.
+ * The caller must not free 'dns_data' before that either, because the
+ * entries point into its records. */
+static void
+dns_data_unindex(struct dns_data *dns_data)
+{
+    for (size_t i = 0; i < dns_data->n_entries; i++) {
+        struct dns_name_entry *entry = dns_data->entries[i];
+        cmap_remove(&dns_name_index_, &entry->cmap_node,
+                    dns_name_hash(entry->name, entry->dp_key));
+        ovsrcu_postpone(free, entry);
+    }
+    free(dns_data->entries);
+    dns_data->entries = NULL;
+    dns_data->n_entries = 0;
+}
+
 static struct dns_data *
 dns_data_find(const struct uuid *uuid, const struct cmap *dns_cache)
 {
@@ -194,6 +281,8 @@ dns_data_alloc(struct uuid uuid)
         .n_dps = 0,
         .records = SMAP_INITIALIZER(&dns_data->records),
         .options = SMAP_INITIALIZER(&dns_data->options),
+        .entries = NULL,
+        .n_entries = 0,
     };
 
     return dns_data;
@@ -205,6 +294,7 @@ dns_data_destroy(struct dns_data *dns_data)
     smap_destroy(&dns_data->records);
     smap_destroy(&dns_data->options);
     free(dns_data->dps);
+    free(dns_data->entries);
     free(dns_data);
 }
 
@@ -213,6 +303,7 @@ destroy_dns_cache(struct cmap *dns_cache)
 {
     struct dns_data *dns_data;
     CMAP_FOR_EACH (dns_data, cmap_node, dns_cache) {
+        dns_data_unindex(dns_data);
         ovsrcu_postpone(dns_data_destroy, dns_data);
     }
 }
@@ -43,6 +43,7 @@
 #include "ovn-controller.h"
 #include "lib/chassis-index.h"
 #include "lib/mcast-group-index.h"
+#include "lib/objdep.h"
 #include "lib/ovn-sb-idl.h"
 #include "lib/ovn-util.h"
 #include "ovn/actions.h"
@@ -83,6 +84,18 @@ static int64_t get_vxlan_port_key(int64_t port_key);
 /* UUID to identify OF flows not associated with ovsdb rows. */
 static struct uuid *hc_uuid = NULL;
 
+/* UUID of the flow that floods packets to the remote chassis, i.e., the
+ * chassis with "is-remote" set.  Their names are kept in
+ * 'remote_flood_chassis'. */
+static struct uuid *remote_flood_uuid = NULL;
+static struct sset remote_flood_chassis =
+    SSET_INITIALIZER(&remote_flood_chassis);
+
+/* Maps the name of a remote chassis to the UUID of the flows of the tunnels
+ * to that chassis, see physical_consider_chassis_tunnels(). */
+static struct shash chassis_tunnel_flows =
+    SHASH_INITIALIZER(&chassis_tunnel_flows);
+
 #define CHASSIS_MAC_TO_ROUTER_MAC_CONJID        100
 
 void
@@ -370,7 +383,8 @@ put_flow_based_remote_port_redirect_overlay(
 static void
 add_tunnel_ingress_pmtud_flows(const struct chassis_tunnel *tun,
                                struct ofpbuf *ofpacts,
-                               struct ovn_desired_flow_table *flow_table)
+                               struct ovn_desired_flow_table *flow_table,
+                               const struct uuid *flow_uuid)
 {
     if (tun->is_ramp_tunnel) {
         return;
@@ -391,7 +405,7 @@ add_tunnel_ingress_pmtud_flows(const struct chassis_tunnel *tun,
     match_set_icmp_code(&match, 4);
 
     ofctrl_add_flow(flow_table, OFTABLE_PHY_TO_LOG, 120, 0, &match,
-                    ofpacts, hc_uuid);
+                    ofpacts, flow_uuid);
 
     /* IPv6 ICMP flow (priority 120) */
     match_init_catchall(&match);
@@ -402,14 +416,15 @@ add_tunnel_ingress_pmtud_flows(const struct chassis_tunnel *tun,
     match_set_icmp_code(&match, 0);
 
     ofctrl_add_flow(flow_table, OFTABLE_PHY_TO_LOG, 120, 0, &match,
-                    ofpacts, hc_uuid);
+                    ofpacts, flow_uuid);
 }
 
 static void
 add_tunnel_ingress_flows(const struct chassis_tunnel *tun,
                          enum mf_field_id mff_ovn_geneve,
                          struct ovn_desired_flow_table *flow_table,
-                         struct ofpbuf *ofpacts)
+                         struct ofpbuf *ofpacts,
+                         const struct uuid *flow_uuid)
 {
     /* Main ingress flow (priority 100) */
     struct match match = MATCH_CATCHALL_INITIALIZER;
@@ -420,9 +435,9 @@ add_tunnel_ingress_flows(const struct chassis_tunnel *tun,
     put_resubmit(OFTABLE_LOCAL_OUTPUT, ofpacts);
 
     ofctrl_add_flow(flow_table, OFTABLE_PHY_TO_LOG, 100, 0, &match,
-                    ofpacts, hc_uuid);
+                    ofpacts, flow_uuid);
 
-    add_tunnel_ingress_pmtud_flows(tun, ofpacts, flow_table);
+    add_tunnel_ingress_pmtud_flows(tun, ofpacts, flow_table, flow_uuid);
 }
 
 static void
@@ -1014,119 +1029,62 @@ put_remote_port_redirect_overlay_ha_remote(
 }
 
 
-static struct hmap remote_chassis_macs =
-    HMAP_INITIALIZER(&remote_chassis_macs);
-
-/* Maps from a physical network name to the chassis macs of remote chassis. */
-struct remote_chassis_mac {
-    struct hmap_node hmap_node;
-    char *chassis_mac;
-    char *chassis_id;
-    uint32_t chassis_sb_cookie;
-};
-
+/* Adds the flows that match on the chassis macs of the remote chassis
+ * 'chassis', i.e., the macs in its ovn-chassis-mac-mappings.  The flows are
+ * owned by 'chassis', so that they can be updated when it changes. */
 static void
-populate_remote_chassis_macs(const struct sbrec_chassis *my_chassis,
-                             const struct sbrec_chassis_table *chassis_table)
+put_chassis_mac_conj_id_flows(const struct sbrec_chassis *chassis,
+                              struct ofpbuf *ofpacts_p,
+                              struct ovn_desired_flow_table *flow_table)
 {
-    const struct sbrec_chassis *chassis;
-    SBREC_CHASSIS_TABLE_FOR_EACH (chassis, chassis_table) {
+    const char *tokens
+        = get_chassis_mac_mappings(&chassis->other_config, chassis->name);
 
-        /* We want only remote chassis macs. */
-        if (!strcmp(my_chassis->name, chassis->name)) {
-            continue;
-        }
+    if (!tokens[0]) {
+        return;
+    }
 
-        const char *tokens
-            = get_chassis_mac_mappings(&chassis->other_config, chassis->name);
+    char *save_ptr = NULL;
+    char *token;
+    char *tokstr = xstrdup(tokens);
 
-        if (!tokens[0]) {
+    /* Format for a chassis mac configuration is:
+     * ovn-chassis-mac-mappings="bridge-name1:MAC1,bridge-name2:MAC2"
+     */
+    for (token = strtok_r(tokstr, ",", &save_ptr);
+         token != NULL;
+         token = strtok_r(NULL, ",", &save_ptr)) {
+        char *save_ptr2 = NULL;
+        strtok_r(token, ":", &save_ptr2);
+        char *chassis_mac_str = strtok_r(NULL, "", &save_ptr2);
+        if (!chassis_mac_str) {
+            VLOG_WARN("Parsing of ovn-chassis-mac-mappings failed for: "
+                      "\"%s\", the correct format is \"br-name1:MAC1\".",
+                      token);
             continue;
         }
 
-        char *save_ptr = NULL;
-        char *token;
-        char *tokstr = xstrdup(tokens);
-
-        /* Format for a chassis mac configuration is:
-         * ovn-chassis-mac-mappings="bridge-name1:MAC1,bridge-name2:MAC2"
-         */
-        for (token = strtok_r(tokstr, ",", &save_ptr);
-             token != NULL;
-             token = strtok_r(NULL, ",", &save_ptr)) {
-            char *save_ptr2 = NULL;
-            char *chassis_mac_bridge = strtok_r(token, ":", &save_ptr2);
-            char *chassis_mac_str = strtok_r(NULL, "", &save_ptr2);
-            if (!chassis_mac_str) {
-                VLOG_WARN("Parsing of ovn-chassis-mac-mappings failed for: "
-                          "\"%s\", the correct format is \"br-name1:MAC1\".",
-                          token);
-                continue;
-            }
-            struct remote_chassis_mac *remote_chassis_mac = NULL;
-            remote_chassis_mac = xmalloc(sizeof *remote_chassis_mac);
-            hmap_insert(&remote_chassis_macs, &remote_chassis_mac->hmap_node,
-                        hash_string(chassis_mac_bridge, 0));
-            remote_chassis_mac->chassis_mac = xstrdup(chassis_mac_str);
-            remote_chassis_mac->chassis_id = xstrdup(chassis->name);
-            remote_chassis_mac->chassis_sb_cookie =
-                chassis->header_.uuid.parts[0];
-        }
-        free(tokstr);
-    }
-}
-
-static void
-free_remote_chassis_macs(void)
-{
-    struct remote_chassis_mac *mac;
-
-    HMAP_FOR_EACH_SAFE (mac, hmap_node, &remote_chassis_macs) {
-        hmap_remove(&remote_chassis_macs, &mac->hmap_node);
-        free(mac->chassis_mac);
-        free(mac->chassis_id);
-        free(mac);
-    }
-}
-
-static void
-put_chassis_mac_conj_id_flow(const struct sbrec_chassis_table *chassis_table,
-                             const struct sbrec_chassis *chassis,
-                             struct ofpbuf *ofpacts_p,
-                             struct ovn_desired_flow_table *flow_table)
-{
-    struct match match;
-    struct remote_chassis_mac *mac;
-
-    populate_remote_chassis_macs(chassis, chassis_table);
-
-    HMAP_FOR_EACH (mac, hmap_node, &remote_chassis_macs) {
         struct eth_addr chassis_mac;
-        char *err_str = NULL;
-        struct ofpact_conjunction *conj;
-
-        if ((err_str = str_to_mac(mac->chassis_mac, &chassis_mac))) {
+        char *err_str = str_to_mac(chassis_mac_str, &chassis_mac);
+        if (err_str) {
             free(err_str);
-            free_remote_chassis_macs();
-            return;
+            break;
         }
 
+        struct match match;
         ofpbuf_clear(ofpacts_p);
         match_init_catchall(&match);
-
-
         match_set_dl_src(&match, chassis_mac);
 
-        conj = ofpact_put_CONJUNCTION(ofpacts_p);
+        struct ofpact_conjunction *conj = ofpact_put_CONJUNCTION(ofpacts_p);
         conj->id = CHASSIS_MAC_TO_ROUTER_MAC_CONJID;
         conj->n_clauses = 2;
         conj->clause = 0;
         ofctrl_add_flow(flow_table, OFTABLE_PHY_TO_LOG, 180,
-                        mac->chassis_sb_cookie,
-                        &match, ofpacts_p, hc_uuid);
+                        chassis->header_.uuid.parts[0],
+                        &match, ofpacts_p, &chassis->header_.uuid);
     }
-
-    free_remote_chassis_macs();
+    free(tokstr);
 }
 
 static void
@@ -2182,6 +2140,38 @@ enforce_tunneling_for_multichassis_ports(
     vector_destroy(&tuns);
 }
 
+/* Records the remote chassis whose tunnels the flows of 'binding' may use,
+ * i.e., the chassis it is bound or redirected to.  Network function ports
+ * use every tunnel. */
+static void
+add_port_binding_chassis_deps(const struct physical_ctx *ctx,
+                              const struct sbrec_port_binding *binding)
+{
+    const struct uuid *uuid = &binding->header_.uuid;
+
+    if (binding->chassis) {
+        objdep_mgr_add(ctx->chassis_deps_mgr, OBJDEP_TYPE_CHASSIS,
+                       binding->chassis->name, uuid);
+    }
+    for (size_t i = 0; i < binding->n_additional_chassis; i++) {
+        objdep_mgr_add(ctx->chassis_deps_mgr, OBJDEP_TYPE_CHASSIS,
+                       binding->additional_chassis[i]->name, uuid);
+    }
+    if (binding->ha_chassis_group) {
+        const struct sbrec_ha_chassis_group *hcg = binding->ha_chassis_group;
+        for (size_t i = 0; i < hcg->n_ha_chassis; i++) {
+            const struct sbrec_chassis *ch = hcg->ha_chassis[i]->chassis;
+            if (ch) {
+                objdep_mgr_add(ctx->chassis_deps_mgr, OBJDEP_TYPE_CHASSIS,
+                               ch->name, uuid);
+            }
+        }
+    }
+    if (smap_get_bool(&binding->options, "is-nf", false)) {
+        objdep_mgr_add(ctx->chassis_deps_mgr, OBJDEP_TYPE_CHASSIS, "", uuid);
+    }
+}
+
 static void
 consider_port_binding(const struct physical_ctx *ctx,
                       const struct sbrec_port_binding *binding,
@@ -2192,9 +2182,12 @@ consider_port_binding(const struct physical_ctx *ctx,
     uint32_t dp_key = binding->datapath->tunnel_key;
     uint32_t port_key = binding->tunnel_key;
     struct local_datapath *ld;
+
+    objdep_mgr_remove_obj(ctx->chassis_deps_mgr, &binding->header_.uuid);
     if (!(ld = get_local_datapath(ctx->local_datapaths, dp_key))) {
         return;
     }
+    add_port_binding_chassis_deps(ctx, binding);
 
     if (type == LP_VIF) {
         /* Table 80, priority 100.
@@ -2909,6 +2902,8 @@ consider_mc_group(const struct physical_ctx *ctx,
                   const struct sbrec_multicast_group *mc,
                   struct ovn_desired_flow_table *flow_table)
 {
+    objdep_mgr_remove_obj(ctx->chassis_deps_mgr, &mc->header_.uuid);
+
     struct local_datapath *ldp = get_local_datapath(ctx->local_datapaths,
                                                     mc->datapath->tunnel_key);
     if (!ldp) {
@@ -2998,6 +2993,8 @@ consider_mc_group(const struct physical_ctx *ctx,
                 tunnel_to_chassis(ctx->mff_ovn_geneve, port->chassis->name,
                                   ctx->chassis_tunnels, mc->datapath,
                                   port->tunnel_key, &remote_ctx->ofpacts);
+                objdep_mgr_add(ctx->chassis_deps_mgr, OBJDEP_TYPE_CHASSIS,
+                               port->chassis->name, &mc->header_.uuid);
             }
         } else if (type == LP_LOCALPORT) {
             local_output_pb(port->tunnel_key, &remote_ctx->ofpacts);
@@ -3050,6 +3047,16 @@ consider_mc_group(const struct physical_ctx *ctx,
         }
     }
 
+    const char *chassis_name;
+    SSET_FOR_EACH (chassis_name, &remote_chassis) {
+        objdep_mgr_add(ctx->chassis_deps_mgr, OBJDEP_TYPE_CHASSIS,
+                       chassis_name, &mc->header_.uuid);
+    }
+    SSET_FOR_EACH (chassis_name, &vtep_chassis) {
+        objdep_mgr_add(ctx->chassis_deps_mgr, OBJDEP_TYPE_CHASSIS,
+                       chassis_name, &mc->header_.uuid);
+    }
+
     bool local_lports = local_ctx->ofpacts.size > 0;
     bool remote_ports = remote_ctx->ofpacts.size > 0;
     bool ramp_ports = ramp_ctx->ofpacts.size > 0;
@@ -3105,18 +3112,27 @@ consider_mc_group(const struct physical_ctx *ctx,
     sset_destroy(&vtep_chassis);
 }
 
+/* Returns true if 'chassis' is a remote chassis, i.e., one with
+ * "is-remote" set. */
+static bool
+chassis_is_remote(const struct sbrec_chassis *chassis)
+{
+    return chassis && smap_get_bool(&chassis->other_config, "is-remote",
+                                    false);
+}
+
+/* Adds the flow that floods packets to the remote chassis.  It replaces the
+ * previous version of the flow, if any. */
 static void
-physical_eval_remote_chassis_flows(const struct physical_ctx *ctx,
+physical_eval_remote_chassis_flood(const struct physical_ctx *ctx,
                                    struct ofpbuf *egress_ofpacts,
                                    struct ovn_desired_flow_table *flow_table)
 {
     struct match match = MATCH_CATCHALL_INITIALIZER;
     struct chassis_tunnel *prev = NULL;
 
-    uint8_t actions_stub[256];
-    struct ofpbuf ingress_ofpacts;
-    ofpbuf_use_stub(&ingress_ofpacts, actions_stub, sizeof(actions_stub));
-
+    ofctrl_remove_flows(flow_table, remote_flood_uuid);
+    sset_clear(&remote_flood_chassis);
     ofpbuf_clear(egress_ofpacts);
 
     /* For egress flooding, we only need one tunnel per remote chassis.
@@ -3124,9 +3140,10 @@ physical_eval_remote_chassis_flows(const struct physical_ctx *ctx,
      * since we just need to reach the remote chassis once per flood. */
     const struct sbrec_chassis *chassis;
     SBREC_CHASSIS_TABLE_FOR_EACH (chassis, ctx->chassis_table) {
-        if (!smap_get_bool(&chassis->other_config, "is-remote", false)) {
+        if (!chassis_is_remote(chassis)) {
             continue;
         }
+        sset_add(&remote_flood_chassis, chassis->name);
 
         struct chassis_tunnel *tun =
             chassis_tunnel_find(ctx->chassis_tunnels, chassis->name,
@@ -3158,77 +3175,203 @@ physical_eval_remote_chassis_flows(const struct physical_ctx *ctx,
         match_set_reg_masked(&match, MFF_LOG_FLAGS - MFF_REG0, 0,
                              MLF_RX_FROM_TUNNEL);
         ofctrl_add_flow(flow_table, OFTABLE_FLOOD_REMOTE_CHASSIS, 100, 0,
-                        &match, egress_ofpacts, hc_uuid);
+                        &match, egress_ofpacts, remote_flood_uuid);
     }
+}
 
-    /* For ingress, we need to handle ALL tunnels to remote chassis because
-     * ARP replies and ND NA responses could arrive on any tunnel.  A remote
-     * chassis may have multiple tunnels (e.g., multiple encap IPs). */
-    struct chassis_tunnel *tun;
-    HMAP_FOR_EACH (tun, hmap_node, ctx->chassis_tunnels) {
-        /* Do not create flows for Geneve if the TLV negotiation is not
-         * finished.
-         */
-        if (tun->type == GENEVE && !ctx->mff_ovn_geneve) {
-            continue;
-        }
+/* Returns true if the flood flow to the remote chassis depends on the
+ * chassis named 'chassis_name'. */
+static bool
+remote_chassis_flood_uses(const struct physical_ctx *ctx,
+                          const char *chassis_name)
+{
+    return sset_contains(&remote_flood_chassis, chassis_name)
+           || chassis_is_remote(chassis_lookup_by_name(
+                                    ctx->sbrec_chassis_by_name,
+                                    chassis_name));
+}
 
-        char *chassis_name = NULL;
-        if (!encaps_tunnel_id_parse(tun->chassis_id, &chassis_name,
-                                    NULL, NULL)) {
+/* For ingress from a remote chassis, we need to handle ALL its tunnels
+ * because ARP replies and ND NA responses could arrive on any of them.  A
+ * remote chassis may have multiple tunnels (e.g., multiple encap IPs). */
+static void
+add_remote_chassis_ingress_flows(const struct physical_ctx *ctx,
+                                 const struct chassis_tunnel *tun,
+                                 const struct sbrec_chassis *remote_chassis,
+                                 struct ofpbuf *ingress_ofpacts,
+                                 struct ovn_desired_flow_table *flow_table,
+                                 const struct uuid *flow_uuid)
+{
+    /* Do not create flows for Geneve if the TLV negotiation is not
+     * finished.
+     */
+    if (tun->type == GENEVE && !ctx->mff_ovn_geneve) {
+        return;
+    }
+
+    ofpbuf_clear(ingress_ofpacts);
+    put_load(1, MFF_LOG_FLAGS, MLF_RX_FROM_TUNNEL_BIT, 1, ingress_ofpacts);
+    put_decapsulation(ctx->mff_ovn_geneve, tun, ingress_ofpacts);
+    put_resubmit(OFTABLE_LOG_INGRESS_PIPELINE, ingress_ofpacts);
+    if (tun->type == VXLAN) {
+        /* VXLAN doesn't carry the inport information, we cannot set
+         * the outport to 0 then and match on it. */
+        put_resubmit(OFTABLE_LOCAL_OUTPUT, ingress_ofpacts);
+    }
+
+    /* Add match on ARP response coming from remote chassis. */
+    struct match match;
+    match_init_catchall(&match);
+    match_set_in_port(&match, tun->ofport);
+    match_set_dl_type(&match, htons(ETH_TYPE_ARP));
+    match_set_arp_opcode_masked(&match, 2, UINT8_MAX);
+    match_set_chassis_flood_outport(&match, tun->type, ctx->mff_ovn_geneve);
+
+    ofctrl_add_flow(flow_table, OFTABLE_PHY_TO_LOG, 120,
+                    remote_chassis->header_.uuid.parts[0],
+                    &match, ingress_ofpacts, flow_uuid);
+
+    /* Add match on ND NA coming from remote chassis. */
+    match_init_catchall(&match);
+    match_set_in_port(&match, tun->ofport);
+    match_set_dl_type(&match, htons(ETH_TYPE_IPV6));
+    match_set_nw_proto(&match, IPPROTO_ICMPV6);
+    match_set_icmp_type(&match, 136);
+    match_set_icmp_code(&match, 0);
+    match_set_chassis_flood_outport(&match, tun->type, ctx->mff_ovn_geneve);
+
+    ofctrl_add_flow(flow_table, OFTABLE_PHY_TO_LOG, 120,
+                    remote_chassis->header_.uuid.parts[0],
+                    &match, ingress_ofpacts, flow_uuid);
+}
+
+/* Add VXLAN specific rules to transform port keys from 12 bits to 16 bits
+ * used elsewhere. */
+static void
+add_vxlan_multicast_ingress_flow(const struct chassis_tunnel *tun,
+                                 struct ofpbuf *ofpacts,
+                                 struct ovn_desired_flow_table *flow_table,
+                                 const struct uuid *flow_uuid)
+{
+    ofpbuf_clear(ofpacts);
+
+    struct match match = MATCH_CATCHALL_INITIALIZER;
+    match_set_in_port(&match, tun->ofport);
+    ovs_be64 mcast_bits = htonll((OVN_VXLAN_MIN_MULTICAST << 12));
+    match_set_tun_id_masked(&match, mcast_bits, mcast_bits);
+
+    put_load(1, MFF_LOG_OUTPORT, 15, 1, ofpacts);
+    put_move(MFF_TUN_ID, 12, MFF_LOG_OUTPORT,  0, 11, ofpacts);
+    put_move(MFF_TUN_ID, 0, MFF_LOG_DATAPATH, 0, 12, ofpacts);
+    put_resubmit(OFTABLE_LOCAL_OUTPUT, ofpacts);
+
+    ofctrl_add_flow(flow_table, OFTABLE_PHY_TO_LOG, 105, 0,
+                    &match, ofpacts, flow_uuid);
+}
+
+/* Handle ramp switch encapsulations, i.e., the packets received on the VXLAN
+ * tunnel 'tun' to the chassis of the vtep ports of 'chassis'. */
+static void
+add_ramp_switch_ingress_flows(const struct physical_ctx *ctx,
+                              const struct chassis_tunnel *tun,
+                              const struct sbrec_chassis *chassis,
+                              struct ofpbuf *ofpacts,
+                              struct ovn_desired_flow_table *flow_table,
+                              const struct uuid *flow_uuid)
+{
+    struct sbrec_port_binding *target =
+        sbrec_port_binding_index_init_row(
+            ctx->sbrec_port_binding_by_chassis);
+    sbrec_port_binding_index_set_chassis(target, chassis);
+
+    const struct sbrec_port_binding *binding;
+    SBREC_PORT_BINDING_FOR_EACH_EQUAL (binding, target,
+                                       ctx->sbrec_port_binding_by_chassis) {
+        if (strcmp(binding->type, "vtep")) {
             continue;
         }
 
-        /* Look up the chassis record and check if it's a remote chassis. */
-        const struct sbrec_chassis *remote_chassis =
-            chassis_lookup_by_name(ctx->sbrec_chassis_by_name, chassis_name);
-        free(chassis_name);
+        struct match match = MATCH_CATCHALL_INITIALIZER;
+        match_set_in_port(&match, tun->ofport);
+        ofpbuf_clear(ofpacts);
+
+        /* Add flows for ramp switches.  The VNI is used to populate
+         * MFF_LOG_DATAPATH.  The gateway's logical port is set to
+         * MFF_LOG_INPORT.  Then the packet is resubmitted to table 8
+         * to determine the logical egress port. */
+        match_set_tun_id(&match, htonll(binding->datapath->tunnel_key));
+
+        put_move(MFF_TUN_ID, 0,  MFF_LOG_DATAPATH, 0, 24, ofpacts);
+        put_load(binding->tunnel_key, MFF_LOG_INPORT, 0, 15, ofpacts);
+        /* For packets received from a ramp tunnel, set a flag to that
+         * effect. */
+        put_load(1, MFF_LOG_FLAGS, MLF_RCV_FROM_RAMP_BIT, 1, ofpacts);
+        put_resubmit(OFTABLE_LOG_INGRESS_PIPELINE, ofpacts);
+
+        ofctrl_add_flow(flow_table, OFTABLE_PHY_TO_LOG, 110,
+                        binding->header_.uuid.parts[0],
+                        &match, ofpacts, flow_uuid);
+    }
+    sbrec_port_binding_index_destroy_row(target);
+}
+
+/* Adds the flows for the packets received from the tunnels to the remote
+ * chassis named 'chassis_name'.  They are owned by a UUID of their own,
+ * so that they can be replaced when the tunnels to that chassis change.
+ * The previous version of the flows, if any, is removed. */
+static void
+physical_consider_chassis_tunnels(const struct physical_ctx *ctx,
+                                  const char *chassis_name,
+                                  struct ofpbuf *ofpacts,
+                                  struct ovn_desired_flow_table *flow_table)
+{
+    struct uuid *flow_uuid = shash_find_and_delete(&chassis_tunnel_flows,
+                                                   chassis_name);
+    if (flow_uuid) {
+        ofctrl_remove_flows(flow_table, flow_uuid);
+    } else {
+        flow_uuid = xmalloc(sizeof *flow_uuid);
+        uuid_generate(flow_uuid);
+    }
+
+    const struct sbrec_chassis *chassis =
+        chassis_lookup_by_name(ctx->sbrec_chassis_by_name, chassis_name);
+    bool has_tunnels = false;
 
-        if (!remote_chassis ||
-            !smap_get_bool(&remote_chassis->other_config,
-                           "is-remote", false)) {
+    struct chassis_tunnel *tun;
+    HMAP_FOR_EACH_WITH_HASH (tun, hmap_node, hash_string(chassis_name, 0),
+                             ctx->chassis_tunnels) {
+        if (!encaps_tunnel_id_match(tun->chassis_id, chassis_name,
+                                    NULL, NULL)) {
             continue;
         }
+        has_tunnels = true;
+
+        /* Process packets that arrive from a remote hypervisor (by matching
+         * on tunnel in_port). */
+        add_tunnel_ingress_flows(tun, ctx->mff_ovn_geneve, flow_table,
+                                 ofpacts, flow_uuid);
 
-        ofpbuf_clear(&ingress_ofpacts);
-        put_load(1, MFF_LOG_FLAGS, MLF_RX_FROM_TUNNEL_BIT, 1,
-                 &ingress_ofpacts);
-        put_decapsulation(ctx->mff_ovn_geneve, tun, &ingress_ofpacts);
-        put_resubmit(OFTABLE_LOG_INGRESS_PIPELINE, &ingress_ofpacts);
         if (tun->type == VXLAN) {
-            /* VXLAN doesn't carry the inport information, we cannot set
-             * the outport to 0 then and match on it. */
-            put_resubmit(OFTABLE_LOCAL_OUTPUT, &ingress_ofpacts);
+            add_vxlan_multicast_ingress_flow(tun, ofpacts, flow_table,
+                                             flow_uuid);
+            if (chassis) {
+                add_ramp_switch_ingress_flows(ctx, tun, chassis, ofpacts,
+                                              flow_table, flow_uuid);
+            }
         }
 
-        /* Add match on ARP response coming from remote chassis. */
-        match_init_catchall(&match);
-        match_set_in_port(&match, tun->ofport);
-        match_set_dl_type(&match, htons(ETH_TYPE_ARP));
-        match_set_arp_opcode_masked(&match, 2, UINT8_MAX);
-        match_set_chassis_flood_outport(&match, tun->type,
-                                        ctx->mff_ovn_geneve);
-
-        ofctrl_add_flow(flow_table, OFTABLE_PHY_TO_LOG, 120,
-                        remote_chassis->header_.uuid.parts[0],
-                        &match, &ingress_ofpacts, hc_uuid);
-
-        /* Add match on ND NA coming from remote chassis. */
-        match_init_catchall(&match);
-        match_set_in_port(&match, tun->ofport);
-        match_set_dl_type(&match, htons(ETH_TYPE_IPV6));
-        match_set_nw_proto(&match, IPPROTO_ICMPV6);
-        match_set_icmp_type(&match, 136);
-        match_set_icmp_code(&match, 0);
-        match_set_chassis_flood_outport(&match, tun->type,
-                                        ctx->mff_ovn_geneve);
-
-        ofctrl_add_flow(flow_table, OFTABLE_PHY_TO_LOG, 120,
-                        remote_chassis->header_.uuid.parts[0],
-                        &match, &ingress_ofpacts, hc_uuid);
+        if (chassis_is_remote(chassis)) {
+            add_remote_chassis_ingress_flows(ctx, tun, chassis, ofpacts,
+                                             flow_table, flow_uuid);
+        }
     }
 
-    ofpbuf_uninit(&ingress_ofpacts);
+    if (has_tunnels) {
+        shash_add(&chassis_tunnel_flows, chassis_name, flow_uuid);
+    } else {
+        free(flow_uuid);
+    }
 }
 
 struct vni_local_ip {
@@ -3781,6 +3924,9 @@ physical_handle_flows_for_lport(const struct sbrec_port_binding *pb,
     }
 
     ofctrl_remove_flows(flow_table, &pb->header_.uuid);
+    if (removed) {
+        objdep_mgr_remove_obj(p_ctx->chassis_deps_mgr, &pb->header_.uuid);
+    }
 
     struct local_datapath *ldp =
         get_local_datapath(p_ctx->local_datapaths,
@@ -3873,6 +4019,7 @@ physical_handle_mc_group_changes(struct physical_ctx *p_ctx,
     SBREC_MULTICAST_GROUP_TABLE_FOR_EACH_TRACKED (mc, p_ctx->mc_group_table) {
         if (sbrec_multicast_group_is_deleted(mc)) {
             ofctrl_remove_flows(flow_table, &mc->header_.uuid);
+            objdep_mgr_remove_obj(p_ctx->chassis_deps_mgr, &mc->header_.uuid);
         } else {
             if (!sbrec_multicast_group_is_new(mc)) {
                 ofctrl_remove_flows(flow_table, &mc->header_.uuid);
@@ -3882,6 +4029,147 @@ physical_handle_mc_group_changes(struct physical_ctx *p_ctx,
     }
 }
 
+/* Adds to 'objs' the port bindings and multicast groups whose flows use the
+ * tunnels to the chassis named 'chassis_name'. */
+static void
+collect_chassis_deps(const struct physical_ctx *p_ctx,
+                     const char *chassis_name, struct uuidset *objs)
+{
+    struct resource_to_objects_node *res_node =
+        objdep_mgr_find_objs(p_ctx->chassis_deps_mgr, OBJDEP_TYPE_CHASSIS,
+                             chassis_name);
+    if (!res_node) {
+        return;
+    }
+
+    struct objdep_obj_ref *ref;
+    RESOURCE_FOR_EACH_OBJ (ref, res_node) {
+        uuidset_insert(objs, &ref->obj_node->obj_uuid);
+    }
+}
+
+/* Re-evaluates the flows of the port bindings and multicast groups in
+ * 'objs'. */
+static void
+reprocess_chassis_deps(struct physical_ctx *p_ctx,
+                       const struct uuidset *objs,
+                       struct ovn_desired_flow_table *flow_table)
+{
+    const struct uuidset_node *node;
+    UUIDSET_FOR_EACH (node, objs) {
+        ofctrl_remove_flows(flow_table, &node->uuid);
+
+        const struct sbrec_port_binding *pb =
+            sbrec_port_binding_table_get_for_uuid(p_ctx->port_binding_table,
+                                                  &node->uuid);
+        if (pb) {
+            physical_eval_port_binding(p_ctx, pb, get_lport_type(pb),
+                                       flow_table);
+            continue;
+        }
+
+        const struct sbrec_multicast_group *mc =
+            sbrec_multicast_group_table_get_for_uuid(p_ctx->mc_group_table,
+                                                     &node->uuid);
+        if (mc) {
+            consider_mc_group(p_ctx, mc, flow_table);
+        } else {
+            objdep_mgr_remove_obj(p_ctx->chassis_deps_mgr, &node->uuid);
+        }
+    }
+}
+
+/* Re-evaluates the physical flows that depend on the encapsulation of the
+ * remote chassis in 'chassis_names', i.e., the flows of the ports bound or
+ * redirected to those chassis and of the multicast groups that tunnel to
+ * them.  They are looked up in 'p_ctx->chassis_deps_mgr'. */
+void
+physical_handle_remote_chassis_changes(
+    struct physical_ctx *p_ctx, const struct sset *chassis_names,
+    struct ovn_desired_flow_table *flow_table)
+{
+    struct uuidset objs = UUIDSET_INITIALIZER(&objs);
+    const char *chassis_name;
+    SSET_FOR_EACH (chassis_name, chassis_names) {
+        collect_chassis_deps(p_ctx, chassis_name, &objs);
+    }
+    reprocess_chassis_deps(p_ctx, &objs, flow_table);
+    uuidset_destroy(&objs);
+}
+
+/* Updates the physical flows after the tunnels to the remote chassis in
+ * 'chassis_names' were added, removed or updated: the flows of the tunnels
+ * themselves, the flood flow to the remote chassis and the flows of the
+ * port bindings and multicast groups that use those tunnels.  Network
+ * function ports use every tunnel, so they are always re-evaluated. */
+void
+physical_handle_tunnel_changes(struct physical_ctx *p_ctx,
+                               const struct sset *chassis_names,
+                               struct ovn_desired_flow_table *flow_table)
+{
+    struct ofpbuf ofpacts;
+    ofpbuf_init(&ofpacts, 0);
+
+    struct uuidset objs = UUIDSET_INITIALIZER(&objs);
+    bool update_flood = false;
+    const char *chassis_name;
+    SSET_FOR_EACH (chassis_name, chassis_names) {
+        physical_consider_chassis_tunnels(p_ctx, chassis_name, &ofpacts,
+                                          flow_table);
+        update_flood |= remote_chassis_flood_uses(p_ctx, chassis_name);
+        collect_chassis_deps(p_ctx, chassis_name, &objs);
+    }
+    if (update_flood) {
+        physical_eval_remote_chassis_flood(p_ctx, &ofpacts, flow_table);
+    }
+
+    collect_chassis_deps(p_ctx, "", &objs);
+    reprocess_chassis_deps(p_ctx, &objs, flow_table);
+
+    uuidset_destroy(&objs);
+    ofpbuf_uninit(&ofpacts);
+}
+
+/* Updates the physical flows after SB Chassis records of remote chassis were
+ * created, deleted or updated: the flows that match on their chassis macs
+ * and the ones that depend on their "is-remote" option.  The flows of the
+ * port bindings that refer to those chassis are updated through their own
+ * changes. */
+void
+physical_handle_chassis_changes(struct physical_ctx *p_ctx,
+                                struct ovn_desired_flow_table *flow_table)
+{
+    struct ofpbuf ofpacts;
+    ofpbuf_init(&ofpacts, 0);
+
+    bool update_flood = false;
+    const struct sbrec_chassis *chassis;
+    SBREC_CHASSIS_TABLE_FOR_EACH_TRACKED (chassis, p_ctx->chassis_table) {
+        if (!strcmp(chassis->name, p_ctx->chassis->name)) {
+            continue;
+        }
+
+        bool deleted = sbrec_chassis_is_deleted(chassis);
+        ofctrl_remove_flows(flow_table, &chassis->header_.uuid);
+        if (!deleted) {
+            put_chassis_mac_conj_id_flows(chassis, &ofpacts, flow_table);
+        }
+
+        if (deleted || sbrec_chassis_is_new(chassis)
+            || sbrec_chassis_is_updated(chassis,
+                                        SBREC_CHASSIS_COL_OTHER_CONFIG)) {
+            physical_consider_chassis_tunnels(p_ctx, chassis->name, &ofpacts,
+                                              flow_table);
+            update_flood |= remote_chassis_flood_uses(p_ctx, chassis->name);
+        }
+    }
+    if (update_flood) {
+        physical_eval_remote_chassis_flood(p_ctx, &ofpacts, flow_table);
+    }
+
+    ofpbuf_uninit(&ofpacts);
+}
+
 void
 physical_handle_evpn_binding_changes(
     struct physical_ctx *ctx, struct ovn_desired_flow_table *flow_table,
@@ -3992,12 +4280,22 @@ physical_run(struct physical_ctx *p_ctx,
         hc_uuid = xmalloc(sizeof(struct uuid));
         uuid_generate(hc_uuid);
     }
+    if (!remote_flood_uuid) {
+        remote_flood_uuid = xmalloc(sizeof(struct uuid));
+        uuid_generate(remote_flood_uuid);
+    }
+    shash_clear_free_data(&chassis_tunnel_flows);
 
     struct ofpbuf ofpacts;
     ofpbuf_init(&ofpacts, 0);
 
-    put_chassis_mac_conj_id_flow(p_ctx->chassis_table, p_ctx->chassis,
-                                 &ofpacts, flow_table);
+    const struct sbrec_chassis *chassis;
+    SBREC_CHASSIS_TABLE_FOR_EACH (chassis, p_ctx->chassis_table) {
+        /* We want only remote chassis macs. */
+        if (strcmp(chassis->name, p_ctx->chassis->name)) {
+            put_chassis_mac_conj_id_flows(chassis, &ofpacts, flow_table);
+        }
+    }
 
     /* Set up flows in table 0 for physical-to-logical translation and in table
      * 64 for logical-to-physical translation. */
@@ -4033,11 +4331,21 @@ physical_run(struct physical_ctx *p_ctx,
      * We set MFF_LOG_DATAPATH, MFF_LOG_INPORT, and MFF_LOG_OUTPORT from the
      * tunnel key data where possible, then resubmit to table 45 to handle
      * packets to the local hypervisor. */
+    struct sset tunnel_chassis = SSET_INITIALIZER(&tunnel_chassis);
     struct chassis_tunnel *tun;
     HMAP_FOR_EACH (tun, hmap_node, p_ctx->chassis_tunnels) {
-        add_tunnel_ingress_flows(tun, p_ctx->mff_ovn_geneve, flow_table,
-                                 &ofpacts);
+        char *chassis_name = NULL;
+        if (encaps_tunnel_id_parse(tun->chassis_id, &chassis_name,
+                                   NULL, NULL)) {
+            sset_add_and_free(&tunnel_chassis, chassis_name);
+        }
+    }
+    const char *chassis_name;
+    SSET_FOR_EACH (chassis_name, &tunnel_chassis) {
+        physical_consider_chassis_tunnels(p_ctx, chassis_name, &ofpacts,
+                                          flow_table);
     }
+    sset_destroy(&tunnel_chassis);
 
     /* Process packets that arrive from flow-based tunnels. */
     if (p_ctx->use_flow_based_tunnels && p_ctx->flow_tunnels) {
@@ -4060,69 +4368,7 @@ physical_run(struct physical_ctx *p_ctx,
                      i == GENEVE ? "geneve" : "vxlan");
 
             add_tunnel_ingress_flows(&temp_tunnel, p_ctx->mff_ovn_geneve,
-                                     flow_table, &ofpacts);
-        }
-    }
-
-    /* Add VXLAN specific rules to transform port keys
-     * from 12 bits to 16 bits used elsewhere. */
-    HMAP_FOR_EACH (tun, hmap_node, p_ctx->chassis_tunnels) {
-        if (tun->type == VXLAN) {
-            ofpbuf_clear(&ofpacts);
-
-            struct match match = MATCH_CATCHALL_INITIALIZER;
-            match_set_in_port(&match, tun->ofport);
-            ovs_be64 mcast_bits = htonll((OVN_VXLAN_MIN_MULTICAST << 12));
-            match_set_tun_id_masked(&match, mcast_bits, mcast_bits);
-
-            put_load(1, MFF_LOG_OUTPORT, 15, 1, &ofpacts);
-            put_move(MFF_TUN_ID, 12, MFF_LOG_OUTPORT,  0, 11, &ofpacts);
-            put_move(MFF_TUN_ID, 0, MFF_LOG_DATAPATH, 0, 12, &ofpacts);
-            put_resubmit(OFTABLE_LOCAL_OUTPUT, &ofpacts);
-
-            ofctrl_add_flow(flow_table, OFTABLE_PHY_TO_LOG, 105, 0,
-                            &match, &ofpacts, hc_uuid);
-        }
-    }
-
-    /* Handle ramp switch encapsulations. */
-    HMAP_FOR_EACH (tun, hmap_node, p_ctx->chassis_tunnels) {
-        if (tun->type != VXLAN) {
-            continue;
-        }
-
-        SBREC_PORT_BINDING_TABLE_FOR_EACH (binding,
-                                           p_ctx->port_binding_table) {
-            if (strcmp(binding->type, "vtep")) {
-                continue;
-            }
-
-            if (!binding->chassis ||
-                !encaps_tunnel_id_match(tun->chassis_id,
-                                        binding->chassis->name, NULL, NULL)) {
-                continue;
-            }
-
-            struct match match = MATCH_CATCHALL_INITIALIZER;
-            match_set_in_port(&match, tun->ofport);
-            ofpbuf_clear(&ofpacts);
-
-            /* Add flows for ramp switches.  The VNI is used to populate
-             * MFF_LOG_DATAPATH.  The gateway's logical port is set to
-             * MFF_LOG_INPORT.  Then the packet is resubmitted to table 8
-             * to determine the logical egress port. */
-            match_set_tun_id(&match, htonll(binding->datapath->tunnel_key));
-
-            put_move(MFF_TUN_ID, 0,  MFF_LOG_DATAPATH, 0, 24, &ofpacts);
-            put_load(binding->tunnel_key, MFF_LOG_INPORT, 0, 15, &ofpacts);
-            /* For packets received from a ramp tunnel, set a flag to that
-             * effect. */
-            put_load(1, MFF_LOG_FLAGS, MLF_RCV_FROM_RAMP_BIT, 1, &ofpacts);
-            put_resubmit(OFTABLE_LOG_INGRESS_PIPELINE, &ofpacts);
-
-            ofctrl_add_flow(flow_table, OFTABLE_PHY_TO_LOG, 110,
-                            binding->header_.uuid.parts[0],
-                            &match, &ofpacts, hc_uuid);
+                                     flow_table, &ofpacts, hc_uuid);
         }
     }
 
@@ -4352,7 +4598,7 @@ physical_run(struct physical_ctx *p_ctx,
     ofctrl_add_flow(flow_table, OFTABLE_CT_STATE_SAVE, UINT16_MAX, 0,
                     &match, &ofpacts, hc_uuid);
 
-    physical_eval_remote_chassis_flows(p_ctx, &ofpacts, flow_table);
+    physical_eval_remote_chassis_flood(p_ctx, &ofpacts, flow_table);
     physical_eval_evpn_flows(p_ctx, &ofpacts, flow_table);
 
     /* Default flow for OFTABLE_GET_FDB table. */
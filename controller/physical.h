@@ -28,6 +28,7 @@
 #include "openvswitch/meta-flow.h"
 
 struct hmap;
+struct objdep_mgr;
 struct ovsdb_idl_index;
 struct ovsrec_bridge;
 struct ovn_extend_table;
@@ -52,6 +53,7 @@ struct physical_debug {
 struct physical_ctx {
     struct ovsdb_idl_index *sbrec_port_binding_by_name;
     struct ovsdb_idl_index *sbrec_port_binding_by_datapath;
+    struct ovsdb_idl_index *sbrec_port_binding_by_chassis;
     struct ovsdb_idl_index *sbrec_chassis_by_name;
     const struct sbrec_port_binding_table *port_binding_table;
     const struct ovsrec_interface_table *ovs_interface_table;
@@ -79,6 +81,11 @@ struct physical_ctx {
     const struct hmap *evpn_arps;
     struct ovn_extend_table *group_table;
 
+    /* Maps the name of a remote chassis (OBJDEP_TYPE_CHASSIS) to the port
+     * bindings and multicast groups whose flows use the tunnels to that
+     * chassis.  The empty name is used by flows that use every tunnel. */
+    struct objdep_mgr *chassis_deps_mgr;
+
     /* Set of port binding names that have been already reprocessed during
      * the I-P run. */
     struct sset reprocessed_pbs;
@@ -96,6 +103,14 @@ bool physical_handle_flows_for_lport(const struct sbrec_port_binding *,
 void physical_multichassis_reprocess(const struct sbrec_port_binding *,
                                      struct physical_ctx *,
                                      struct ovn_desired_flow_table *);
+void physical_handle_remote_chassis_changes(
+    struct physical_ctx *, const struct sset *chassis_names,
+    struct ovn_desired_flow_table *);
+void physical_handle_tunnel_changes(struct physical_ctx *,
+                                    const struct sset *chassis_names,
+                                    struct ovn_desired_flow_table *);
+void physical_handle_chassis_changes(struct physical_ctx *,
+                                     struct ovn_desired_flow_table *);
 void physical_handle_evpn_binding_changes(
     struct physical_ctx *, struct ovn_desired_flow_table *,
     const struct hmapx *updated_bindings,
@@ -65,6 +65,8 @@
 #include "ovn-sb-idl.h"
 #include "ovn-dns.h"
 #include "garp_rarp.h"
+#include "heap.h"
+#include "token-bucket.h"
 
 VLOG_DEFINE_THIS_MODULE(pinctrl);
 
@@ -119,6 +121,11 @@ VLOG_DEFINE_THIS_MODULE(pinctrl);
  *                      ip_mcast_snoop_run() which runs in the
  *                      pinctrl_handler() thread configures the per datapath
  *                      mcast_snoop_map entries according to mcast_cfg_map.
+ *                      Entries whose groups changed are marked 'dirty' by
+ *                      pinctrl_handler, or by ip_mcast_sync() when their
+ *                      records are changed by someone else, and only those
+ *                      are written back to the 'IGMP_Group' table, with a
+ *                      periodic full sync to repair any other divergence.
  *
  * pinctrl module also periodically sends IPv6 Router Solicitation requests
  * and gARPs (for the router gateway IPs and configured NAT addresses).
@@ -187,6 +194,8 @@ static struct pinctrl pinctrl;
 static bool pinctrl_is_sb_commited(int64_t commit_cfg, int64_t cur_cfg);
 static void init_buffered_packets_map(void);
 static void destroy_buffered_packets_map(void);
+static void buffered_packets_config_run(
+    const struct ovsrec_open_vswitch_table *ovs_table);
 static void
 run_buffered_binding(const struct sbrec_mac_binding_table *mac_binding_table,
                      const struct hmap *local_datapaths,
@@ -285,7 +294,8 @@ static void ip_mcast_sync(
     struct ovsdb_idl_index *sbrec_datapath_binding_by_key,
     struct ovsdb_idl_index *sbrec_port_binding_by_key,
     struct ovsdb_idl_index *sbrec_igmp_groups,
-    struct ovsdb_idl_index *sbrec_ip_multicast)
+    struct ovsdb_idl_index *sbrec_ip_multicast,
+    const struct sbrec_igmp_group_table *igmp_group_table)
     OVS_REQUIRES(pinctrl_mutex);
 static void pinctrl_ip_mcast_handle(
     struct rconn *swconn,
@@ -384,6 +394,7 @@ static void set_from_ctrl_flag_in_pkt_metadata(struct ofputil_packet_in *);
 COVERAGE_DEFINE(pinctrl_drop_put_mac_binding);
 COVERAGE_DEFINE(pinctrl_drop_put_fdb);
 COVERAGE_DEFINE(pinctrl_drop_buffered_packets_map);
+COVERAGE_DEFINE(pinctrl_announce_paced);
 COVERAGE_DEFINE(pinctrl_drop_controller_event);
 COVERAGE_DEFINE(pinctrl_drop_put_vport_binding);
 COVERAGE_DEFINE(pinctrl_notify_main_thread);
@@ -1575,18 +1586,41 @@ prepare_ipv6_prefixd(struct ovsdb_idl_txn *ovnsb_idl_txn,
     }
 }
 
-static struct cmap buffered_packets_map;
+static struct buffered_packets_ctx buffered_packets_ctx;
 
 static void
 init_buffered_packets_map(void)
 {
-    cmap_init(&buffered_packets_map);
+    buffered_packets_ctx_init(&buffered_packets_ctx);
 }
 
 static void
 destroy_buffered_packets_map(void)
 {
-    buffered_packets_map_destroy(&buffered_packets_map);
+    buffered_packets_ctx_destroy(&buffered_packets_ctx);
+}
+
+/* Called by pinctrl_run(). Runs with in the main ovn-controller
+ * thread context. */
+static void
+buffered_packets_config_run(const struct ovsrec_open_vswitch_table *ovs_table)
+{
+    uint64_t max_kb = BUFFERED_PACKETS_DEF_MAX_KB;
+    const struct ovsrec_open_vswitch *cfg =
+        ovsrec_open_vswitch_table_first(ovs_table);
+
+    if (cfg) {
+        max_kb = smap_get_ullong(&cfg->external_ids,
+                                 "ovn-memlimit-buffered-packets-kb",
+                                 BUFFERED_PACKETS_DEF_MAX_KB);
+    }
+    buffered_packets_ctx_set_max_bytes(&buffered_packets_ctx, max_kb * 1024);
+}
+
+void
+pinctrl_get_memory_usage(struct simap *usage)
+{
+    buffered_packets_ctx_get_memory_usage(&buffered_packets_ctx, usage);
 }
 
 /* Called with in the pinctrl_handler thread context. */
@@ -1610,14 +1644,18 @@ pinctrl_handle_buffered_packets(const struct ofputil_packet_in *pin,
                           md->flow.regs[MFF_LOG_OUTPORT - MFF_REG0],
                           ip, eth_addr_zero);
 
-    struct buffered_packets *bp = buffered_packets_add(&buffered_packets_map,
+    struct buffered_packets *bp = buffered_packets_add(&buffered_packets_ctx,
                                                        mb_data);
     if (!bp) {
         COVERAGE_INC(pinctrl_drop_buffered_packets_map);
         return;
     }
 
-    buffered_packets_packet_data_enqueue(bp, pin, continuation);
+    if (!buffered_packets_packet_data_enqueue(&buffered_packets_ctx, bp, pin,
+                                              continuation)) {
+        COVERAGE_INC(pinctrl_drop_buffered_packets_map);
+        return;
+    }
 
     /* There is a chance that the MAC binding was already created. */
     notify_pinctrl_main();
@@ -4194,6 +4232,7 @@ pinctrl_run(struct ovsdb_idl_txn *ovnsb_idl_txn,
             const struct sbrec_mac_binding_table *mac_binding_table,
             const struct sbrec_bfd_table *bfd_table,
             const struct sbrec_ecmp_nexthop_table *ecmp_nh_table,
+            const struct sbrec_igmp_group_table *igmp_group_table,
             const struct sbrec_chassis *chassis,
             const struct hmap *local_datapaths,
             const struct shash *local_active_ports_ipv6_pd,
@@ -4211,6 +4250,7 @@ pinctrl_run(struct ovsdb_idl_txn *ovnsb_idl_txn,
     run_put_vport_bindings(ovnsb_idl_txn, sbrec_datapath_binding_by_key,
                            sbrec_port_binding_by_key, chassis, cur_cfg);
     send_garp_rarp_prepare(ecmp_nh_table, chassis, ovs_table);
+    buffered_packets_config_run(ovs_table);
     prepare_ipv6_ras(local_active_ports_ras, sbrec_port_binding_by_name);
     prepare_ipv6_prefixd(ovnsb_idl_txn, sbrec_port_binding_by_name,
                          local_active_ports_ipv6_pd, chassis,
@@ -4220,7 +4260,8 @@ pinctrl_run(struct ovsdb_idl_txn *ovnsb_idl_txn,
                   sbrec_datapath_binding_by_key,
                   sbrec_port_binding_by_key,
                   sbrec_igmp_groups,
-                  sbrec_ip_multicast_opts);
+                  sbrec_ip_multicast_opts,
+                  igmp_group_table);
     sync_svc_monitors(ovnsb_idl_txn, svc_mon_table, sbrec_port_binding_by_name,
                       chassis);
     bfd_monitor_run(ovnsb_idl_txn, bfd_table, sbrec_port_binding_by_name,
@@ -4847,13 +4888,13 @@ send_mac_binding_buffered_pkts(struct rconn *swconn)
     enum ofputil_protocol proto = ofputil_protocol_from_ofp_version(version);
     struct vector rpd = VECTOR_EMPTY_INITIALIZER(struct bp_packet_data);
 
-    buffered_packets_run(&buffered_packets_map, &rpd);
+    buffered_packets_run(&buffered_packets_ctx, &rpd);
 
     struct bp_packet_data *pd;
     VECTOR_FOR_EACH_PTR (&rpd, pd) {
         queue_msg(swconn, ofputil_encode_resume(&pd->pin, pd->continuation,
                                                 proto));
-        bp_packet_data_destroy(pd);
+        bp_packet_data_destroy(&buffered_packets_ctx, pd);
     }
 
     vector_destroy(&rpd);
@@ -4926,7 +4967,7 @@ run_buffered_binding(const struct sbrec_mac_binding_table *mac_binding_table,
                      struct ovsdb_idl_index *sbrec_port_binding_by_name,
                      struct ovsdb_idl_index *sbrec_mac_binding_by_lport_ip)
 {
-    if (cmap_is_empty(&buffered_packets_map)) {
+    if (cmap_is_empty(&buffered_packets_ctx.map)) {
         return;
     }
 
@@ -4972,7 +5013,7 @@ run_buffered_binding(const struct sbrec_mac_binding_table *mac_binding_table,
         mac_binding_add(&recent_mbs, mb_data, smb, 0);
     }
 
-    if (buffered_packets_lookup_run(&buffered_packets_map, &recent_mbs,
+    if (buffered_packets_lookup_run(&buffered_packets_ctx, &recent_mbs,
                                     sbrec_port_binding_by_key,
                                     sbrec_datapath_binding_by_key,
                                     sbrec_port_binding_by_name,
@@ -5006,6 +5047,7 @@ wait_put_mac_bindings(void)
 
 struct arp_nd_data {
     struct hmap_node hmap_node;
+    struct heap_node heap_node;  /* In 'send_arp_nd_heap'. */
     struct eth_addr ea;          /* Ethernet address of port. */
     struct in6_addr src_ip;      /* IP address of port. */
     struct in6_addr dst_ip;      /* Destination IP address */
@@ -5017,11 +5059,96 @@ struct arp_nd_data {
 };
 
 static struct hmap send_arp_nd_data;
+/* 'struct arp_nd_data' ordered by their next announcement time. */
+static struct heap send_arp_nd_heap;
+
+/* GARP/RARP nodes ordered by their next announcement time, rebuilt from
+ * garp_rarp_get_data() whenever its sequence number changes.
+ * pinctrl_handler thread only. */
+static struct heap send_garp_rarp_heap;
+static uint64_t send_garp_rarp_heap_seqno;
+
+/* GARP/RARP and ARP/ND announcements are paced with a token bucket, so
+ * that a large number of due announcements is spread over time instead of
+ * being sent in a single burst.  Each announcement costs ANNOUNCE_TOKENS
+ * tokens and the bucket is refilled with 'announce_max_rate' tokens per
+ * msec, i.e., at most 'announce_max_rate' announcements are sent per second,
+ * with bursts of up to a tenth of that.  A rate of 0 disables pacing. */
+#define ANNOUNCE_TOKENS 1000
+#define ANNOUNCE_DEF_MAX_RATE 1000
+
+/* Set by the main thread, read by the pinctrl_handler thread. */
+static atomic_uint announce_max_rate = ANNOUNCE_DEF_MAX_RATE;
+
+/* pinctrl_handler thread only. */
+static struct token_bucket announce_tb;
+static unsigned int announce_tb_rate;
+
+/* Converts an announcement time into a heap priority, the earliest
+ * announcement has the highest priority. */
+static uint64_t
+announce_time_to_priority(long long int announce_time)
+{
+    return LLONG_MAX - announce_time;
+}
+
+static long long int
+announce_time_from_priority(uint64_t priority)
+{
+    return LLONG_MAX - priority;
+}
+
+/* Returns 'backoff' with up to 1/8 of random jitter added, to spread
+ * announcements scheduled at the same time. */
+static long long int
+announce_backoff_jitter(int backoff)
+{
+    return backoff + random_range(backoff / 8 + 1);
+}
+
+/* Called with in the pinctrl_handler thread context.
+ *
+ * Returns true if one more announcement may be sent now, false if the
+ * announcement rate limit was reached. */
+static bool
+announce_withdraw(void)
+{
+    unsigned int rate;
+    atomic_read_relaxed(&announce_max_rate, &rate);
+    if (rate != announce_tb_rate) {
+        token_bucket_init(&announce_tb, rate,
+                          MAX(rate / 10, 1) * ANNOUNCE_TOKENS);
+        announce_tb_rate = rate;
+    }
+
+    if (!rate || token_bucket_withdraw(&announce_tb, ANNOUNCE_TOKENS)) {
+        return true;
+    }
+    COVERAGE_INC(pinctrl_announce_paced);
+    return false;
+}
+
+/* Called with in the pinctrl_handler thread context.
+ *
+ * Wakes up the pinctrl_handler thread when the announcement due at
+ * 'announce_time' can be sent, taking the rate limit into account. */
+static void
+announce_wait(long long int announce_time)
+{
+    if (announce_tb_rate && announce_time <= time_msec()) {
+        token_bucket_wait(&announce_tb, ANNOUNCE_TOKENS);
+    } else {
+        poll_timer_wait_until(announce_time);
+    }
+}
 
 static void
 init_send_arps_nds(void)
 {
     hmap_init(&send_arp_nd_data);
+    heap_init(&send_arp_nd_heap);
+    heap_init(&send_garp_rarp_heap);
+    send_garp_rarp_heap_seqno = 0;
 }
 
 static void
@@ -5032,6 +5159,8 @@ destroy_send_arps_nds(void)
         free(e);
     }
     hmap_destroy(&send_arp_nd_data);
+    heap_destroy(&send_arp_nd_heap);
+    heap_destroy(&send_garp_rarp_heap);
 }
 
 static uint32_t
@@ -5080,6 +5209,8 @@ arp_nd_alloc_data(const struct eth_addr ea,
 
     uint32_t hash = arp_nd_data_get_hash(&e->dst_ip, e->dp_key, e->port_key);
     hmap_insert(&send_arp_nd_data, &e->hmap_node, hash);
+    heap_insert(&send_arp_nd_heap, &e->heap_node,
+                announce_time_to_priority(e->announce_time));
     notify_pinctrl_handler();
 
     return e;
@@ -5107,9 +5238,13 @@ arp_nd_sync_data(const struct sbrec_ecmp_nexthop_table *ecmp_nh_table)
         }
     }
 
-    destroy_send_arps_nds();
-    init_send_arps_nds();
+    struct arp_nd_data *e;
+    HMAP_FOR_EACH_POP (e, hmap_node, &send_arp_nd_data) {
+        heap_remove(&send_arp_nd_heap, &e->heap_node);
+        free(e);
+    }
     hmap_swap(&arp_nd_active, &send_arp_nd_data);
+    hmap_destroy(&arp_nd_active);
 }
 
 
@@ -5144,6 +5279,8 @@ send_arp_nd_update(const struct sbrec_port_binding *pb, const char *nexthop,
         /* reset backoff */
         e->announce_time = time_msec() + 1000;
         e->backoff = 1000; /* msec. */
+        heap_change(&send_arp_nd_heap, &e->heap_node,
+                    announce_time_to_priority(e->announce_time));
         notify_pinctrl_handler();
     }
 }
@@ -5235,7 +5372,7 @@ send_garp_rarp(struct rconn *swconn, struct garp_rarp_node *garp_rarp,
      * vif if garp_rarp_max_timeout is not specified otherwise cap the max
      * timeout to garp_rarp_max_timeout. */
     if (continuous || backoff < max_timeout) {
-        announce_time = current_time + backoff;
+        announce_time = current_time + announce_backoff_jitter(backoff);
     } else {
         announce_time = LLONG_MAX;
     }
@@ -5342,6 +5479,11 @@ struct ip_mcast_snoop {
     int64_t dp_key;                /* Datapath running the snooping. */
 
     long long int query_time_ms;   /* Next query time in ms. */
+
+    atomic_bool dirty;             /* Set by pinctrl_handler when groups,
+                                    * mrouters or config changed, cleared
+                                    * by ip_mcast_sync(). */
+    bool needs_sync;               /* Only used by ip_mcast_sync(). */
 };
 
 /*
@@ -5379,6 +5521,15 @@ static struct ovs_list mcast_query_list;
  */
 static struct hmap mcast_cfg_map OVS_GUARDED_BY(pinctrl_mutex);
 
+/* Interval between full IGMP_Group syncs.  In between, ip_mcast_sync()
+ * only writes the groups of datapaths marked dirty by pinctrl_handler. */
+#define IP_MCAST_FULL_SYNC_INTERVAL_MS (60 * 1000)
+
+/* Only accessed by pinctrl_main. */
+static long long int ip_mcast_next_full_sync;
+static const struct sbrec_chassis *ip_mcast_sync_chassis;
+static bool ip_mcast_sync_protocol;
+
 static void
 ip_mcast_snoop_cfg_load(struct ip_mcast_snoop_cfg *cfg,
                         const struct sbrec_ip_multicast *ip_mcast)
@@ -5553,6 +5704,12 @@ ip_mcast_snoop_state_remove(struct ip_mcast_snoop_state *ms_state)
     free(ms_state);
 }
 
+static void
+ip_mcast_snoop_set_dirty(struct ip_mcast_snoop *ip_ms)
+{
+    atomic_store_relaxed(&ip_ms->dirty, true);
+}
+
 static bool
 ip_mcast_snoop_enable(struct ip_mcast_snoop *ip_ms)
 {
@@ -5643,6 +5800,7 @@ ip_mcast_snoop_add(int64_t dp_key, const struct ip_mcast_snoop_cfg *cfg)
     struct ip_mcast_snoop *ip_ms = xzalloc(sizeof *ip_ms);
 
     ip_ms->dp_key = dp_key;
+    atomic_init(&ip_ms->dirty, true);
     if (!ip_mcast_snoop_configure(ip_ms, cfg)) {
         free(ip_ms);
         return NULL;
@@ -5720,19 +5878,23 @@ ip_mcast_snoop_run(void)
      */
     struct ip_mcast_snoop_state *ip_ms_state;
 
+    bool notify = false;
+
     HMAP_FOR_EACH (ip_ms_state, hmap_node, &mcast_cfg_map) {
         ip_ms = ip_mcast_snoop_find(ip_ms_state->dp_key);
 
         if (!ip_ms) {
-            ip_mcast_snoop_add(ip_ms_state->dp_key, &ip_ms_state->cfg);
+            if (ip_mcast_snoop_add(ip_ms_state->dp_key, &ip_ms_state->cfg)) {
+                notify = true;
+            }
         } else if (memcmp(&ip_ms_state->cfg, &ip_ms->cfg,
                           sizeof ip_ms_state->cfg)) {
             ip_mcast_snoop_configure(ip_ms, &ip_ms_state->cfg);
+            ip_mcast_snoop_set_dirty(ip_ms);
+            notify = true;
         }
     }
 
-    bool notify = false;
-
     /* Then walk the multicast snoop instances. */
     HMAP_FOR_EACH_SAFE (ip_ms, hmap_node, &mcast_snoop_map) {
 
@@ -5745,6 +5907,7 @@ ip_mcast_snoop_run(void)
         /* If enabled run the snooping instance to timeout old groups. */
         if (ip_ms->cfg.enabled) {
             if (mcast_snooping_run(ip_ms->ms)) {
+                ip_mcast_snoop_set_dirty(ip_ms);
                 notify = true;
             }
 
@@ -5776,6 +5939,34 @@ ip_mcast_flush_groups(int64_t dp_key, const struct sbrec_chassis *chassis,
     }
 }
 
+/* IGMP_Group records of 'chassis' are only supposed to be written by
+ * ip_mcast_sync(), but they can still be deleted or changed by others, e.g.,
+ * by an administrator.  Marks the datapaths of such records dirty so that
+ * they are repaired by the next ip_mcast_sync() instead of waiting for the
+ * next full sync.  Changes caused by our own writes show up here too, the
+ * resulting sync of their datapaths finds nothing left to write. */
+static void
+ip_mcast_handle_igmp_group_changes(
+    const struct sbrec_igmp_group_table *igmp_group_table,
+    const struct sbrec_chassis *chassis)
+    OVS_REQUIRES(pinctrl_mutex)
+{
+    const struct sbrec_igmp_group *sbrec_igmp;
+
+    SBREC_IGMP_GROUP_TABLE_FOR_EACH_TRACKED (sbrec_igmp, igmp_group_table) {
+        if (sbrec_igmp_group_is_new(sbrec_igmp)
+            || sbrec_igmp->chassis != chassis || !sbrec_igmp->datapath) {
+            continue;
+        }
+
+        struct ip_mcast_snoop *ip_ms =
+            ip_mcast_snoop_find(sbrec_igmp->datapath->tunnel_key);
+        if (ip_ms) {
+            ip_mcast_snoop_set_dirty(ip_ms);
+        }
+    }
+}
+
 /*
  * This runs in the pinctrl main thread, so it has access to the southbound
  * database. It reads the IP_Multicast table and updates the local multicast
@@ -5789,12 +5980,19 @@ ip_mcast_sync(struct ovsdb_idl_txn *ovnsb_idl_txn,
               struct ovsdb_idl_index *sbrec_datapath_binding_by_key,
               struct ovsdb_idl_index *sbrec_port_binding_by_key,
               struct ovsdb_idl_index *sbrec_igmp_groups,
-              struct ovsdb_idl_index *sbrec_ip_multicast)
+              struct ovsdb_idl_index *sbrec_ip_multicast,
+              const struct sbrec_igmp_group_table *igmp_group_table)
     OVS_REQUIRES(pinctrl_mutex)
 {
     bool notify = false;
 
-    if (!ovnsb_idl_txn || !chassis) {
+    if (!chassis) {
+        return;
+    }
+
+    ip_mcast_handle_igmp_group_changes(igmp_group_table, chassis);
+
+    if (!ovnsb_idl_txn) {
         return;
     }
 
@@ -5830,6 +6028,37 @@ ip_mcast_sync(struct ovsdb_idl_txn *ovnsb_idl_txn,
         }
     }
 
+    /* Only the datapaths whose snooping state changed since the last run
+     * need their IGMP_Groups synced, unless it's time for a full sync.
+     * The dirty flag is cleared before the groups are read so that any
+     * concurrent change made by pinctrl_handler is picked up next time.
+     */
+    long long int now = time_msec();
+    bool full_sync = chassis != ip_mcast_sync_chassis
+                     || pinctrl.igmp_support_protocol != ip_mcast_sync_protocol
+                     || now >= ip_mcast_next_full_sync;
+    bool any_dirty = false;
+    struct ip_mcast_snoop *ip_ms;
+
+    HMAP_FOR_EACH (ip_ms, hmap_node, &mcast_snoop_map) {
+        bool dirty;
+
+        atomic_read_relaxed(&ip_ms->dirty, &dirty);
+        ip_ms->needs_sync = full_sync || dirty;
+        if (ip_ms->needs_sync) {
+            atomic_store_relaxed(&ip_ms->dirty, false);
+            any_dirty = true;
+        }
+    }
+
+    if (full_sync) {
+        ip_mcast_next_full_sync = now + IP_MCAST_FULL_SYNC_INTERVAL_MS;
+        ip_mcast_sync_chassis = chassis;
+        ip_mcast_sync_protocol = pinctrl.igmp_support_protocol;
+    } else if (!any_dirty) {
+        goto out;
+    }
+
     const struct sbrec_igmp_group *sbrec_ip_mrouter;
     const struct sbrec_igmp_group *sbrec_igmp;
 
@@ -5855,7 +6084,10 @@ ip_mcast_sync(struct ovsdb_idl_txn *ovnsb_idl_txn,
             continue;
         }
 
-        struct ip_mcast_snoop *ip_ms = ip_mcast_snoop_find(dp_key);
+        ip_ms = ip_mcast_snoop_find(dp_key);
+        if (!full_sync && (!ip_ms || !ip_ms->needs_sync)) {
+            continue;
+        }
 
         /* If the datapath doesn't exist anymore or IGMP snooping was disabled
          * on it then delete the IGMP_Group entry.
@@ -5881,13 +6113,15 @@ ip_mcast_sync(struct ovsdb_idl_txn *ovnsb_idl_txn,
         ovs_rwlock_unlock(&ip_ms->ms->rwlock);
     }
 
-    struct ip_mcast_snoop *ip_ms;
-
     /* Last: write new IGMP_Groups to the southbound DB and update existing
      * ones (if needed). We also flush any old per-datapath multicast snoop
      * structures.
      */
     HMAP_FOR_EACH_SAFE (ip_ms, hmap_node, &mcast_snoop_map) {
+        if (!ip_ms->needs_sync) {
+            continue;
+        }
+
         /* Flush any non-local snooping datapaths (e.g., stale). */
         struct local_datapath *local_dp =
             get_local_datapath(local_datapaths, ip_ms->dp_key);
@@ -5940,6 +6174,7 @@ ip_mcast_sync(struct ovsdb_idl_txn *ovnsb_idl_txn,
         ovs_rwlock_unlock(&ip_ms->ms->rwlock);
     }
 
+out:
     if (notify) {
         notify_pinctrl_handler();
     }
@@ -6124,12 +6359,14 @@ pinctrl_ip_mcast_handle(struct rconn *swconn,
     case ETH_TYPE_IP:
         if (pinctrl_ip_mcast_handle_igmp(swconn, ip_ms, ip_flow, pkt_in,
                                          port_key)) {
+            ip_mcast_snoop_set_dirty(ip_ms);
             notify_pinctrl_main();
         }
         break;
     case ETH_TYPE_IPV6:
         if (pinctrl_ip_mcast_handle_mld(swconn, ip_ms, ip_flow, pkt_in,
                                         port_key)) {
+            ip_mcast_snoop_set_dirty(ip_ms);
             notify_pinctrl_main();
         }
         break;
@@ -6290,7 +6527,7 @@ send_garp_rarp_wait(long long int send_garp_rarp_time)
     /* Set the poll timer for next garp/rarp only if there is data to
      * be sent. */
     if (!cmap_is_empty(&garp_rarp_get_data()->data)) {
-        poll_timer_wait_until(send_garp_rarp_time);
+        announce_wait(send_garp_rarp_time);
     }
 }
 
@@ -6300,8 +6537,35 @@ send_arp_nd_wait(long long int send_arp_nd_time)
     /* Set the poll timer for next arp packet only if there is data to
      * be sent. */
     if (hmap_count(&send_arp_nd_data)) {
-        poll_timer_wait_until(send_arp_nd_time);
+        announce_wait(send_arp_nd_time);
+    }
+}
+
+/* Called with in the pinctrl_handler thread context.
+ *
+ * Rebuilds 'send_garp_rarp_heap' if the GARP/RARP nodes changed since the
+ * last call.  Must be called before accessing the heap in every
+ * pinctrl_handler iteration: removed nodes are only guaranteed to be valid
+ * until the thread quiesces. */
+static void
+send_garp_rarp_heap_sync(const struct garp_rarp_data *garp_rarp_data)
+{
+    uint64_t seqno = garp_rarp_data_get_seqno();
+    if (seqno == send_garp_rarp_heap_seqno) {
+        return;
+    }
+
+    heap_clear(&send_garp_rarp_heap);
+
+    struct garp_rarp_node *garp;
+    CMAP_FOR_EACH (garp, cmap_node, &garp_rarp_data->data) {
+        long long int announce_time;
+        atomic_read(&garp->announce_time, &announce_time);
+        heap_raw_insert(&send_garp_rarp_heap, &garp->heap_node,
+                        announce_time_to_priority(announce_time));
     }
+    heap_rebuild(&send_garp_rarp_heap);
+    send_garp_rarp_heap_seqno = seqno;
 }
 
 /* Called with in the pinctrl_handler thread context. */
@@ -6309,22 +6573,34 @@ static void
 send_garp_rarp_run(struct rconn *swconn, long long int *send_garp_rarp_time)
 {
     const struct garp_rarp_data *garp_rarp_data = garp_rarp_get_data();
-    if (cmap_is_empty(&garp_rarp_data->data)) {
+
+    send_garp_rarp_heap_sync(garp_rarp_data);
+    if (heap_is_empty(&send_garp_rarp_heap)) {
+        *send_garp_rarp_time = LLONG_MAX;
         return;
     }
 
-    /* Send GARPs, and update the next announcement. */
+    /* Send the due GARPs, as long as the rate limit allows it, and update
+     * their next announcement. */
     long long int current_time = time_msec();
-    *send_garp_rarp_time = LLONG_MAX;
-    struct garp_rarp_node *garp;
-    CMAP_FOR_EACH (garp, cmap_node, &garp_rarp_data->data) {
+    for (;;) {
+        struct heap_node *node = heap_max(&send_garp_rarp_heap);
+        if (announce_time_from_priority(node->priority) > current_time
+            || !announce_withdraw()) {
+            break;
+        }
+
+        struct garp_rarp_node *garp =
+            CONTAINER_OF(node, struct garp_rarp_node, heap_node);
         long long int next_announce = send_garp_rarp(
             swconn, garp, current_time, garp_rarp_data->max_timeout,
             garp_rarp_data->continuous);
-        if (*send_garp_rarp_time > next_announce) {
-            *send_garp_rarp_time = next_announce;
-        }
+        heap_change(&send_garp_rarp_heap, node,
+                    announce_time_to_priority(next_announce));
     }
+
+    *send_garp_rarp_time =
+        announce_time_from_priority(heap_max(&send_garp_rarp_heap)->priority);
 }
 
 static long long int
@@ -6346,7 +6622,7 @@ send_arp_nd(struct rconn *swconn, struct arp_nd_data *e,
      * vif if arp_nd_max_timeout is not specified otherwise cap the max
      * timeout to arp_nd_max_timeout. */
     if (arp_nd_continuous || e->backoff < arp_nd_max_timeout) {
-        e->announce_time = current_time + e->backoff;
+        e->announce_time = current_time + announce_backoff_jitter(e->backoff);
     } else {
         e->announce_time = LLONG_MAX;
     }
@@ -6359,21 +6635,30 @@ static void
 send_arp_nd_run(struct rconn *swconn, long long int *send_arp_nd_time)
     OVS_REQUIRES(pinctrl_mutex)
 {
-    if (!hmap_count(&send_arp_nd_data)) {
+    if (heap_is_empty(&send_arp_nd_heap)) {
+        *send_arp_nd_time = LLONG_MAX;
         return;
     }
 
-    /* Send ARPs, and update the next announcement. */
+    /* Send the due ARPs, as long as the rate limit allows it, and update
+     * their next announcement. */
     long long int current_time = time_msec();
-    *send_arp_nd_time = LLONG_MAX;
+    for (;;) {
+        struct heap_node *node = heap_max(&send_arp_nd_heap);
+        if (announce_time_from_priority(node->priority) > current_time
+            || !announce_withdraw()) {
+            break;
+        }
 
-    struct arp_nd_data *e;
-    HMAP_FOR_EACH (e, hmap_node, &send_arp_nd_data) {
+        struct arp_nd_data *e = CONTAINER_OF(node, struct arp_nd_data,
+                                             heap_node);
         long long int next_announce = send_arp_nd(swconn, e, current_time);
-        if (*send_arp_nd_time > next_announce) {
-            *send_arp_nd_time = next_announce;
-        }
+        heap_change(&send_arp_nd_heap, node,
+                    announce_time_to_priority(next_announce));
     }
+
+    *send_arp_nd_time =
+        announce_time_from_priority(heap_max(&send_arp_nd_heap)->priority);
 }
 
 /* Called by pinctrl_run(). Runs with in the main ovn-controller
@@ -6385,6 +6670,7 @@ send_garp_rarp_prepare(const struct sbrec_ecmp_nexthop_table *ecmp_nh_table,
     OVS_REQUIRES(pinctrl_mutex)
 {
     unsigned long long max_arp_nd_timeout = ARP_ND_DEF_MAX_TIMEOUT;
+    unsigned int max_rate = ANNOUNCE_DEF_MAX_RATE;
     bool continuous_arp_nd = true;
     const struct ovsrec_open_vswitch *cfg =
         ovsrec_open_vswitch_table_first(ovs_table);
@@ -6394,7 +6680,11 @@ send_garp_rarp_prepare(const struct sbrec_ecmp_nexthop_table *ecmp_nh_table,
                 &cfg->external_ids, "arp-nd-max-timeout-sec",
                 ARP_ND_DEF_MAX_TIMEOUT / 1000) * 1000;
         continuous_arp_nd = !!max_arp_nd_timeout;
+        max_rate = smap_get_uint(&cfg->external_ids,
+                                 "ovn-announce-max-rate",
+                                 ANNOUNCE_DEF_MAX_RATE);
     }
+    atomic_store_relaxed(&announce_max_rate, max_rate);
 
 
     if (garp_rarp_data_changed()) {
@@ -6425,7 +6715,7 @@ may_inject_pkts(void)
             !cmap_is_empty(&garp_rarp_get_data()->data) ||
             ipv6_prefixd_should_inject() ||
             !ovs_list_is_empty(&mcast_query_list) ||
-            !cmap_is_empty(&buffered_packets_map) ||
+            !cmap_is_empty(&buffered_packets_ctx.map) ||
             bfd_monitor_should_inject());
 }
 
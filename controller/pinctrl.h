@@ -38,8 +38,10 @@ struct sbrec_controller_event_table;
 struct sbrec_service_monitor_table;
 struct sbrec_bfd_table;
 struct sbrec_ecmp_nexthop_table;
+struct sbrec_igmp_group_table;
 struct sbrec_port_binding;
 struct sbrec_mac_binding_table;
+struct simap;
 
 void pinctrl_init(void);
 void pinctrl_run(struct ovsdb_idl_txn *ovnsb_idl_txn,
@@ -55,6 +57,7 @@ void pinctrl_run(struct ovsdb_idl_txn *ovnsb_idl_txn,
                  const struct sbrec_mac_binding_table *,
                  const struct sbrec_bfd_table *,
                  const struct sbrec_ecmp_nexthop_table *,
+                 const struct sbrec_igmp_group_table *,
                  const struct sbrec_chassis *chassis,
                  const struct hmap *local_datapaths,
                  const struct shash *local_active_ports_ipv6_pd,
@@ -67,6 +70,7 @@ void pinctrl_destroy(void);
 void pinctrl_update_swconn(const char *target, int probe_interval);
 
 void pinctrl_update(const struct ovsdb_idl *idl);
+void pinctrl_get_memory_usage(struct simap *usage);
 
 struct activated_port {
     uint32_t dp_key;
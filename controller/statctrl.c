@@ -21,6 +21,7 @@
 #include "lflow.h"
 #include "lib/vec.h"
 #include "mac-cache.h"
+#include "openvswitch/dynamic-string.h"
 #include "openvswitch/ofp-errors.h"
 #include "openvswitch/ofp-flow.h"
 #include "openvswitch/ofp-msgs.h"
@@ -35,11 +36,27 @@
 #include "socket-util.h"
 #include "statctrl.h"
 #include "stopwatch.h"
+#include "timeval.h"
 
 VLOG_DEFINE_THIS_MODULE(statctrl);
 
 #define STATS_VEC_CAPACITY_THRESHOLD 1024
 
+/* The flows of the statistics tables are split into up to STATS_MAX_SLICES
+ * slices, by the upper bits of the lower 32 bits of their cookie, i.e., of
+ * the UUID of the MAC binding or FDB entry they were created for.  Each
+ * slice is requested separately and the requests are spread over the
+ * request delay, so every flow is still dumped once per request delay but
+ * without dumping the whole table at once.  The number of slices adapts so
+ * that a single reply carries about STATS_SLICE_TARGET_FLOWS flows, but
+ * requests are never sent more often than every
+ * STATS_MIN_SLICE_INTERVAL_MS.  The xid of the last request of every slice
+ * is kept, so a reply that arrives after the next slice was requested is
+ * still processed. */
+#define STATS_MAX_SLICES 64
+#define STATS_SLICE_TARGET_FLOWS 4096
+#define STATS_MIN_SLICE_INTERVAL_MS 100
+
 enum stat_type {
     STATS_MAC_BINDING = 0,
     STATS_FDB,
@@ -50,8 +67,8 @@ enum stat_type {
 struct stats_node {
     /* The statistics request. */
     struct  ofputil_flow_stats_request request;
-    /* xid of the last statistics request. */
-    ovs_be32 xid;
+    /* xid of the last statistics request of each slice, 0 if none. */
+    ovs_be32 xids[STATS_MAX_SLICES];
     /* Timestamp when the next request should happen. */
     int64_t next_request_timestamp;
     /* Request delay in ms. */
@@ -67,19 +84,33 @@ struct stats_node {
     void (*run)(struct vector *stats, uint64_t *req_delay, void *data);
     /* Name of the stats node. */
     const char *name;
+
+    /* Number of slices the table is requested in, a power of 2. */
+    uint32_t n_slices;
+    /* Slice to request next. */
+    uint32_t next_slice;
+    /* Number of flows received since the first slice was requested. */
+    uint64_t n_sweep_flows;
+
+    /* Statistics of the node. */
+    uint64_t n_requests;
+    uint64_t n_replies;
+    uint64_t n_flows;          /* Flows decoded. */
+    uint64_t n_flows_kept;     /* Flows passed to run(). */
+    uint64_t decode_usec;      /* Time spent decoding the replies. */
 };
 
 #define STATS_NODE(NAME, REQUEST, STAT_TYPE, PROCESS, RUN)                 \
     do {                                                                   \
         statctrl_ctx.nodes[STATS_##NAME] = (struct stats_node) {           \
             .request = REQUEST,                                            \
-            .xid = 0,                                                      \
             .next_request_timestamp = INT64_MAX,                           \
             .request_delay = 0,                                            \
             .stats = VECTOR_EMPTY_INITIALIZER(STAT_TYPE),                  \
             .process_flow_stats = PROCESS,                                 \
             .run = RUN,                                                    \
-            .name = OVS_STRINGIZE(stats_##NAME),                 \
+            .name = OVS_STRINGIZE(stats_##NAME),                           \
+            .n_slices = 1,                                                 \
         };                                                                 \
         stopwatch_create(OVS_STRINGIZE(stats_##NAME), SW_MS);              \
     } while (0)
@@ -251,6 +282,31 @@ statctrl_wait(struct ovsdb_idl_txn *ovnsb_idl_txn)
     ovs_mutex_unlock(&mutex);
 }
 
+/* Formats into 's' the request and decode statistics of every node. */
+void
+statctrl_get_stats(struct ds *s)
+{
+    ovs_mutex_lock(&mutex);
+    for (size_t i = 0; i < STATS_MAX; i++) {
+        const struct stats_node *node = &statctrl_ctx.nodes[i];
+
+        ds_put_format(s, "%s:\n", node->name);
+        ds_put_format(s, "  request delay: %"PRIu64"ms, slices: %"PRIu32"\n",
+                      node->request_delay, node->n_slices);
+        ds_put_format(s, "  requests: %"PRIu64", replies: %"PRIu64"\n",
+                      node->n_requests, node->n_replies);
+        ds_put_format(s, "  flows decoded: %"PRIu64", flows kept: %"PRIu64
+                      "\n", node->n_flows, node->n_flows_kept);
+        ds_put_format(s, "  decode time: %"PRIu64"us", node->decode_usec);
+        if (node->decode_usec) {
+            ds_put_format(s, " (%"PRIu64" flows/s)",
+                          node->n_flows * 1000 * 1000 / node->decode_usec);
+        }
+        ds_put_char(s, '\n');
+    }
+    ovs_mutex_unlock(&mutex);
+}
+
 void
 statctrl_destroy(void)
 {
@@ -348,8 +404,11 @@ static enum stat_type
 statctrl_get_stat_type(struct statctrl_ctx *ctx, const struct ofp_header *oh)
 {
     for (size_t i = 0; i < STATS_MAX; i++) {
-        if (ctx->nodes[i].xid == oh->xid) {
-            return i;
+        const struct stats_node *node = &ctx->nodes[i];
+        for (size_t j = 0; j < ARRAY_SIZE(node->xids); j++) {
+            if (node->xids[j] == oh->xid) {
+                return i;
+            }
         }
     }
     return STATS_MAX;
@@ -359,6 +418,10 @@ static void
 statctrl_decode_statistics_reply(struct stats_node *node, struct ofpbuf *msg)
     OVS_REQUIRES(mutex)
 {
+    long long int start = time_usec();
+    size_t n_stats = vector_len(&node->stats);
+    uint64_t n_flows = 0;
+
     struct ofpbuf ofpacts;
     ofpbuf_init(&ofpacts, 0);
 
@@ -374,9 +437,65 @@ statctrl_decode_statistics_reply(struct stats_node *node, struct ofpbuf *msg)
         }
 
         node->process_flow_stats(&node->stats, &fs);
+        n_flows++;
     }
 
     ofpbuf_uninit(&ofpacts);
+
+    node->n_replies++;
+    node->n_flows += n_flows;
+    node->n_sweep_flows += n_flows;
+    node->n_flows_kept += vector_len(&node->stats) - n_stats;
+    node->decode_usec += time_usec() - start;
+}
+
+/* Adapts the number of slices of 'node' to the number of flows received
+ * during the last sweep of the table. */
+static void
+statctrl_update_slices(struct stats_node *node)
+    OVS_REQUIRES(mutex)
+{
+    uint64_t n_slices = DIV_ROUND_UP(node->n_sweep_flows,
+                                     STATS_SLICE_TARGET_FLOWS);
+    uint64_t max_slices = MIN(STATS_MAX_SLICES,
+                              node->request_delay /
+                              STATS_MIN_SLICE_INTERVAL_MS);
+
+    uint32_t new_n_slices = 1;
+    while (new_n_slices < n_slices && new_n_slices * 2 <= max_slices) {
+        new_n_slices *= 2;
+    }
+
+    if (new_n_slices != node->n_slices) {
+        VLOG_DBG("Requesting statistics for node '%s' in %"PRIu32" slices, "
+                 "%"PRIu64" flows in the last sweep.", node->name,
+                 new_n_slices, node->n_sweep_flows);
+        node->n_slices = new_n_slices;
+    }
+    node->n_sweep_flows = 0;
+}
+
+/* Sets the cookie and cookie mask of 'request' to select the flows of
+ * 'node''s next slice. */
+static void
+statctrl_set_slice(const struct stats_node *node,
+                   struct ofputil_flow_stats_request *request)
+{
+    if (node->n_slices == 1) {
+        request->cookie = htonll(0);
+        request->cookie_mask = htonll(0);
+        return;
+    }
+
+    int shift = 32 - log_2_floor(node->n_slices);
+    request->cookie = htonll((uint64_t) node->next_slice << shift);
+    request->cookie_mask = htonll((uint64_t) (node->n_slices - 1) << shift);
+}
+
+static uint64_t
+statctrl_request_interval(const struct stats_node *node, uint64_t delay)
+{
+    return delay ? MAX(delay / node->n_slices, 1) : 0;
 }
 
 static void
@@ -394,9 +513,18 @@ statctrl_send_request(struct rconn *swconn, struct statctrl_ctx *ctx)
             continue;
         }
 
+        if (!node->next_slice) {
+            statctrl_update_slices(node);
+        }
+
+        struct ofputil_flow_stats_request request = node->request;
+        statctrl_set_slice(node, &request);
+
         struct ofpbuf *msg =
-                ofputil_encode_flow_stats_request(&node->request, proto);
-        node->xid = ((struct ofp_header *) msg->data)->xid;
+                ofputil_encode_flow_stats_request(&request, proto);
+        node->xids[node->next_slice] = ((struct ofp_header *) msg->data)->xid;
+        node->next_slice = (node->next_slice + 1) % node->n_slices;
+        node->n_requests++;
 
         statctrl_update_next_request_timestamp(node, now, 0);
 
@@ -436,9 +564,11 @@ statctrl_update_next_request_timestamp(struct stats_node *node,
         return false;
     }
 
+    /* Each request covers a single slice of the table. */
+    uint64_t interval = statctrl_request_interval(node, node->request_delay);
+    uint64_t prev_interval = statctrl_request_interval(node, prev_delay);
     int64_t timestamp = prev_delay ? node->next_request_timestamp : now;
-    node->next_request_timestamp =
-            timestamp + node->request_delay - prev_delay;
+    node->next_request_timestamp = timestamp + interval - prev_interval;
 
     return timestamp != node->next_request_timestamp;
 }
@@ -18,6 +18,8 @@
 
 #include "mac-cache.h"
 
+struct ds;
+
 void statctrl_init(void);
 void statctrl_run(struct ovsdb_idl_txn *ovnsb_idl_txn,
                   struct ovsdb_idl_index *sbrec_port_binding_by_name,
@@ -26,6 +28,7 @@ void statctrl_run(struct ovsdb_idl_txn *ovnsb_idl_txn,
 
 void statctrl_update_swconn(const char *target, int probe_interval);
 void statctrl_wait(struct ovsdb_idl_txn *ovnsb_idl_txn);
+void statctrl_get_stats(struct ds *);
 void statctrl_destroy(void);
 
 #endif /* controller/statctrl.h */
@@ -235,8 +235,8 @@ inc_proc_ic_run(struct ic_context *ctx,
             VLOG_DBG("engine did not run, and it was not needed");
         }
     } else if (engine_canceled()) {
-        VLOG_DBG("engine was canceled, force recompute next time.");
-        engine_set_force_recompute_immediate();
+        VLOG_DBG("engine was canceled, resume next time.");
+        engine_set_resume_immediate();
     } else {
         engine_clear_force_recompute();
     }
@@ -259,7 +259,8 @@ inc_proc_ic_cleanup(void)
 bool
 inc_proc_ic_can_run(struct ic_engine_context *ctx)
 {
-    if (engine_get_force_recompute() || time_msec() >= ctx->next_run_ms ||
+    if (engine_get_force_recompute() || engine_need_resume() ||
+        time_msec() >= ctx->next_run_ms ||
         ctx->nb_idl_duration_ms >= IDL_LOOP_MAX_DURATION_MS ||
         ctx->sb_idl_duration_ms >= IDL_LOOP_MAX_DURATION_MS ||
         ctx->inb_idl_duration_ms >= IDL_LOOP_MAX_DURATION_MS ||
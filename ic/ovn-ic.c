@@ -35,6 +35,7 @@
 #include "lib/ovn-util.h"
 #include "memory.h"
 #include "openvswitch/poll-loop.h"
+#include "ovs-replay.h"
 #include "ovsdb-idl.h"
 #include "simap.h"
 #include "smap.h"
@@ -88,6 +89,8 @@ Options:\n\
                             (default: %s)\n\
   --ic-sb-db=DATABASE       connect to ovn-ic-sb database at DATABASE\n\
                             (default: %s)\n\
+  --record[=DIR]            record database traffic into DIR\n\
+  --replay[=DIR]            replay database traffic recorded in DIR\n\
   --unixctl=SOCKET          override default control socket name\n\
   -h, --help                display this help message\n\
   -o, --options             list available options\n\
@@ -3262,6 +3265,7 @@ parse_options(int argc OVS_UNUSED, char *argv[] OVS_UNUSED)
         VLOG_OPTION_ENUMS,
         SSL_OPTION_ENUMS,
         OPT_DUMP_INC_PROC_GRAPH,
+        OVS_REPLAY_OPTION_ENUMS,
     };
     static const struct option long_options[] = {
         {"ovnsb-db", required_argument, NULL, 'd'},
@@ -3277,6 +3281,7 @@ parse_options(int argc OVS_UNUSED, char *argv[] OVS_UNUSED)
         OVN_DAEMON_LONG_OPTIONS,
         VLOG_LONG_OPTIONS,
         STREAM_SSL_LONG_OPTIONS,
+        OVS_REPLAY_LONG_OPTIONS,
         {NULL, 0, NULL, 0},
     };
     char *short_options = ovs_cmdl_long_options_to_short_options(long_options);
@@ -3292,6 +3297,7 @@ parse_options(int argc OVS_UNUSED, char *argv[] OVS_UNUSED)
         switch (c) {
         OVN_DAEMON_OPTION_HANDLERS;
         VLOG_OPTION_HANDLERS;
+        OVS_REPLAY_OPTION_HANDLERS;
 
         case 'p':
             ssl_private_key_file = optarg;
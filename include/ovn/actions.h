@@ -999,6 +999,8 @@ struct ovnact_encode_params {
 void ovnacts_encode(const struct ovnact[], size_t ovnacts_len,
                     const struct ovnact_encode_params *,
                     struct ofpbuf *ofpacts);
+bool ovnacts_encode_is_context_free(const struct ovnact[],
+                                    size_t ovnacts_len);
 
 void ovnacts_free(struct ovnact[], size_t ovnacts_len);
 char *ovnact_op_to_string(uint32_t);
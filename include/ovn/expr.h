@@ -64,6 +64,7 @@
 
 struct ds;
 struct expr;
+struct expr_program;
 struct flow;
 struct ofpbuf;
 struct shash;
@@ -264,6 +265,11 @@ struct expr_symbol {
     bool must_crossproduct;
     enum expr_write_scope rw; /* Bit map indicating in which nested contexts
                                * the symbol is writeable */
+
+    /* 'prereqs' and 'predicate', parsed and annotated by
+     * expr_symtab_freeze(), or NULL. */
+    struct expr *prereqs_expr;
+    struct expr *predicate_expr;
 };
 
 void expr_symbol_format(const struct expr_symbol *, struct ds *);
@@ -319,6 +325,8 @@ struct expr_symbol *expr_symtab_add_ovn_field(struct shash *symtab,
                                               const char *name,
                                               enum ovn_field_id id);
 void expr_symtab_destroy(struct shash *symtab);
+void expr_symtab_freeze(struct shash *symtab);
+void expr_symtab_thaw(struct shash *symtab);
 
 /* Expression type. */
 enum expr_type {
@@ -446,6 +454,20 @@ struct expr *expr_evaluate_condition(
     const void *c_aux);
 struct expr *expr_normalize(struct expr *);
 
+/* Memoization of expr_normalize() for subexpressions over a single field,
+ * such as the large disjunctions that address sets expand to.  A memo is not
+ * thread-safe: threads that normalize expressions concurrently must each use
+ * their own memo.  A memo must be destroyed before the symbol table of the
+ * expressions it was used for. */
+struct expr_memo;
+
+struct expr_memo *expr_memo_create(size_t max_size);
+void expr_memo_destroy(struct expr_memo *);
+void expr_memo_clear(struct expr_memo *);
+void expr_memo_get_stats(const struct expr_memo *,
+                         uint64_t *n_hits, uint64_t *n_misses);
+struct expr *expr_normalize_memo(struct expr *, struct expr_memo *);
+
 bool expr_honors_invariants(const struct expr *);
 bool expr_is_simplified(const struct expr *);
 bool expr_is_normalized(const struct expr *);
@@ -464,6 +486,15 @@ bool expr_evaluate(const struct expr *, const struct flow *uflow,
                    bool (*lookup_port)(const void *aux, const char *port_name,
                                        unsigned int *portp),
                    const void *aux);
+
+struct expr_program *expr_compile(const struct expr *);
+bool expr_program_evaluate(const struct expr_program *,
+                           const struct flow *uflow,
+                           bool (*lookup_port)(const void *aux,
+                                               const char *port_name,
+                                               unsigned int *portp),
+                           const void *aux);
+void expr_program_destroy(struct expr_program *);
 
 /* Converting expressions to OpenFlow flows. */
 
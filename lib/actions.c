@@ -6236,6 +6236,46 @@ ovnacts_encode(const struct ovnact *ovnacts, size_t ovnacts_len,
     }
 }
 
+/* Returns true if the OpenFlow encoding of the 'ovnacts_len' bytes of
+ * actions starting at 'ovnacts' depends only on the actions themselves and on
+ * the 'pipeline', 'is_switch' and logical pipeline and output table members of
+ * the encoding parameters.  Such actions don't look up ports, don't allocate
+ * groups or meters and don't refer to the logical flow or datapath they are
+ * encoded for, so their encoding can be shared by every logical flow that
+ * has the same actions. */
+bool
+ovnacts_encode_is_context_free(const struct ovnact *ovnacts,
+                               size_t ovnacts_len)
+{
+    const struct ovnact *a;
+
+    OVNACT_FOR_EACH (a, ovnacts, ovnacts_len) {
+        switch (a->type) {
+        case OVNACT_OUTPUT:
+        case OVNACT_NEXT:
+        case OVNACT_MOVE:
+        case OVNACT_PUSH:
+        case OVNACT_POP:
+        case OVNACT_EXCHANGE:
+        case OVNACT_DEC_TTL:
+        case OVNACT_CT_NEXT:
+        case OVNACT_CT_CLEAR:
+            break;
+
+        case OVNACT_LOAD:
+            /* Loading a port name requires a port lookup. */
+            if (!ovnact_get_LOAD(a)->dst.symbol->width) {
+                return false;
+            }
+            break;
+
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
 /* Freeing ovnacts. */
 
 static void
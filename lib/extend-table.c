@@ -19,7 +19,6 @@
 
 #include "extend-table.h"
 #include "hash.h"
-#include "id-pool.h"
 #include "lib/uuid.h"
 #include "openvswitch/vlog.h"
 
@@ -33,37 +32,73 @@ void
 ovn_extend_table_init(struct ovn_extend_table *table, const char *table_name,
                       uint32_t n_ids)
 {
-    /* Table id 0 is invalid, set id-pool base to 1. */
-    uint32_t meter_base = 1;
-
-    n_ids = MIN(n_ids, UINT32_MAX - meter_base);
+    /* Table id 0 is invalid, ids start from 1. */
+    n_ids = MIN(n_ids, UINT32_MAX - 1);
 
     *table = (struct ovn_extend_table) {
         .name = xstrdup(table_name),
         .n_ids = n_ids,
-        .table_ids = id_pool_create(meter_base, n_ids),
+        .next_free_id = 0,
         .desired = HMAP_INITIALIZER(&table->desired),
         .lflow_to_desired = HMAP_INITIALIZER(&table->lflow_to_desired),
         .existing = HMAP_INITIALIZER(&table->existing),
+        .uninstalled = OVS_LIST_INITIALIZER(&table->uninstalled),
+        .stale = OVS_LIST_INITIALIZER(&table->stale),
     };
+    dynamic_bitmap_alloc(&table->table_ids, 0);
 }
 
 void
 ovn_extend_table_reinit(struct ovn_extend_table *table, uint32_t n_ids)
 {
-    /* Table id 0 is invalid, set id-pool base to 1. */
-    uint32_t meter_base = 1;
-
-    n_ids = MIN(n_ids, UINT32_MAX - meter_base);
+    /* Table id 0 is invalid, ids start from 1. */
+    n_ids = MIN(n_ids, UINT32_MAX - 1);
 
     if (n_ids != table->n_ids) {
         ovn_extend_table_clear(table, true);
-        id_pool_destroy(table->table_ids);
-        table->table_ids = id_pool_create(meter_base, n_ids);
+        dynamic_bitmap_free(&table->table_ids);
+        dynamic_bitmap_alloc(&table->table_ids, 0);
+        table->next_free_id = 0;
         table->n_ids = n_ids;
     }
 }
 
+/* Allocates the lowest unused table id.  The search starts at
+ * 'next_free_id', below which all ids are known to be in use, and goes
+ * through the bitmap a word at a time, so allocating ids in a row doesn't
+ * rescan the ids allocated before. */
+static bool
+ovn_extend_table_alloc_id(struct ovn_extend_table *table, uint32_t *id)
+{
+    struct dynamic_bitmap *ids = &table->table_ids;
+    size_t idx = dynamic_bitmap_scan(ids, false, table->next_free_id);
+
+    if (idx >= table->n_ids) {
+        return false;
+    }
+    if (idx >= ids->capacity) {
+        dynamic_bitmap_realloc(ids, MIN(MAX(2 * ids->capacity,
+                                            BITMAP_ULONG_BITS),
+                                        table->n_ids));
+    }
+    dynamic_bitmap_set1(ids, idx);
+    table->next_free_id = idx + 1;
+    *id = idx + 1;
+    return true;
+}
+
+static void
+ovn_extend_table_free_id(struct ovn_extend_table *table, uint32_t id)
+{
+    struct dynamic_bitmap *ids = &table->table_ids;
+
+    if (id == EXT_TABLE_ID_INVALID || id - 1 >= ids->capacity) {
+        return;
+    }
+    dynamic_bitmap_set0(ids, id - 1);
+    table->next_free_id = MIN(table->next_free_id, id - 1);
+}
+
 static struct ovn_extend_table_info *
 ovn_extend_table_info_alloc(const char *name, uint32_t id,
                             struct ovn_extend_table_info *peer,
@@ -81,6 +116,23 @@ ovn_extend_table_info_alloc(const char *name, uint32_t id,
     return e;
 }
 
+/* Detaches 'e', which is about to be destroyed, from its peer, or releases
+ * its table id if it has no peer.  'e' belongs to 'table->existing' if
+ * 'existing' is true, otherwise to 'table->desired'. */
+static void
+ovn_extend_table_info_unlink(struct ovn_extend_table *table,
+                             struct ovn_extend_table_info *e, bool existing)
+{
+    if (e->peer) {
+        e->peer->peer = NULL;
+        ovs_list_push_back(existing ? &table->uninstalled : &table->stale,
+                           &e->peer->list_node);
+    } else {
+        ovs_list_remove(&e->list_node);
+        ovn_extend_table_free_id(table, e->table_id);
+    }
+}
+
 static void
 ovn_extend_table_info_destroy(struct ovn_extend_table_info *e)
 {
@@ -214,12 +266,7 @@ ovn_extend_table_clear(struct ovn_extend_table *table, bool existing)
     /* Clear the target table. */
     HMAP_FOR_EACH_SAFE (g, hmap_node, target) {
         hmap_remove(target, &g->hmap_node);
-        if (g->peer) {
-            g->peer->peer = NULL;
-        } else {
-            /* Unset the id because the peer is deleted already. */
-            id_pool_free_id(table->table_ids, g->table_id);
-        }
+        ovn_extend_table_info_unlink(table, g, existing);
         ovn_extend_table_info_destroy(g);
     }
 }
@@ -232,7 +279,7 @@ ovn_extend_table_destroy(struct ovn_extend_table *table)
     hmap_destroy(&table->lflow_to_desired);
     ovn_extend_table_clear(table, true);
     hmap_destroy(&table->existing);
-    id_pool_destroy(table->table_ids);
+    dynamic_bitmap_free(&table->table_ids);
     free(table->name);
 }
 
@@ -243,13 +290,7 @@ ovn_extend_table_remove_existing(struct ovn_extend_table *table,
 {
     /* Remove 'existing' from 'table->existing' */
     hmap_remove(&table->existing, &existing->hmap_node);
-
-    if (existing->peer) {
-        existing->peer->peer = NULL;
-    } else {
-        /* Dealloc the ID. */
-        id_pool_free_id(table->table_ids, existing->table_id);
-    }
+    ovn_extend_table_info_unlink(table, existing, true);
     ovn_extend_table_info_destroy(existing);
 }
 
@@ -266,11 +307,7 @@ ovn_extend_table_delete_desired(struct ovn_extend_table *table,
             VLOG_DBG("%s: table %s: %s, "UUID_FMT, __func__,
                      table->name, e->name, UUID_ARGS(&l->lflow_uuid));
             hmap_remove(&table->desired, &e->hmap_node);
-            if (e->peer) {
-                e->peer->peer = NULL;
-            } else {
-                id_pool_free_id(table->table_ids, e->table_id);
-            }
+            ovn_extend_table_info_unlink(table, e, false);
             ovn_extend_table_info_destroy(e);
         }
     }
@@ -297,17 +334,16 @@ ovn_extend_table_sync(struct ovn_extend_table *table)
 {
     struct ovn_extend_table_info *desired;
 
-    /* Copy the contents of desired to existing. */
-    HMAP_FOR_EACH_SAFE (desired, hmap_node, &table->desired) {
-        if (!ovn_extend_table_lookup(&table->existing, desired)) {
-            struct ovn_extend_table_info *existing =
-                ovn_extend_table_info_alloc(desired->name,
-                                            desired->table_id,
-                                            desired,
-                                            desired->hmap_node.hash);
-            hmap_insert(&table->existing, &existing->hmap_node,
-                        existing->hmap_node.hash);
-        }
+    /* Copy the contents of desired to existing.  Only the desired items
+     * without a peer can be missing from existing. */
+    LIST_FOR_EACH_POP (desired, list_node, &table->uninstalled) {
+        struct ovn_extend_table_info *existing =
+            ovn_extend_table_info_alloc(desired->name,
+                                        desired->table_id,
+                                        desired,
+                                        desired->hmap_node.hash);
+        hmap_insert(&table->existing, &existing->hmap_node,
+                    existing->hmap_node.hash);
     }
 }
 
@@ -347,7 +383,7 @@ ovn_extend_table_assign_id(struct ovn_extend_table *table, const char *name,
 
     if (!existing_info) {
         /* Reserve a new id. */
-        if (!id_pool_alloc_id(table->table_ids, &table_id)) {
+        if (!ovn_extend_table_alloc_id(table, &table_id)) {
             static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 1);
 
             VLOG_ERR_RL(&rl, "table %s: out of table ids.", table->name);
@@ -357,6 +393,12 @@ ovn_extend_table_assign_id(struct ovn_extend_table *table, const char *name,
 
     table_info = ovn_extend_table_info_alloc(name, table_id, existing_info,
                                              hash);
+    if (existing_info) {
+        /* The installed item is wanted again. */
+        ovs_list_remove(&existing_info->list_node);
+    } else {
+        ovs_list_push_back(&table->uninstalled, &table_info->list_node);
+    }
 
     hmap_insert(&table->desired,
                 &table_info->hmap_node, table_info->hmap_node.hash);
@@ -22,8 +22,7 @@
 #include "openvswitch/hmap.h"
 #include "openvswitch/list.h"
 #include "openvswitch/uuid.h"
-
-struct id_pool;
+#include "ovn-util.h"
 
 /* Used to manage expansion tables associated with Flow table,
  * such as the Group Table or Meter Table. */
@@ -31,18 +30,28 @@ struct ovn_extend_table {
     char *name; /* Used to identify this table in a user friendly way,
                  * e.g., for logging. */
     uint32_t n_ids;
-    struct id_pool *table_ids; /* Used to allocate ids in either desired or
-                                * existing (or both).  If the same "name"
-                                * exists in both desired and existing tables,
-                                * they must share the same ID.  The "peer"
-                                * pointer would tell if the ID is still used by
-                                * the same item in the peer table. */
+    struct dynamic_bitmap table_ids; /* Used to allocate ids in either desired
+                                      * or existing (or both), bit N standing
+                                      * for id N + 1.  If the same "name"
+                                      * exists in both desired and existing
+                                      * tables, they must share the same ID.
+                                      * The "peer" pointer would tell if the ID
+                                      * is still used by the same item in the
+                                      * peer table.  The bitmap only grows up
+                                      * to the highest id in use. */
+    size_t next_free_id; /* No bit below this one is clear in table_ids. */
     struct hmap desired;
     struct hmap lflow_to_desired; /* Index for looking up desired table
                                    * items from given lflow uuid, with
                                    * ovn_extend_table_lflow_to_desired nodes.
                                    */
     struct hmap existing;
+
+    /* Items without a peer, i.e. the ones that ovn_extend_table_sync() and
+     * the users of the EXTEND_TABLE_FOR_EACH_* macros need to look at, so
+     * that they don't have to walk the whole tables. */
+    struct ovs_list uninstalled; /* Items in 'desired' not in 'existing'. */
+    struct ovs_list stale;       /* Items in 'existing' not in 'desired'. */
 };
 
 struct ovn_extend_table_lflow_to_desired {
@@ -62,6 +71,8 @@ struct ovn_extend_table_info {
                                            these tables. If "peer" is NULL, it
                                            means the counterpart is not created
                                            yet or deleted already. */
+    struct ovs_list list_node; /* In ovn_extend_table.uninstalled or .stale,
+                                * only if "peer" is NULL. */
     struct hmap references; /* The lflows that are using this item, with
                              * ovn_extend_table_lflow_ref nodes. Only useful
                              * for items in ovn_extend_table.desired. */
@@ -116,14 +127,12 @@ ovn_extend_table_desired_lookup_by_name(struct ovn_extend_table * table,
  * 'TABLE'->desired that are not in 'TABLE'->existing.  (The loop body
  * presumably adds them.) */
 #define EXTEND_TABLE_FOR_EACH_UNINSTALLED(DESIRED, TABLE) \
-    HMAP_FOR_EACH (DESIRED, hmap_node, &(TABLE)->desired) \
-        if (!ovn_extend_table_lookup(&(TABLE)->existing, DESIRED))
+    LIST_FOR_EACH (DESIRED, list_node, &(TABLE)->uninstalled)
 
 /* Iterates 'EXISTING' through all of the 'ovn_extend_table_info's in
  * 'TABLE'->existing that are not in 'TABLE'->desired.  (The loop body
  * presumably removes them.) */
 #define EXTEND_TABLE_FOR_EACH_INSTALLED(EXISTING, TABLE)               \
-    HMAP_FOR_EACH_SAFE (EXISTING, hmap_node, &(TABLE)->existing)        \
-        if (!ovn_extend_table_lookup(&(TABLE)->desired, EXISTING))
+    LIST_FOR_EACH_SAFE (EXISTING, list_node, &(TABLE)->stale)
 
 #endif /* lib/extend-table.h */
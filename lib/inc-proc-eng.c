@@ -21,13 +21,17 @@
 #include <signal.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
+#include "coverage.h"
 #include "lib/util.h"
 #include "openvswitch/dynamic-string.h"
 #include "openvswitch/hmap.h"
+#include "openvswitch/json.h"
 #include "openvswitch/poll-loop.h"
 #include "openvswitch/vlog.h"
 #include "ovsdb-idl.h"
+#include "ovs-thread.h"
 #include "inc-proc-eng.h"
 #include "timeval.h"
 #include "unixctl.h"
@@ -37,8 +41,23 @@
 
 VLOG_DEFINE_THIS_MODULE(inc_proc_eng);
 
+COVERAGE_DEFINE(engine_run_yield);
+COVERAGE_DEFINE(engine_run_resume);
+
 static bool engine_force_recompute = false;
 static bool engine_run_canceled = false;
+
+/* Time budget of a forced recompute, in milliseconds, 0 if unlimited.  When
+ * it is exceeded, the engine yields before the next resumable node and the
+ * following engine_run() resumes the recompute from there. */
+static long long int engine_time_budget_msec = 0;
+/* Set by "inc-engine/force-yield": the next forced recompute yields before
+ * its first resumable node regardless of the time budget. */
+static bool engine_force_yield = false;
+static long long int engine_run_start;
+static bool engine_run_yielded = false;
+static bool engine_run_resuming = false;
+static bool engine_resume_pending = false;
 static const struct engine_context *engine_context;
 
 static struct vector engine_nodes =
@@ -53,6 +72,36 @@ static const char *engine_node_state_name[EN_STATE_MAX] = {
 
 static long long engine_compute_log_timeout_msec = 500;
 
+static const uint64_t
+engine_latency_bounds_ms[ENGINE_LATENCY_N_BUCKETS - 1] = {
+    1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 5000,
+};
+
+#define ENGINE_MAX_THREADS 256
+
+/* Worker threads of the parallel scheduler.  The main thread queues nodes
+ * that are ready to run in 'queued' and the workers hand them back through
+ * 'completed' once they have been processed. */
+static struct {
+    struct ovs_mutex mutex;
+    pthread_cond_t work_cond;      /* Signaled when 'queued' is not empty. */
+    pthread_cond_t done_cond;      /* Signaled when 'completed' is not
+                                    * empty. */
+    struct vector queued;          /* Contains "struct engine_node *". */
+    struct vector completed;       /* Contains "struct engine_node *". */
+    bool recompute_allowed;
+    bool exiting;
+
+    pthread_t *workers;
+    size_t n_workers;
+} engine_sched = {
+    .mutex = OVS_MUTEX_INITIALIZER,
+    .work_cond = PTHREAD_COND_INITIALIZER,
+    .done_cond = PTHREAD_COND_INITIALIZER,
+    .queued = VECTOR_EMPTY_INITIALIZER(struct engine_node *),
+    .completed = VECTOR_EMPTY_INITIALIZER(struct engine_node *),
+};
+
 static void
 engine_recompute(struct engine_node *node, bool allowed,
                  const char *reason_fmt, ...) OVS_PRINTF_FORMAT(3, 4);
@@ -70,6 +119,25 @@ engine_set_force_recompute_immediate(void)
     poll_immediate_wake();
 }
 
+void
+engine_set_resume_immediate(void)
+{
+    engine_force_recompute = false;
+    poll_immediate_wake();
+}
+
+bool
+engine_need_resume(void)
+{
+    return engine_resume_pending;
+}
+
+void
+engine_set_time_budget(long long int msec)
+{
+    engine_time_budget_msec = MAX(msec, 0);
+}
+
 void
 engine_clear_force_recompute(void)
 {
@@ -124,10 +192,197 @@ engine_clear_stats(struct unixctl_conn *conn, int argc OVS_UNUSED,
     struct engine_node *node;
     VECTOR_FOR_EACH (&engine_nodes, node) {
         memset(&node->stats, 0, sizeof node->stats);
+        memset(node->input_stats, 0,
+               node->n_inputs * sizeof *node->input_stats);
     }
     unixctl_command_reply(conn, NULL);
 }
 
+/* Returns the CPU time consumed so far by the current thread, in
+ * microseconds, or 0 if it isn't available. */
+static long long int
+engine_thread_cpu_usec(void)
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    struct timespec ts;
+
+    if (!clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts)) {
+        return ts.tv_sec * 1000LL * 1000LL + ts.tv_nsec / 1000;
+    }
+#endif
+    return 0;
+}
+
+/* Adds to 'stats' a sample that started at wall clock time 'wall_start' and
+ * at thread CPU time 'cpu_start', both in microseconds. */
+static void
+engine_latency_record(struct engine_latency_stats *stats,
+                      long long int wall_start, long long int cpu_start)
+{
+    long long int wall = time_usec() - wall_start;
+    long long int cpu = engine_thread_cpu_usec() - cpu_start;
+    uint64_t wall_usec = MAX(wall, 0);
+    size_t i;
+
+    for (i = 0; i < ARRAY_SIZE(engine_latency_bounds_ms); i++) {
+        if (wall_usec <= engine_latency_bounds_ms[i] * 1000) {
+            break;
+        }
+    }
+    stats->buckets[i]++;
+    stats->n_samples++;
+    stats->wall_usec += wall_usec;
+    stats->cpu_usec += MAX(cpu, 0);
+    stats->max_wall_usec = MAX(stats->max_wall_usec, wall_usec);
+}
+
+static void
+engine_latency_format(struct ds *s, const struct engine_latency_stats *stats)
+{
+    ds_put_format(s, "samples: %"PRIu64", wall: %"PRIu64"us "
+                  "(avg %"PRIu64"us, max %"PRIu64"us), cpu: %"PRIu64"us\n",
+                  stats->n_samples, stats->wall_usec,
+                  stats->n_samples ? stats->wall_usec / stats->n_samples : 0,
+                  stats->max_wall_usec, stats->cpu_usec);
+    if (!stats->n_samples) {
+        return;
+    }
+
+    ds_put_cstr(s, "    histogram (ms):");
+    for (size_t i = 0; i < ENGINE_LATENCY_N_BUCKETS; i++) {
+        if (i < ARRAY_SIZE(engine_latency_bounds_ms)) {
+            ds_put_format(s, " <=%"PRIu64": %"PRIu64,
+                          engine_latency_bounds_ms[i], stats->buckets[i]);
+        } else {
+            ds_put_format(s, " >%"PRIu64": %"PRIu64,
+                          engine_latency_bounds_ms[i - 1], stats->buckets[i]);
+        }
+    }
+    ds_put_char(s, '\n');
+}
+
+static struct json *
+engine_latency_to_json(const struct engine_latency_stats *stats)
+{
+    struct json *histogram = json_object_create();
+    for (size_t i = 0; i < ENGINE_LATENCY_N_BUCKETS; i++) {
+        char *bound = i < ARRAY_SIZE(engine_latency_bounds_ms)
+                      ? xasprintf("%"PRIu64, engine_latency_bounds_ms[i])
+                      : xstrdup("inf");
+        json_object_put_nocopy(histogram, bound,
+                               json_integer_create(stats->buckets[i]));
+    }
+
+    struct json *json = json_object_create();
+    json_object_put(json, "samples", json_integer_create(stats->n_samples));
+    json_object_put(json, "wall_usec", json_integer_create(stats->wall_usec));
+    json_object_put(json, "cpu_usec", json_integer_create(stats->cpu_usec));
+    json_object_put(json, "max_wall_usec",
+                    json_integer_create(stats->max_wall_usec));
+    json_object_put(json, "histogram_ms", histogram);
+    return json;
+}
+
+static struct json *
+engine_node_latency_to_json(const struct engine_node *node)
+{
+    struct json *inputs = json_object_create();
+    for (size_t i = 0; i < node->n_inputs; i++) {
+        const struct engine_node_input *input = &node->inputs[i];
+        const struct engine_input_stats *stats = &node->input_stats[i];
+        struct json *json = json_object_create();
+
+        if (input->change_handler) {
+            json_object_put_string(json, "handler",
+                                   input->change_handler_name);
+            json_object_put(json, "latency",
+                            engine_latency_to_json(&stats->handler));
+        }
+        json_object_put(json, "recompute_missing_handler",
+                        json_integer_create(stats->recompute_missing_handler));
+        json_object_put(json, "recompute_failed_handler",
+                        json_integer_create(stats->recompute_failed_handler));
+        json_object_put(inputs, input->node->name, json);
+    }
+
+    struct json *json = json_object_create();
+    json_object_put(json, "recompute",
+                    json_integer_create(node->stats.recompute));
+    json_object_put(json, "compute", json_integer_create(node->stats.compute));
+    json_object_put(json, "cancel", json_integer_create(node->stats.cancel));
+    json_object_put(json, "recompute_forced",
+                    json_integer_create(node->stats.recompute_forced));
+    json_object_put(json, "run", engine_latency_to_json(&node->stats.run));
+    json_object_put(json, "inputs", inputs);
+    return json;
+}
+
+static void
+engine_node_latency_format(struct ds *s, const struct engine_node *node)
+{
+    ds_put_format(s, "Node: %s\n", node->name);
+    ds_put_format(s, "- recompute forced: %"PRIu64"\n",
+                  node->stats.recompute_forced);
+    ds_put_cstr(s, "- run: ");
+    engine_latency_format(s, &node->stats.run);
+
+    for (size_t i = 0; i < node->n_inputs; i++) {
+        const struct engine_node_input *input = &node->inputs[i];
+        const struct engine_input_stats *stats = &node->input_stats[i];
+
+        ds_put_format(s, "- input %s: recompute missing handler: %"PRIu64
+                      ", recompute failed handler: %"PRIu64"\n",
+                      input->node->name, stats->recompute_missing_handler,
+                      stats->recompute_failed_handler);
+        if (input->change_handler) {
+            ds_put_format(s, "  - %s: ", input->change_handler_name);
+            engine_latency_format(s, &stats->handler);
+        }
+    }
+}
+
+static void
+engine_dump_latency(struct unixctl_conn *conn, int argc,
+                    const char *argv[], void *arg OVS_UNUSED)
+{
+    bool as_json = false;
+    const char *node_name = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--json")) {
+            as_json = true;
+        } else if (!node_name) {
+            node_name = argv[i];
+        } else {
+            unixctl_command_reply_error(conn, "too many arguments");
+            return;
+        }
+    }
+
+    struct json *json = as_json ? json_object_create() : NULL;
+    struct ds dump = DS_EMPTY_INITIALIZER;
+    struct engine_node *node;
+    VECTOR_FOR_EACH (&engine_nodes, node) {
+        if (node_name && strcmp(node->name, node_name)) {
+            continue;
+        }
+
+        if (json) {
+            json_object_put(json, node->name,
+                            engine_node_latency_to_json(node));
+        } else {
+            engine_node_latency_format(&dump, node);
+        }
+    }
+
+    if (json) {
+        json_to_ds(json, JSSF_SORT, &dump);
+        json_destroy(json);
+    }
+    unixctl_command_reply(conn, ds_cstr(&dump));
+    ds_destroy(&dump);
+}
+
 static void
 engine_dump_stats(struct unixctl_conn *conn, int argc,
                   const char *argv[], void *arg OVS_UNUSED)
@@ -226,13 +481,76 @@ engine_get_compute_failure_info(struct engine_node *node)
     VLOG_DBG("Node \"%s\" is missing compute failure debug info.", node->name);
 }
 
+/* Builds the 'outputs' array of each engine node, i.e., the reverse edges
+ * of the graph, used by the parallel scheduler. */
+static void
+engine_link_outputs(void)
+{
+    struct engine_node *node;
+    VECTOR_FOR_EACH (&engine_nodes, node) {
+        for (size_t i = 0; i < node->n_inputs; i++) {
+            node->inputs[i].node->n_outputs++;
+        }
+    }
+
+    VECTOR_FOR_EACH (&engine_nodes, node) {
+        node->outputs = xcalloc(node->n_outputs, sizeof *node->outputs);
+        node->n_outputs = 0;
+    }
+
+    VECTOR_FOR_EACH (&engine_nodes, node) {
+        for (size_t i = 0; i < node->n_inputs; i++) {
+            struct engine_node *input = node->inputs[i].node;
+            input->outputs[input->n_outputs++] = node;
+        }
+    }
+}
+
+static void
+engine_set_time_budget_cmd(struct unixctl_conn *conn, int argc OVS_UNUSED,
+                           const char *argv[], void *arg OVS_UNUSED)
+{
+    unsigned int msec;
+    if (!str_to_uint(argv[1], 10, &msec)) {
+        unixctl_command_reply_error(conn, "unsigned integer required");
+        return;
+    }
+    engine_set_time_budget(msec);
+    unixctl_command_reply(conn, NULL);
+}
+
+static void
+engine_force_yield_cmd(struct unixctl_conn *conn, int argc OVS_UNUSED,
+                       const char *argv[] OVS_UNUSED, void *arg OVS_UNUSED)
+{
+    engine_force_yield = true;
+    unixctl_command_reply(conn, NULL);
+}
+
+static void
+engine_set_n_threads_cmd(struct unixctl_conn *conn, int argc OVS_UNUSED,
+                         const char *argv[], void *arg OVS_UNUSED)
+{
+    unsigned int n_threads;
+    if (!str_to_uint(argv[1], 10, &n_threads)
+        || !n_threads || n_threads > ENGINE_MAX_THREADS) {
+        unixctl_command_reply_error(conn, "invalid n_threads");
+        return;
+    }
+    engine_set_n_threads(n_threads);
+    unixctl_command_reply(conn, NULL);
+}
+
 void
 engine_init(struct engine_node *node, struct engine_arg *arg)
 {
     engine_topo_sort(node, &engine_nodes);
+    engine_link_outputs();
 
+    bool has_thread_safe_nodes = false;
     struct engine_node *sorted_node;
     VECTOR_FOR_EACH (&engine_nodes, sorted_node) {
+        has_thread_safe_nodes |= sorted_node->thread_safe;
         if (sorted_node->init) {
             sorted_node->data = sorted_node->init(sorted_node, arg);
         } else {
@@ -243,6 +561,8 @@ engine_init(struct engine_node *node, struct engine_arg *arg)
             sorted_node->get_compute_failure_info =
                 engine_get_compute_failure_info;
         }
+        sorted_node->input_stats = xcalloc(sorted_node->n_inputs,
+                                           sizeof *sorted_node->input_stats);
         stopwatch_create(sorted_node->name, SW_MS);
     }
 
@@ -250,17 +570,31 @@ engine_init(struct engine_node *node, struct engine_arg *arg)
                              engine_dump_stats, NULL);
     unixctl_command_register("inc-engine/clear-stats", "", 0, 0,
                              engine_clear_stats, NULL);
+    unixctl_command_register("inc-engine/show-latency", "[--json] [NODE]",
+                             0, 2, engine_dump_latency, NULL);
     unixctl_command_register("inc-engine/recompute", "", 0, 0,
                              engine_trigger_recompute_cmd, NULL);
     unixctl_command_register("inc-engine/compute-log-timeout", "", 1, 1,
                              engine_set_log_timeout_cmd, NULL);
     unixctl_command_register("inc-engine/list-stopwatches", "", 0, 1,
                              engine_list_stopwatch_cmd, NULL);
+    if (has_thread_safe_nodes) {
+        /* Without thread safe nodes the parallel scheduler would still run
+         * every node on the main thread, don't advertise it. */
+        unixctl_command_register("inc-engine/set-n-threads", "N", 1, 1,
+                                 engine_set_n_threads_cmd, NULL);
+    }
+    unixctl_command_register("inc-engine/set-time-budget", "MSEC", 1, 1,
+                             engine_set_time_budget_cmd, NULL);
+    unixctl_command_register("inc-engine/force-yield", "", 0, 0,
+                             engine_force_yield_cmd, NULL);
 }
 
 void
 engine_cleanup(void)
 {
+    engine_set_n_threads(1);
+
     struct engine_node *node;
     VECTOR_FOR_EACH (&engine_nodes, node) {
         if (node->clear_tracked_data) {
@@ -271,8 +605,12 @@ engine_cleanup(void)
             node->cleanup(node->data);
         }
         free(node->data);
+        free(node->outputs);
+        free(node->input_stats);
     }
     vector_destroy(&engine_nodes);
+    vector_destroy(&engine_sched.queued);
+    vector_destroy(&engine_sched.completed);
 }
 
 struct engine_node *
@@ -419,7 +757,7 @@ engine_has_updated(void)
 bool
 engine_canceled(void)
 {
-    return engine_run_canceled;
+    return engine_run_canceled || engine_run_yielded;
 }
 
 void *
@@ -454,20 +792,28 @@ engine_init_run(void)
 static enum engine_node_state
 run_recompute_callback(struct engine_node *node)
 {
+    long long int wall_start = time_usec();
+    long long int cpu_start = engine_thread_cpu_usec();
     enum engine_node_state ret;
     stopwatch_start(node->name, time_msec());
     ret = node->run(node, node->data);
     stopwatch_stop(node->name, time_msec());
+    engine_latency_record(&node->stats.run, wall_start, cpu_start);
     return ret;
 }
 
 static enum engine_input_handler_result
-run_change_handler(struct engine_node *node, struct engine_node_input *input)
+run_change_handler(struct engine_node *node, size_t input_idx)
 {
+    struct engine_node_input *input = &node->inputs[input_idx];
+    long long int wall_start = time_usec();
+    long long int cpu_start = engine_thread_cpu_usec();
     enum engine_input_handler_result ret;
     stopwatch_start(input->change_handler_name, time_msec());
     ret = input->change_handler(node, node->data);
     stopwatch_stop(input->change_handler_name, time_msec());
+    engine_latency_record(&node->input_stats[input_idx].handler,
+                          wall_start, cpu_start);
     return ret;
 }
 
@@ -502,6 +848,7 @@ engine_recompute(struct engine_node *node, bool allowed,
     engine_set_node_state(node, run_recompute_callback(node),
                           "recompute run() result");
     node->stats.recompute++;
+    node->recompute_pending = false;
     long long int delta_time = time_msec() - now;
     if (delta_time > engine_compute_log_timeout_msec) {
         static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(20, 10);
@@ -529,7 +876,7 @@ engine_compute(struct engine_node *node, bool recompute_allowed)
              */
             long long int now = time_msec();
             enum engine_input_handler_result handled;
-            handled = run_change_handler(node, &node->inputs[i]);
+            handled = run_change_handler(node, i);
             long long int delta_time = time_msec() - now;
             if (delta_time > engine_compute_log_timeout_msec) {
                 static struct vlog_rate_limit rl =
@@ -541,6 +888,7 @@ engine_compute(struct engine_node *node, bool recompute_allowed)
                          node->name, input_node->name, delta_time);
             }
             if (handled == EN_UNHANDLED) {
+                node->input_stats[i].recompute_failed_handler++;
                 input_node->get_compute_failure_info(input_node);
                 engine_recompute(node, recompute_allowed,
                                  "failed handler for input %s",
@@ -572,8 +920,10 @@ engine_run_node(struct engine_node *node, bool recompute_allowed)
         return;
     }
 
-    if (engine_force_recompute) {
-        engine_recompute(node, recompute_allowed, "forced");
+    if (engine_force_recompute || node->recompute_pending) {
+        node->stats.recompute_forced++;
+        engine_recompute(node, recompute_allowed,
+                         engine_force_recompute ? "forced" : "resumed");
         return;
     }
 
@@ -588,6 +938,7 @@ engine_run_node(struct engine_node *node, bool recompute_allowed)
 
             /* Trigger a recompute if we don't have a change handler. */
             if (!node->inputs[i].change_handler) {
+                node->input_stats[i].recompute_missing_handler++;
                 engine_recompute(node, recompute_allowed,
                                  "missing handler for input %s",
                                  input_node->name);
@@ -614,6 +965,239 @@ engine_run_node(struct engine_node *node, bool recompute_allowed)
     }
 }
 
+static void *
+engine_worker_main(void *arg OVS_UNUSED)
+{
+    ovs_mutex_lock(&engine_sched.mutex);
+    for (;;) {
+        while (!engine_sched.exiting
+               && vector_is_empty(&engine_sched.queued)) {
+            ovs_mutex_cond_wait(&engine_sched.work_cond, &engine_sched.mutex);
+        }
+        if (engine_sched.exiting) {
+            break;
+        }
+
+        struct engine_node *node;
+        vector_remove(&engine_sched.queued, 0, &node);
+        bool recompute_allowed = engine_sched.recompute_allowed;
+        ovs_mutex_unlock(&engine_sched.mutex);
+
+        engine_run_node(node, recompute_allowed);
+
+        ovs_mutex_lock(&engine_sched.mutex);
+        vector_push(&engine_sched.completed, &node);
+        xpthread_cond_signal(&engine_sched.done_cond);
+    }
+    ovs_mutex_unlock(&engine_sched.mutex);
+    return NULL;
+}
+
+void
+engine_set_n_threads(size_t n_threads)
+{
+    size_t n_workers = n_threads > 1 ? n_threads - 1 : 0;
+    if (n_workers == engine_sched.n_workers) {
+        return;
+    }
+
+    if (engine_sched.n_workers) {
+        ovs_mutex_lock(&engine_sched.mutex);
+        engine_sched.exiting = true;
+        xpthread_cond_broadcast(&engine_sched.work_cond);
+        ovs_mutex_unlock(&engine_sched.mutex);
+
+        for (size_t i = 0; i < engine_sched.n_workers; i++) {
+            xpthread_join(engine_sched.workers[i], NULL);
+        }
+        free(engine_sched.workers);
+        engine_sched.workers = NULL;
+        engine_sched.n_workers = 0;
+        engine_sched.exiting = false;
+    }
+
+    VLOG_INFO("Using %"PRIuSIZE" thread(s) for incremental processing",
+              n_workers + 1);
+    if (!n_workers) {
+        return;
+    }
+
+    engine_sched.workers = xcalloc(n_workers, sizeof *engine_sched.workers);
+    for (size_t i = 0; i < n_workers; i++) {
+        engine_sched.workers[i] = ovs_thread_create("inc_proc_eng",
+                                                    engine_worker_main,
+                                                    NULL);
+    }
+    engine_sched.n_workers = n_workers;
+}
+
+/* Returns true if the engine should stop processing before 'node' because
+ * the current forced recompute exceeded its time budget, or because a yield
+ * was requested through "inc-engine/force-yield".  A recompute that was
+ * already resumed once always runs to completion, to make sure it
+ * eventually finishes. */
+static bool
+engine_should_yield(const struct engine_node *node)
+{
+    if (!node->resumable || engine_run_resuming || !engine_force_recompute) {
+        return false;
+    }
+
+    long long int elapsed = time_msec() - engine_run_start;
+    if (engine_force_yield) {
+        engine_force_yield = false;
+    } else if (!engine_time_budget_msec
+               || elapsed < engine_time_budget_msec) {
+        return false;
+    }
+
+    VLOG_DBG("node: %s, yielding after %lldms of recompute", node->name,
+             elapsed);
+    COVERAGE_INC(engine_run_yield);
+    engine_run_yielded = true;
+    return true;
+}
+
+static bool
+engine_run_interrupted(void)
+{
+    return engine_run_canceled || engine_run_yielded;
+}
+
+/* After a canceled or yielded run, marks the nodes that didn't complete so
+ * that the next run recomputes them.  The nodes that did complete already
+ * processed all their input changes and can stay incremental. */
+static void
+engine_set_recompute_pending(void)
+{
+    struct engine_node *node;
+    VECTOR_FOR_EACH (&engine_nodes, node) {
+        if (node->n_inputs && node->state != EN_UPDATED
+            && node->state != EN_UNCHANGED) {
+            node->recompute_pending = true;
+        }
+    }
+    engine_resume_pending = true;
+}
+
+/* Marks 'node' as processed by the parallel scheduler, appending to 'ready'
+ * the nodes that have no more inputs left to process. */
+static void
+engine_parallel_node_done(struct engine_node *node, struct vector *ready)
+{
+    if (node->state == EN_CANCELED) {
+        node->stats.cancel++;
+        engine_run_canceled = true;
+        return;
+    }
+
+    for (size_t i = 0; i < node->n_outputs; i++) {
+        struct engine_node *output = node->outputs[i];
+
+        ovs_assert(output->n_pending_inputs);
+        if (!--output->n_pending_inputs) {
+            vector_push(ready, &output);
+        }
+    }
+}
+
+/* Executes the engine nodes as soon as all their inputs are processed.
+ * Thread safe nodes are handed over to the worker threads.  The other nodes
+ * are executed by the main thread, concurrently with the workers, except for
+ * the ones that write to SB DB: those are executed only when no worker is
+ * busy, so that no other node can observe the SB IDL being modified.
+ * After a node is canceled no new node is started. */
+static void
+engine_run_parallel(bool recompute_allowed)
+{
+    struct ovsdb_idl_txn *sb_txn = engine_get_context()->ovnsb_idl_txn;
+    struct vector ready = VECTOR_EMPTY_INITIALIZER(struct engine_node *);
+    struct vector done = VECTOR_EMPTY_INITIALIZER(struct engine_node *);
+    size_t n_running = 0;
+
+    struct engine_node *node;
+    VECTOR_FOR_EACH (&engine_nodes, node) {
+        node->n_pending_inputs = node->n_inputs;
+        if (!node->n_inputs) {
+            vector_push(&ready, &node);
+        }
+    }
+
+    ovsdb_idl_txn_assert_read_only(sb_txn, true);
+    for (;;) {
+        if (!engine_run_interrupted()) {
+            bool queued = false;
+
+            ovs_mutex_lock(&engine_sched.mutex);
+            engine_sched.recompute_allowed = recompute_allowed;
+            for (size_t i = 0; i < vector_len(&ready);) {
+                node = vector_get(&ready, i, struct engine_node *);
+                if (engine_should_yield(node)) {
+                    break;
+                }
+                if (node->thread_safe && !node->sb_write && node->n_inputs) {
+                    vector_remove(&ready, i, NULL);
+                    vector_push(&engine_sched.queued, &node);
+                    n_running++;
+                    queued = true;
+                } else {
+                    i++;
+                }
+            }
+            if (queued) {
+                xpthread_cond_broadcast(&engine_sched.work_cond);
+            }
+            ovs_mutex_unlock(&engine_sched.mutex);
+        }
+
+        node = NULL;
+        for (size_t i = 0; !engine_run_interrupted() && i < vector_len(&ready);
+             i++) {
+            struct engine_node *candidate =
+                vector_get(&ready, i, struct engine_node *);
+            if (engine_should_yield(candidate)) {
+                break;
+            }
+            if (!candidate->sb_write || !n_running) {
+                vector_remove(&ready, i, &node);
+                break;
+            }
+        }
+
+        if (node) {
+            ovsdb_idl_txn_assert_read_only(sb_txn, !node->sb_write);
+            engine_run_node(node, recompute_allowed);
+            ovsdb_idl_txn_assert_read_only(sb_txn, true);
+            engine_parallel_node_done(node, &ready);
+            continue;
+        }
+
+        if (!n_running) {
+            break;
+        }
+
+        ovs_mutex_lock(&engine_sched.mutex);
+        while (vector_is_empty(&engine_sched.completed)) {
+            ovs_mutex_cond_wait(&engine_sched.done_cond, &engine_sched.mutex);
+        }
+        VECTOR_FOR_EACH (&engine_sched.completed, node) {
+            vector_push(&done, &node);
+        }
+        vector_clear(&engine_sched.completed);
+        ovs_mutex_unlock(&engine_sched.mutex);
+
+        VECTOR_FOR_EACH (&done, node) {
+            n_running--;
+            engine_parallel_node_done(node, &ready);
+        }
+        vector_clear(&done);
+    }
+    ovsdb_idl_txn_assert_read_only(sb_txn, false);
+
+    vector_destroy(&ready);
+    vector_destroy(&done);
+}
+
 void
 engine_run(bool recompute_allowed)
 {
@@ -627,18 +1211,38 @@ engine_run(bool recompute_allowed)
     struct ovsdb_idl_txn *sb_txn = engine_get_context()->ovnsb_idl_txn;
 
     engine_run_canceled = false;
-    struct engine_node *node;
-    VECTOR_FOR_EACH (&engine_nodes, node) {
-        ovsdb_idl_txn_assert_read_only(sb_txn, !node->sb_write);
-        engine_run_node(node, recompute_allowed);
-        ovsdb_idl_txn_assert_read_only(sb_txn, false);
+    engine_run_yielded = false;
+    engine_run_resuming = engine_resume_pending;
+    engine_resume_pending = false;
+    if (engine_run_resuming) {
+        COVERAGE_INC(engine_run_resume);
+    }
+    engine_run_start = time_msec();
 
-        if (node->state == EN_CANCELED) {
-            node->stats.cancel++;
-            engine_run_canceled = true;
-            return;
+    if (engine_sched.n_workers) {
+        engine_run_parallel(recompute_allowed);
+    } else {
+        struct engine_node *node;
+        VECTOR_FOR_EACH (&engine_nodes, node) {
+            if (engine_should_yield(node)) {
+                break;
+            }
+
+            ovsdb_idl_txn_assert_read_only(sb_txn, !node->sb_write);
+            engine_run_node(node, recompute_allowed);
+            ovsdb_idl_txn_assert_read_only(sb_txn, false);
+
+            if (node->state == EN_CANCELED) {
+                node->stats.cancel++;
+                engine_run_canceled = true;
+                break;
+            }
         }
     }
+
+    if (engine_run_interrupted()) {
+        engine_set_recompute_pending();
+    }
 }
 
 bool
@@ -218,10 +218,38 @@ struct engine_node_input {
         (struct engine_node *node, void *data);
 };
 
+/* Number of buckets of the engine latency histograms.  The upper bounds of
+ * the buckets, in milliseconds, are 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000
+ * and 5000; the last bucket counts all the longer samples. */
+#define ENGINE_LATENCY_N_BUCKETS 12
+
+/* Latency of the run() method or of a change handler of a node. */
+struct engine_latency_stats {
+    uint64_t n_samples;
+    uint64_t wall_usec;             /* Total wall clock time. */
+    uint64_t cpu_usec;              /* Total CPU time of the thread. */
+    uint64_t max_wall_usec;
+    uint64_t buckets[ENGINE_LATENCY_N_BUCKETS]; /* Wall clock histogram. */
+};
+
+/* Statistics of each input of a node, kept outside of the inputs array to
+ * not bloat the statically allocated engine nodes. */
+struct engine_input_stats {
+    struct engine_latency_stats handler;
+
+    /* Number of times a change of the input caused a recompute of the node
+     * because there was no change handler, or because it failed. */
+    uint64_t recompute_missing_handler;
+    uint64_t recompute_failed_handler;
+};
+
 struct engine_stats {
     uint64_t recompute;
     uint64_t compute;
     uint64_t cancel;
+
+    uint64_t recompute_forced;      /* Recomputes due to a forced run. */
+    struct engine_latency_stats run;
 };
 
 struct engine_node {
@@ -280,8 +308,34 @@ struct engine_node {
     /* Engine stats. */
     struct engine_stats stats;
 
+    /* Per input stats, 'n_inputs' elements allocated by engine_init(). */
+    struct engine_input_stats *input_stats;
+
     /* Indication if the node writes to SB DB. */
     bool sb_write;
+
+    /* Indication if run() and the change handlers of the node access only
+     * the node's own data and (read-only) the data of its inputs, in which
+     * case the parallel scheduler may execute the node on a worker thread,
+     * concurrently with other nodes.  Nodes writing to SB DB are always
+     * executed on the main thread. */
+    bool thread_safe;
+
+    /* Indication if the engine may yield right before running this node
+     * when a forced recompute exceeds its time budget, and resume the
+     * recompute from this node in the next engine_run(). */
+    bool resumable;
+
+    /* Set if the node didn't complete during a canceled or yielded run and
+     * must be recomputed by the next run. */
+    bool recompute_pending;
+
+    /* Nodes that have this node as input and the number of inputs that
+     * still need to be processed in the current run.  Used internally by
+     * the parallel scheduler. */
+    struct engine_node **outputs;
+    size_t n_outputs;
+    size_t n_pending_inputs;
 };
 
 /* Initialize the data for the engine nodes. It calls each node's
@@ -301,6 +355,22 @@ void engine_init_run(void);
  */
 void engine_run(bool recompute_allowed);
 
+/* Sets the number of threads used by engine_run() to 'n_threads'.  If
+ * 'n_threads' is greater than 1, nodes marked as THREAD_SAFE whose inputs
+ * have all been processed are executed concurrently on 'n_threads' - 1
+ * worker threads while the main thread executes the remaining nodes.
+ * Otherwise, which is the default, all nodes are executed serially in
+ * topological order. */
+void engine_set_n_threads(size_t n_threads);
+
+/* Sets the time budget of a forced recompute to 'msec' milliseconds, 0 for
+ * no limit (the default).  When it is exceeded, engine_run() yields before
+ * the next RESUMABLE node and reports the run as canceled, so that the main
+ * loop can process other events.  The next engine_run() after
+ * engine_set_resume_immediate() recomputes only the nodes that didn't
+ * complete and is never interrupted by the time budget. */
+void engine_set_time_budget(long long int msec);
+
 /* Clean up the data for the engine nodes. It calls each node's
  * cleanup() method if not NULL. It should be called before the program
  * terminates. */
@@ -351,6 +421,14 @@ void engine_dump_graph(const char *node_name);
  * immediately and the next engine run is not delayed. */
 void engine_set_force_recompute_immediate(void);
 
+/* Schedules an immediate engine run that resumes the last canceled run:
+ * only the nodes that didn't complete are recomputed, the other ones keep
+ * processing their inputs incrementally. */
+void engine_set_resume_immediate(void);
+
+/* Returns true if the last run was canceled and needs to be resumed. */
+bool engine_need_resume(void);
+
 /* Clear the force flag for the next run so the engine does the
  * usual processing without forced full recompute. */
 void engine_clear_force_recompute(void);
@@ -460,6 +538,12 @@ void engine_ovsdb_node_add_index(struct engine_node *, const char *name,
 #define SB_WRITE(NAME) \
     .sb_write = true
 
+#define THREAD_SAFE(NAME) \
+    .thread_safe = true
+
+#define RESUMABLE(NAME) \
+    .resumable = true
+
 #define ENGINE_NODE2(NAME, ARG1) \
     ENGINE_NODE_DEF_START(NAME, #NAME) \
     ARG1(NAME), \
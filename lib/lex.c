@@ -316,6 +316,48 @@ lex_token_format(const struct lex_token *token, struct ds *s)
 
 /* lex_token_parse(). */
 
+/* Character classes, indexed by byte value, so that the lexer's inner loops
+ * classify a character with a single table lookup. */
+enum {
+    LEX_C_ID1 = 1 << 0,         /* May start an identifier. */
+    LEX_C_DIGIT = 1 << 1,       /* 0...9. */
+    LEX_C_HEX = 1 << 2,         /* 0...9, a...f, A...F. */
+    LEX_C_ALNUM = 1 << 3,       /* 0...9, a...z, A...Z. */
+};
+
+/* May continue an identifier. */
+#define LEX_C_IDN (LEX_C_ID1 | LEX_C_DIGIT)
+
+#define D (LEX_C_DIGIT | LEX_C_HEX | LEX_C_ALNUM)
+#define H (LEX_C_ID1 | LEX_C_HEX | LEX_C_ALNUM)
+#define L (LEX_C_ID1 | LEX_C_ALNUM)
+#define U LEX_C_ID1
+static const uint8_t lex_char_class[256] = {
+    ['0'] = D, ['1'] = D, ['2'] = D, ['3'] = D, ['4'] = D, ['5'] = D,
+    ['6'] = D, ['7'] = D, ['8'] = D, ['9'] = D,
+    ['a'] = H, ['b'] = H, ['c'] = H, ['d'] = H, ['e'] = H, ['f'] = H,
+    ['A'] = H, ['B'] = H, ['C'] = H, ['D'] = H, ['E'] = H, ['F'] = H,
+    ['g'] = L, ['h'] = L, ['i'] = L, ['j'] = L, ['k'] = L, ['l'] = L,
+    ['m'] = L, ['n'] = L, ['o'] = L, ['p'] = L, ['q'] = L, ['r'] = L,
+    ['s'] = L, ['t'] = L, ['u'] = L, ['v'] = L, ['w'] = L, ['x'] = L,
+    ['y'] = L, ['z'] = L,
+    ['G'] = L, ['H'] = L, ['I'] = L, ['J'] = L, ['K'] = L, ['L'] = L,
+    ['M'] = L, ['N'] = L, ['O'] = L, ['P'] = L, ['Q'] = L, ['R'] = L,
+    ['S'] = L, ['T'] = L, ['U'] = L, ['V'] = L, ['W'] = L, ['X'] = L,
+    ['Y'] = L, ['Z'] = L,
+    ['_'] = U, ['.'] = U,
+};
+#undef D
+#undef H
+#undef L
+#undef U
+
+static inline bool
+lex_char_is(unsigned char c, uint8_t class)
+{
+    return (lex_char_class[c] & class) != 0;
+}
+
 static void OVS_PRINTF_FORMAT(2, 3)
 lex_error(struct lex_token *token, const char *message, ...)
 {
@@ -383,11 +425,18 @@ lex_parse_integer__(const char *p, struct lex_token *token)
     const char *start = p;
     const char *end = start;
     bool saw_dot = false;
-    while (isalnum((unsigned char) *end)
-           || (*end == ':' && !saw_dot)
-           || (*end == '.' && end[1] != '.')) {
-        if (*end == '.') {
+    bool all_digits = true;
+    for (;;) {
+        unsigned char c = *end;
+        if (lex_char_is(c, LEX_C_ALNUM)) {
+            all_digits = all_digits && lex_char_is(c, LEX_C_DIGIT);
+        } else if (c == '.' && end[1] != '.') {
             saw_dot = true;
+            all_digits = false;
+        } else if (c == ':' && !saw_dot) {
+            all_digits = false;
+        } else {
+            break;
         }
         end++;
     }
@@ -404,7 +453,7 @@ lex_parse_integer__(const char *p, struct lex_token *token)
                && n == len) {
         token->value.mac = mac;
         token->format = LEX_F_ETHERNET;
-    } else if (start + strspn(start, "0123456789") == end) {
+    } else if (all_digits) {
         if (p[0] == '0' && len > 1) {
             lex_error(token, "Decimal constants must not have leading zeros.");
         } else {
@@ -514,6 +563,7 @@ static const char *
 lex_parse_string(const char *p, struct lex_token *token)
 {
     const char *start = ++p;
+    bool escaped = false;
     char * s = NULL;
     for (;;) {
         switch (*p) {
@@ -522,12 +572,20 @@ lex_parse_string(const char *p, struct lex_token *token)
             return p;
 
         case '"':
+            if (!escaped) {
+                /* Without escapes there is nothing to unescape, so copy the
+                 * string directly, into 'token->buffer' if it fits. */
+                token->type = LEX_T_STRING;
+                lex_token_strcpy(token, start, p - start);
+                return p + 1;
+            }
             token->type = (json_string_unescape(start, p - start, &s)
                            ? LEX_T_STRING : LEX_T_ERROR);
             lex_token_strset(token, s);
             return p + 1;
 
         case '\\':
+            escaped = true;
             p++;
             if (*p) {
                 p++;
@@ -544,14 +602,13 @@ lex_parse_string(const char *p, struct lex_token *token)
 static bool
 lex_is_id1(unsigned char c)
 {
-    return ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
-            || c == '_' || c == '.');
+    return lex_char_is(c, LEX_C_ID1);
 }
 
 static bool
 lex_is_idn(unsigned char c)
 {
-    return lex_is_id1(c) || (c >= '0' && c <= '9');
+    return lex_char_is(c, LEX_C_IDN);
 }
 
 static const char *
@@ -808,9 +865,15 @@ next:
          * identifier.  Fortunately, Ethernet addresses and IPv6 addresses that
          * are ambiguous based on the first character, always start with hex
          * digits followed by a colon, but identifiers never do. */
-        p = (p[strspn(p, "0123456789abcdefABCDEF")] == ':'
-             ? lex_parse_integer(p, token)
-             : lex_parse_id(p, LEX_T_ID, token));
+        {
+            const char *q = p;
+            while (lex_char_is(*q, LEX_C_HEX)) {
+                q++;
+            }
+            p = (*q == ':'
+                 ? lex_parse_integer(p, token)
+                 : lex_parse_id(p, LEX_T_ID, token));
+        }
         break;
 
     default:
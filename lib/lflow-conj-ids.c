@@ -26,10 +26,20 @@ COVERAGE_DEFINE(lflow_conj_alloc_specified);
 COVERAGE_DEFINE(lflow_conj_free);
 COVERAGE_DEFINE(lflow_conj_free_unexpected);
 
-/* Node in struct conj_ids.conj_id_allocations. */
-struct conj_id_node {
+/* The allocated conjunction ids are tracked in a sparse hierarchical bitmap.
+ * Level 0 has one bit per conjunction id.  Each bit in level N > 0 stands for
+ * a 64-bit word of level N - 1 and is set if that word is full, which allows
+ * skipping over long runs of allocated ids with a handful of lookups.  Only
+ * words that have at least one bit set are stored.  Level 0 has 2**32 bits,
+ * so the top level (5) fits in a single word. */
+#define CONJ_ID_BITMAP_LEVELS 6
+
+/* Node in struct conj_ids.conj_id_bitmap. */
+struct conj_id_bitmap_node {
     struct hmap_node hmap_node;
-    uint32_t conj_id;
+    uint32_t level;
+    uint32_t index;             /* Word index within 'level'. */
+    uint64_t bits;
 };
 
 struct lflow_conj_node {
@@ -64,6 +74,10 @@ static void lflow_conj_ids_free_for_lflow_dp(struct conj_ids *,
                                              const struct uuid *dp_uuid);
 static struct lflow_to_dps_node *lflow_to_dps_find(struct conj_ids *,
                                                    const struct uuid *);
+static bool conj_id_bitmap_find_clear(const struct conj_ids *, uint32_t level,
+                                      uint64_t start, uint64_t *bitp);
+static bool conj_id_bitmap_find_set(const struct conj_ids *, uint64_t start,
+                                    uint64_t end, uint64_t *bitp);
 static inline uint32_t
 hash_lflow_dp(const struct uuid *lflow_uuid, const struct uuid *dp_uuid)
 {
@@ -89,18 +103,15 @@ lflow_conj_ids_set_test_mode(bool mode)
  *
  * The algorithm tries to allocate the hash result of the combination of the
  * lflow_uuid and dp_uuid as the first conjunction id. If it is unavailable, or
- * any of the subsequent n_conjs - 1 ids are unavailable, iterate until the
- * next available n_conjs ids are found.  Given that n_conjs is very small (in
- * most cases will be 1), the algorithm should be efficient enough and in most
- * cases just return the hash value, which ensures conjunction ids are
- * consistent for the same logical flow + DP in most cases.
+ * any of the subsequent n_conjs - 1 ids are unavailable, the first range of
+ * n_conjs free ids after it is used, wrapping around to 1 if the end of the
+ * id space is reached.  In most cases this just returns the hash value, which
+ * ensures conjunction ids are consistent for the same logical flow + DP, and
+ * otherwise the result is still deterministic for a given set of allocations.
  *
- * The performance will degrade if most of the uint32_t are allocated because
- * conflicts will happen a lot. In practice this is not expected to happen in
- * reasonable scale. Otherwise, if the amount of logical flows is close to
- * this (4G logical flows that need conjunction ids) there are other parts of
- * the system expected to be suffered even before reaching to a scale much
- * smaller than this. */
+ * Looking for the next free id takes a bounded number of lookups in the
+ * hierarchical bitmap, regardless of how many ids are allocated after the
+ * hash value, so the allocation stays cheap as the id space fills up. */
 uint32_t
 lflow_conj_ids_alloc(struct conj_ids *conj_ids, const struct uuid *lflow_uuid,
                      const struct uuid *dp_uuid, uint32_t n_conjs)
@@ -112,55 +123,46 @@ lflow_conj_ids_alloc(struct conj_ids *conj_ids, const struct uuid *lflow_uuid,
 
     COVERAGE_INC(lflow_conj_alloc);
 
-    uint32_t start_conj_id = hash_lflow_dp(lflow_uuid, dp_uuid);
-    if (start_conj_id == 0) {
-        start_conj_id++;
+    uint32_t initial_id = hash_lflow_dp(lflow_uuid, dp_uuid);
+    if (initial_id == 0) {
+        initial_id++;
     }
-    uint32_t initial_id = start_conj_id;
-    bool initial = true;
+    uint64_t start_conj_id = initial_id;
+    bool wrapped = false;
     while (true) {
-        if (start_conj_id == 0) {
-            start_conj_id++;
-        }
-        bool available = true;
-        uint32_t conj_id = start_conj_id;
-        for (uint32_t i = 0; i < n_conjs; i++) {
-            if (conj_id == 0) {
-                /* Overflow. Consider the current range as unavailable because
-                 * we need a continuous range. Start over from 1 (0 is
-                 * skipped). */
-                available = false;
-                break;
-            }
-            if (!initial && conj_id == initial_id) {
-                /* It has checked all ids (extreme situation, not expected in
-                 * real environment). */
+        uint64_t conj_id;
+        if (!conj_id_bitmap_find_clear(conj_ids, 0, start_conj_id, &conj_id)
+            || conj_id + n_conjs > UINT64_C(1) << 32) {
+            /* No continuous range available before the end of the id space.
+             * Start over from 1 (0 is skipped). */
+            if (wrapped) {
                 return 0;
             }
-            initial = false;
-            struct conj_id_node *conj_id_node;
-            /* conj_id is both the key and the hash */
-            HMAP_FOR_EACH_WITH_HASH (conj_id_node, hmap_node, conj_id,
-                                     &conj_ids->conj_id_allocations) {
-                if (conj_id_node->conj_id == conj_id) {
-                    available = false;
-                    COVERAGE_INC(lflow_conj_conflict);
-                    break;
-                }
-            }
-            if (!available) {
-                break;
-            }
-            conj_id++;
+            wrapped = true;
+            start_conj_id = 1;
+            continue;
         }
-        if (available) {
-            break;
+        if (wrapped && conj_id + n_conjs > initial_id) {
+            /* It has checked all ids (extreme situation, not expected in
+             * real environment). */
+            return 0;
+        }
+        if (conj_id != start_conj_id) {
+            COVERAGE_INC(lflow_conj_conflict);
+        }
+
+        uint64_t used_id;
+        if (conj_id_bitmap_find_set(conj_ids, conj_id, conj_id + n_conjs,
+                                    &used_id)) {
+            COVERAGE_INC(lflow_conj_conflict);
+            start_conj_id = used_id + 1;
+            continue;
         }
-        start_conj_id = conj_id + 1;
+
+        lflow_conj_ids_insert_(conj_ids, lflow_uuid, dp_uuid, conj_id,
+                               n_conjs);
+        return conj_id;
     }
-    lflow_conj_ids_insert_(conj_ids, lflow_uuid, dp_uuid, start_conj_id,
-                           n_conjs);
-    return start_conj_id;
 }
 
 /* Similar to lflow_conj_ids_alloc, except that it takes an extra parameter
@@ -179,19 +181,13 @@ lflow_conj_ids_alloc_specified(struct conj_ids *conj_ids,
     }
     lflow_conj_ids_free_for_lflow_dp(conj_ids, lflow_uuid, dp_uuid);
 
-    uint32_t conj_id = start_conj_id;
-    for (uint32_t i = 0; i < n_conjs; i++) {
-        if (!conj_id) {
-            return false;
-        }
-        struct conj_id_node *conj_id_node;
-        HMAP_FOR_EACH_WITH_HASH (conj_id_node, hmap_node, conj_id,
-                                 &conj_ids->conj_id_allocations) {
-            if (conj_id_node->conj_id == conj_id) {
-                return false;
-            }
-        }
-        conj_id++;
+    uint64_t used_id;
+    if (!start_conj_id
+        || (uint64_t) start_conj_id + n_conjs > UINT64_C(1) << 32
+        || conj_id_bitmap_find_set(conj_ids, start_conj_id,
+                                   (uint64_t) start_conj_id + n_conjs,
+                                   &used_id)) {
+        return false;
     }
     lflow_conj_ids_insert_(conj_ids, lflow_uuid, dp_uuid, start_conj_id,
                            n_conjs);
@@ -231,20 +227,19 @@ lflow_conj_ids_free(struct conj_ids *conj_ids, const struct uuid *lflow_uuid)
 void
 lflow_conj_ids_init(struct conj_ids *conj_ids)
 {
-    hmap_init(&conj_ids->conj_id_allocations);
+    hmap_init(&conj_ids->conj_id_bitmap);
+    conj_ids->n_conj_ids = 0;
     hmap_init(&conj_ids->lflow_conj_ids);
     hmap_init(&conj_ids->lflow_to_dps);
 }
 
 void
 lflow_conj_ids_destroy(struct conj_ids *conj_ids) {
-    struct conj_id_node *conj_id_node;
-    HMAP_FOR_EACH_SAFE (conj_id_node, hmap_node,
-                        &conj_ids->conj_id_allocations) {
-        hmap_remove(&conj_ids->conj_id_allocations, &conj_id_node->hmap_node);
-        free(conj_id_node);
+    struct conj_id_bitmap_node *bitmap_node;
+    HMAP_FOR_EACH_POP (bitmap_node, hmap_node, &conj_ids->conj_id_bitmap) {
+        free(bitmap_node);
     }
-    hmap_destroy(&conj_ids->conj_id_allocations);
+    hmap_destroy(&conj_ids->conj_id_bitmap);
 
     struct lflow_conj_node *lflow_conj;
     HMAP_FOR_EACH_SAFE (lflow_conj, hmap_node, &conj_ids->lflow_conj_ids) {
@@ -290,13 +285,137 @@ lflow_conj_ids_dump(struct conj_ids *conj_ids, struct ds *out_data)
     ds_put_cstr(out_data, "---\n");
     ds_put_format(out_data, "Total %"PRIuSIZE" IDs used.\n", count);
 
-    size_t allocated = hmap_count(&conj_ids->conj_id_allocations);
+    size_t allocated = conj_ids->n_conj_ids;
     if (count != allocated) {
         ds_put_format(out_data, "WARNING: mismatch - %"PRIuSIZE" allocated\n",
                       allocated);
     }
 }
 
+static struct conj_id_bitmap_node *
+conj_id_bitmap_find(const struct conj_ids *conj_ids, uint32_t level,
+                    uint32_t index)
+{
+    struct conj_id_bitmap_node *node;
+    HMAP_FOR_EACH_WITH_HASH (node, hmap_node, hash_int(index, level),
+                             &conj_ids->conj_id_bitmap) {
+        if (node->level == level && node->index == index) {
+            return node;
+        }
+    }
+    return NULL;
+}
+
+/* Marks 'conj_id' as allocated, propagating to the upper levels the words
+ * that become full. */
+static void
+conj_id_bitmap_set(struct conj_ids *conj_ids, uint32_t conj_id)
+{
+    uint64_t bit = conj_id;
+    for (uint32_t level = 0; level < CONJ_ID_BITMAP_LEVELS;
+         level++, bit >>= 6) {
+        uint32_t index = bit >> 6;
+        struct conj_id_bitmap_node *node = conj_id_bitmap_find(conj_ids,
+                                                               level, index);
+        if (!node) {
+            node = xmalloc(sizeof *node);
+            node->level = level;
+            node->index = index;
+            node->bits = 0;
+            hmap_insert(&conj_ids->conj_id_bitmap, &node->hmap_node,
+                        hash_int(index, level));
+        }
+        node->bits |= UINT64_C(1) << (bit & 63);
+        if (node->bits != UINT64_MAX) {
+            break;
+        }
+    }
+}
+
+/* Marks 'conj_id' as free.  Returns true if it was allocated. */
+static bool
+conj_id_bitmap_clear(struct conj_ids *conj_ids, uint32_t conj_id)
+{
+    uint64_t bit = conj_id;
+    bool was_set = false;
+    for (uint32_t level = 0; level < CONJ_ID_BITMAP_LEVELS;
+         level++, bit >>= 6) {
+        struct conj_id_bitmap_node *node = conj_id_bitmap_find(conj_ids,
+                                                               level,
+                                                               bit >> 6);
+        if (!node) {
+            break;
+        }
+
+        uint64_t mask = UINT64_C(1) << (bit & 63);
+        bool was_full = node->bits == UINT64_MAX;
+        if (!level) {
+            was_set = node->bits & mask;
+        }
+        node->bits &= ~mask;
+        if (!node->bits) {
+            hmap_remove(&conj_ids->conj_id_bitmap, &node->hmap_node);
+            free(node);
+        }
+        if (!was_full) {
+            break;
+        }
+    }
+    return was_set;
+}
+
+/* Finds the first clear bit at or after 'start' in 'level' of the bitmap, and
+ * stores it in '*bitp'.  Full words are skipped by looking for the next clear
+ * bit in the upper level.  Returns false if there is no clear bit until the
+ * end of the level. */
+static bool
+conj_id_bitmap_find_clear(const struct conj_ids *conj_ids, uint32_t level,
+                          uint64_t start, uint64_t *bitp)
+{
+    uint64_t n_bits = UINT64_C(1) << (32 - 6 * level);
+    while (start < n_bits) {
+        const struct conj_id_bitmap_node *node =
+            conj_id_bitmap_find(conj_ids, level, start >> 6);
+        uint64_t bits = node ? node->bits : 0;
+
+        bits |= (UINT64_C(1) << (start & 63)) - 1;
+        if (bits != UINT64_MAX) {
+            *bitp = (start & ~UINT64_C(63)) + raw_ctz(~bits);
+            return *bitp < n_bits;
+        }
+
+        uint64_t next_word;
+        if (level + 1 >= CONJ_ID_BITMAP_LEVELS
+            || !conj_id_bitmap_find_clear(conj_ids, level + 1,
+                                          (start >> 6) + 1, &next_word)) {
+            return false;
+        }
+        start = next_word << 6;
+    }
+    return false;
+}
+
+/* Finds the first allocated conjunction id in the range [start, end), and
+ * stores it in '*bitp'.  Returns false if the whole range is free. */
+static bool
+conj_id_bitmap_find_set(const struct conj_ids *conj_ids, uint64_t start,
+                        uint64_t end, uint64_t *bitp)
+{
+    while (start < end) {
+        const struct conj_id_bitmap_node *node =
+            conj_id_bitmap_find(conj_ids, 0, start >> 6);
+        if (node) {
+            uint64_t bits = node->bits & ~((UINT64_C(1) << (start & 63)) - 1);
+            if (bits) {
+                *bitp = (start & ~UINT64_C(63)) + raw_ctz(bits);
+                return *bitp < end;
+            }
+        }
+        start = (start | 63) + 1;
+    }
+    return false;
+}
+
 static struct lflow_to_dps_node *
 lflow_to_dps_find(struct conj_ids *conj_ids, const struct uuid *lflow_uuid)
 {
@@ -322,11 +441,10 @@ lflow_conj_ids_insert_(struct conj_ids *conj_ids,
     uint32_t conj_id = start_conj_id;
     for (uint32_t i = 0; i < n_conjs; i++) {
         ovs_assert(conj_id);
-        struct conj_id_node *node = xzalloc(sizeof *node);
-        node->conj_id = conj_id;
-        hmap_insert(&conj_ids->conj_id_allocations, &node->hmap_node, conj_id);
+        conj_id_bitmap_set(conj_ids, conj_id);
         conj_id++;
     }
+    conj_ids->n_conj_ids += n_conjs;
 
     struct lflow_conj_node *lflow_conj = xzalloc(sizeof *lflow_conj);
     lflow_conj->lflow_uuid = *lflow_uuid;
@@ -373,15 +491,8 @@ lflow_conj_ids_free_(struct conj_ids *conj_ids,
     uint32_t conj_id = lflow_conj->start_conj_id;
     for (uint32_t i = 0; i < lflow_conj->n_conjs; i++) {
         ovs_assert(conj_id);
-        struct conj_id_node *conj_id_node;
-        HMAP_FOR_EACH_WITH_HASH (conj_id_node, hmap_node, conj_id,
-                                 &conj_ids->conj_id_allocations) {
-            if (conj_id_node->conj_id == conj_id) {
-                hmap_remove(&conj_ids->conj_id_allocations,
-                            &conj_id_node->hmap_node);
-                free(conj_id_node);
-                break;
-            }
+        if (conj_id_bitmap_clear(conj_ids, conj_id)) {
+            conj_ids->n_conj_ids--;
         }
         conj_id++;
     }
@@ -22,8 +22,11 @@
 #include "uuid.h"
 
 struct conj_ids {
-    /* Allocated conjunction ids. Contains struct conj_id_node. */
-    struct hmap conj_id_allocations;
+    /* Allocated conjunction ids, as a sparse hierarchical bitmap. Contains
+     * struct conj_id_bitmap_node. */
+    struct hmap conj_id_bitmap;
+    /* Number of conjunction ids allocated. */
+    size_t n_conj_ids;
     /* A map from lflow + DP to the conjunction ids used. Contains struct
      * lflow_conj_node. */
     struct hmap lflow_conj_ids;
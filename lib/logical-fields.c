@@ -471,6 +471,9 @@ ovn_field_from_name(const char *name)
 static void
 expr_symtab_remove(struct shash *symtab, const char *name)
 {
+    /* Other symbols' precompiled expressions may refer to this one. */
+    expr_symtab_thaw(symtab);
+
     struct expr_symbol *symbol = shash_find_and_delete(symtab, name);
     if (symbol) {
         free(symbol->name);
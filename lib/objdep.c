@@ -18,12 +18,23 @@
 
 #include "lib/objdep.h"
 #include "lib/hash.h"
+#include "lib/simap.h"
 #include "lib/util.h"
 #include "openvswitch/vlog.h"
 
 VLOG_DEFINE_THIS_MODULE(resource_dep);
 
+/* Objects with at least this many resources get a hash index over their
+ * 'resources', so that objdep_mgr_add() doesn't need to scan them all to
+ * find out if a reference already exists. */
+#define OBJDEP_RES_INDEX_MIN 16
+
 static void resource_node_destroy(struct resource_to_objects_node *);
+static void object_node_destroy(struct object_to_resources_node *);
+static size_t object_node_find_resource(
+    const struct object_to_resources_node *,
+    const struct resource_to_objects_node *);
+static void object_node_index_resources(struct object_to_resources_node *);
 
 void
 objdep_mgr_init(struct objdep_mgr *mgr)
@@ -45,22 +56,13 @@ void
 objdep_mgr_clear(struct objdep_mgr *mgr)
 {
     struct resource_to_objects_node *resource_node;
-    HMAP_FOR_EACH_SAFE (resource_node, node, &mgr->resource_to_objects_table) {
-        struct object_to_resources_list_node *object_list_node;
-        HMAP_FOR_EACH_SAFE (object_list_node, hmap_node,
-                            &resource_node->objs) {
-            ovs_list_remove(&object_list_node->list_node);
-            hmap_remove(&resource_node->objs, &object_list_node->hmap_node);
-            free(object_list_node);
-        }
-        hmap_remove(&mgr->resource_to_objects_table, &resource_node->node);
+    HMAP_FOR_EACH_POP (resource_node, node, &mgr->resource_to_objects_table) {
         resource_node_destroy(resource_node);
     }
 
     struct object_to_resources_node *object_node;
-    HMAP_FOR_EACH_SAFE (object_node, node, &mgr->object_to_resources_table) {
-        hmap_remove(&mgr->object_to_resources_table, &object_node->node);
-        free(object_node);
+    HMAP_FOR_EACH_POP (object_node, node, &mgr->object_to_resources_table) {
+        object_node_destroy(object_node);
     }
 }
 
@@ -82,49 +84,51 @@ objdep_mgr_add_with_refcount(struct objdep_mgr *mgr, enum objdep_type type,
         objdep_mgr_find_resources(mgr, obj_uuid);
     if (resource_node && object_node) {
         /* Check if the mapping already existed before adding a new one. */
-        struct object_to_resources_list_node *n;
-        HMAP_FOR_EACH_WITH_HASH (n, hmap_node, uuid_hash(obj_uuid),
-                                 &resource_node->objs) {
-            if (uuid_equals(&n->obj_uuid, obj_uuid)) {
-                return;
-            }
+        if (object_node_find_resource(object_node, resource_node)
+            != SIZE_MAX) {
+            return;
         }
     }
 
     /* Create the resource node if we didn't have one already (for a
      * different object). */
     if (!resource_node) {
-        resource_node = xzalloc(sizeof *resource_node);
-        resource_node->node.hash = hash_string(res_name, type);
+        size_t name_len = strlen(res_name);
+
+        resource_node = xmalloc(sizeof *resource_node + name_len + 1);
         resource_node->type = type;
-        resource_node->res_name = xstrdup(res_name);
-        hmap_init(&resource_node->objs);
+        resource_node->objs = VECTOR_EMPTY_INITIALIZER(struct objdep_obj_ref);
+        memcpy(resource_node->res_name, res_name, name_len + 1);
         hmap_insert(&mgr->resource_to_objects_table,
                     &resource_node->node,
-                    resource_node->node.hash);
+                    hash_string(res_name, type));
     }
 
     /* Create the object node if we didn't have one already (for a
      * different resource). */
     if (!object_node) {
-        object_node = xzalloc(sizeof *object_node);
-        object_node->node.hash = uuid_hash(obj_uuid);
+        object_node = xmalloc(sizeof *object_node);
         object_node->obj_uuid = *obj_uuid;
-        ovs_list_init(&object_node->resources_head);
+        object_node->resources =
+            VECTOR_EMPTY_INITIALIZER(struct objdep_res_ref);
+        object_node->res_index = NULL;
+        object_node->res_index_mask = 0;
         hmap_insert(&mgr->object_to_resources_table,
                     &object_node->node,
-                    object_node->node.hash);
+                    uuid_hash(obj_uuid));
     }
 
-    struct object_to_resources_list_node *resource_list_node =
-        xzalloc(sizeof *resource_list_node);
-    resource_list_node->obj_uuid = *obj_uuid;
-    resource_list_node->ref_count = ref_count;
-    resource_list_node->resource_node = resource_node;
-    hmap_insert(&resource_node->objs, &resource_list_node->hmap_node,
-                uuid_hash(obj_uuid));
-    ovs_list_push_back(&object_node->resources_head,
-                       &resource_list_node->list_node);
+    struct objdep_obj_ref obj_ref = {
+        .obj_node = object_node,
+        .ref_count = ref_count,
+    };
+    struct objdep_res_ref res_ref = {
+        .resource_node = resource_node,
+        .index = vector_len(&resource_node->objs),
+    };
+    vector_push(&resource_node->objs, &obj_ref);
+    vector_push(&object_node->resources, &res_ref);
+    object_node_index_resources(object_node);
 }
 
 void
@@ -138,24 +142,32 @@ objdep_mgr_remove_obj(struct objdep_mgr *mgr, const struct uuid *obj_uuid)
 
     hmap_remove(&mgr->object_to_resources_table, &object_node->node);
 
-    struct object_to_resources_list_node *resource_list_node;
-    LIST_FOR_EACH_SAFE (resource_list_node, list_node,
-                        &object_node->resources_head) {
+    struct objdep_res_ref *res_ref;
+    VECTOR_FOR_EACH_PTR (&object_node->resources, res_ref) {
         struct resource_to_objects_node *resource_node =
-            resource_list_node->resource_node;
-        ovs_list_remove(&resource_list_node->list_node);
-        hmap_remove(&resource_node->objs, &resource_list_node->hmap_node);
+            res_ref->resource_node;
+
+        /* The last object of the resource takes the place of this one, so
+         * its own reference to the resource must be pointed there. */
+        vector_remove_fast(&resource_node->objs, res_ref->index, NULL);
+        if (res_ref->index < vector_len(&resource_node->objs)) {
+            struct objdep_obj_ref *moved =
+                vector_get_ptr(&resource_node->objs, res_ref->index);
+            size_t i = object_node_find_resource(moved->obj_node,
+                                                 resource_node);
+            struct objdep_res_ref *moved_res_ref =
+                vector_get_ptr(&moved->obj_node->resources, i);
+            moved_res_ref->index = res_ref->index;
+        }
 
         /* Clean up the node in ref_obj_table if the resource is not
          * referred by any logical flows. */
-        if (hmap_is_empty(&resource_node->objs)) {
+        if (vector_is_empty(&resource_node->objs)) {
             hmap_remove(&mgr->resource_to_objects_table, &resource_node->node);
-            resource_node_destroy(resource_list_node->resource_node);
+            resource_node_destroy(resource_node);
         }
-
-        free(resource_list_node);
     }
-    free(object_node);
+    object_node_destroy(object_node);
 }
 
 struct resource_to_objects_node *
@@ -215,14 +227,13 @@ objdep_mgr_handle_change(struct objdep_mgr *mgr,
     *changed = false;
 
     struct uuidset objs_todo = UUIDSET_INITIALIZER(&objs_todo);
-    struct object_to_resources_list_node *resource_list_node;
-    HMAP_FOR_EACH (resource_list_node, hmap_node, &resource_node->objs) {
-        if (uuidset_find(objs_processed, &resource_list_node->obj_uuid)) {
+    struct objdep_obj_ref *obj_ref;
+    RESOURCE_FOR_EACH_OBJ (obj_ref, resource_node) {
+        const struct uuid *obj_uuid = &obj_ref->obj_node->obj_uuid;
+        if (uuidset_find(objs_processed, obj_uuid)) {
             continue;
         }
-        /* Use object_to_resources_list_node as list node to store the uuid.
-         * Other fields are not used here. */
-        uuidset_insert(&objs_todo, &resource_list_node->obj_uuid);
+        uuidset_insert(&objs_todo, obj_uuid);
     }
     if (uuidset_is_empty(&objs_todo)) {
         return true;
@@ -242,16 +253,149 @@ objdep_type_name(enum objdep_type type)
         [OBJDEP_TYPE_PORTBINDING] = "Port_Binding",
         [OBJDEP_TYPE_MC_GROUP] = "Multicast_Group",
         [OBJDEP_TYPE_TEMPLATE] = "Template",
+        [OBJDEP_TYPE_CHASSIS] = "Chassis",
     };
 
     ovs_assert(type < OBJDEP_TYPE_MAX);
     return type_names[type];
 }
 
+/* Reports the number of resources, objects and references between them
+ * kept by 'mgr', and the memory they use, as counters prefixed by 'name'. */
+void
+objdep_mgr_get_memory_usage(const struct objdep_mgr *mgr, const char *name,
+                            struct simap *usage)
+{
+    uint64_t mem_usage = 0;
+    size_t n_refs = 0;
+
+    const struct resource_to_objects_node *resource_node;
+    HMAP_FOR_EACH (resource_node, node, &mgr->resource_to_objects_table) {
+        mem_usage += sizeof *resource_node + strlen(resource_node->res_name)
+                     + 1 + vector_capacity(&resource_node->objs)
+                           * sizeof(struct objdep_obj_ref);
+        n_refs += vector_len(&resource_node->objs);
+    }
+
+    const struct object_to_resources_node *object_node;
+    HMAP_FOR_EACH (object_node, node, &mgr->object_to_resources_table) {
+        mem_usage += sizeof *object_node
+                     + vector_capacity(&object_node->resources)
+                       * sizeof(struct objdep_res_ref);
+        if (object_node->res_index) {
+            mem_usage += (object_node->res_index_mask + 1)
+                         * sizeof *object_node->res_index;
+        }
+    }
+
+    mem_usage += (mgr->resource_to_objects_table.mask + 1
+                  + mgr->object_to_resources_table.mask + 1)
+                 * sizeof(struct hmap_node *);
+
+    char *counter_name = xasprintf("%s-resources", name);
+    simap_increase(usage, counter_name,
+                   hmap_count(&mgr->resource_to_objects_table));
+    free(counter_name);
+
+    counter_name = xasprintf("%s-objects", name);
+    simap_increase(usage, counter_name,
+                   hmap_count(&mgr->object_to_resources_table));
+    free(counter_name);
+
+    counter_name = xasprintf("%s-refs", name);
+    simap_increase(usage, counter_name, n_refs);
+    free(counter_name);
+
+    counter_name = xasprintf("%s-size-KB", name);
+    simap_increase(usage, counter_name, ROUND_UP(mem_usage, 1024) / 1024);
+    free(counter_name);
+}
+
 static void
 resource_node_destroy(struct resource_to_objects_node *resource_node)
 {
-    free(resource_node->res_name);
-    hmap_destroy(&resource_node->objs);
+    vector_destroy(&resource_node->objs);
     free(resource_node);
 }
+
+static void
+object_node_destroy(struct object_to_resources_node *object_node)
+{
+    vector_destroy(&object_node->resources);
+    free(object_node->res_index);
+    free(object_node);
+}
+
+/* Returns the index in 'object_node->resources' of the reference to
+ * 'resource_node', or SIZE_MAX if the object doesn't refer to it. */
+static size_t
+object_node_find_resource(const struct object_to_resources_node *object_node,
+                          const struct resource_to_objects_node *resource_node)
+{
+    const struct objdep_res_ref *res_refs =
+        vector_get_array(&object_node->resources);
+
+    if (!object_node->res_index) {
+        for (size_t i = 0; i < vector_len(&object_node->resources); i++) {
+            if (res_refs[i].resource_node == resource_node) {
+                return i;
+            }
+        }
+        return SIZE_MAX;
+    }
+
+    size_t mask = object_node->res_index_mask;
+    for (size_t slot = hash_pointer(resource_node, 0) & mask; ;
+         slot = (slot + 1) & mask) {
+        uint32_t i = object_node->res_index[slot];
+        if (!i) {
+            return SIZE_MAX;
+        }
+        if (res_refs[i - 1].resource_node == resource_node) {
+            return i - 1;
+        }
+    }
+}
+
+static void
+object_node_index_resource(struct object_to_resources_node *object_node,
+                           size_t i)
+{
+    const struct objdep_res_ref *res_ref =
+        vector_get_ptr(&object_node->resources, i);
+    size_t mask = object_node->res_index_mask;
+    size_t slot = hash_pointer(res_ref->resource_node, 0) & mask;
+
+    while (object_node->res_index[slot]) {
+        slot = (slot + 1) & mask;
+    }
+    object_node->res_index[slot] = i + 1;
+}
+
+/* Adds the last reference in 'object_node->resources' to the object's hash
+ * index, creating or growing the index as needed.  The index is an open
+ * addressing table of positions in 'resources' plus one (0 marks an empty
+ * slot), kept at most 3/4 full. */
+static void
+object_node_index_resources(struct object_to_resources_node *object_node)
+{
+    size_t n = vector_len(&object_node->resources);
+
+    if (object_node->res_index
+        && n * 4 <= (object_node->res_index_mask + 1) * 3) {
+        object_node_index_resource(object_node, n - 1);
+    } else if (n >= OBJDEP_RES_INDEX_MIN) {
+        size_t n_slots = OBJDEP_RES_INDEX_MIN;
+        while (n_slots < 2 * n) {
+            n_slots *= 2;
+        }
+
+        free(object_node->res_index);
+        object_node->res_index = xcalloc(n_slots,
+                                         sizeof *object_node->res_index);
+        object_node->res_index_mask = n_slots - 1;
+        for (size_t i = 0; i < n; i++) {
+            object_node_index_resource(object_node, i);
+        }
+    }
+}
@@ -18,8 +18,10 @@
 #define OVN_OBJDEP_H 1
 
 #include "lib/uuidset.h"
+#include "lib/vec.h"
 #include "openvswitch/hmap.h"
-#include "openvswitch/list.h"
+
+struct simap;
 
 enum objdep_type {
     OBJDEP_TYPE_ADDRSET,
@@ -27,6 +29,7 @@ enum objdep_type {
     OBJDEP_TYPE_PORTBINDING,
     OBJDEP_TYPE_MC_GROUP,
     OBJDEP_TYPE_TEMPLATE,
+    OBJDEP_TYPE_CHASSIS,
     OBJDEP_TYPE_MAX,
 };
 
@@ -42,15 +45,12 @@ typedef bool (*objdep_change_handler)(enum objdep_type,
 struct resource_to_objects_node {
     struct hmap_node node; /* node in objdep_mgr.resource_to_objects_table. */
     enum objdep_type type; /* key */
-    char *res_name;        /* key */
-    struct hmap objs;      /* Contains object_to_resources_list_node.
-                            * Use hmap instead of list so
-                            * that obj_resource_add() can check and avoid
-                            * and redundant entries in O(1). */
+    struct vector objs;    /* Contains struct objdep_obj_ref, unordered. */
+    char res_name[];       /* key */
 };
 
-#define RESOURCE_FOR_EACH_OBJ(NODE, MAP) \
-    HMAP_FOR_EACH (NODE, hmap_node, &(MAP)->objs)
+#define RESOURCE_FOR_EACH_OBJ(REF, MAP) \
+    VECTOR_FOR_EACH_PTR (&(MAP)->objs, REF)
 
 /* A node pointing to all resources used by a given object (specified by
  * uuid).
@@ -58,37 +58,42 @@ struct resource_to_objects_node {
 struct object_to_resources_node {
     struct hmap_node node; /* node in objdep_mgr.object_to_resources_table. */
     struct uuid obj_uuid;  /* key */
-    struct ovs_list resources_head; /* Contains elements of type
-                                     * object_to_resources_list_node. */
+    struct vector resources; /* Contains struct objdep_res_ref. */
+
+    /* Hash index over 'resources' by resource node, only maintained for
+     * objects that refer to many resources.  See objdep.c. */
+    uint32_t *res_index;
+    size_t res_index_mask;
 };
 
-/* Maintains the relationship for a pair of named resource and
- * an object, indexed by both resource_to_object_table and
- * object_to_resources_table. */
-struct object_to_resources_list_node {
-    /* node in object_to_resources_node.resources_head. */
-    struct ovs_list list_node;
-    struct hmap_node hmap_node; /* node in resource_to_objects_node.objs. */
-    struct uuid obj_uuid;
+/* The relationship between a named resource and an object is stored once on
+ * each side, as an element of the resource's 'objs' and of the object's
+ * 'resources'.  The object side also records where its peer is in the
+ * resource's 'objs', so that an object can be removed without searching the
+ * (possibly huge) list of objects of each resource it refers to. */
+struct objdep_obj_ref {
+    struct object_to_resources_node *obj_node;
     size_t ref_count; /* Reference count of the resource by this object.
                        * Currently only used for the resource type
                        * OBJDEP_TYPE_ADDRSET and for other types always
                        * set to 0. */
+};
+
+struct objdep_res_ref {
     struct resource_to_objects_node *resource_node;
+    size_t index;      /* Index of the peer in resource_node->objs. */
 };
 
 struct objdep_mgr {
     /* A map from a referenced resource type & name (e.g. address_set AS1)
      * to a list of object UUIDs (e.g., lflow) that are referencing the named
      * resource. Data type of each node in this hmap is struct
-     * resource_to_objects_node.  The objs in each node point
-     * to a map of object_to_resources_list_node.ref_list. */
+     * resource_to_objects_node. */
     struct hmap resource_to_objects_table;
 
     /* A map from a obj uuid to a list of named resources that are
      * referenced by the object. Data type of each node in this hmap is
-     * struct object_to_resources_node. The resources_head in each node
-     * points to a list of object_to_resources_list_node.obj_list. */
+     * struct object_to_resources_node. */
     struct hmap object_to_resources_table;
 };
 
@@ -119,5 +124,7 @@ bool objdep_mgr_handle_change(struct objdep_mgr *, enum objdep_type,
                               bool *changed);
 
 const char *objdep_type_name(enum objdep_type);
+void objdep_mgr_get_memory_usage(const struct objdep_mgr *, const char *name,
+                                 struct simap *usage);
 
 #endif /* lib/objdep.h */
@@ -18,6 +18,8 @@
 
 #include "tests/ovstest.h"
 #include "tests/test-utils.h"
+#include "random.h"
+#include "timeval.h"
 #include "util.h"
 #include "lib/uuid.h"
 
@@ -118,6 +120,88 @@ done:
     lflow_conj_ids_destroy(&conj_ids);
 }
 
+/* Allocates, looks up and frees conjunction ids for n_lflows logical flows
+ * with n_conjs ids each, first with random lflow uuids and then with every
+ * lflow hashing right into the ids allocated by the previous ones, which is
+ * the worst case for finding a free range. */
+static void
+test_conj_ids_benchmark(struct ovs_cmdl_context *ctx)
+{
+    unsigned int n_lflows, n_conjs;
+    if (!test_read_uint_value(ctx, 1, "n_lflows", &n_lflows)
+        || !test_read_uint_value(ctx, 2, "n_conjs", &n_conjs)) {
+        return;
+    }
+    if (!n_lflows || !n_conjs) {
+        ovs_fatal(0, "n_lflows and n_conjs must be positive");
+    }
+
+    struct uuid *uuids = xmalloc(n_lflows * sizeof *uuids);
+    struct uuid dp_uuid = UUID_ZERO;
+    struct conj_ids conj_ids;
+    lflow_conj_ids_init(&conj_ids);
+
+    random_set_seed(1);
+    for (unsigned int i = 0; i < n_lflows; i++) {
+        random_bytes(&uuids[i], sizeof uuids[i]);
+    }
+
+    lflow_conj_ids_set_test_mode(false);
+    long long int start = time_usec();
+    for (unsigned int i = 0; i < n_lflows; i++) {
+        lflow_conj_ids_alloc(&conj_ids, &uuids[i], &dp_uuid, n_conjs);
+    }
+    printf("alloc: %u lflows, %"PRIuSIZE" ids in %lld us\n",
+           n_lflows, conj_ids.n_conj_ids, time_usec() - start);
+
+    size_t n_found = 0;
+    start = time_usec();
+    for (unsigned int i = 0; i < n_lflows; i++) {
+        if (lflow_conj_ids_find(&conj_ids, &uuids[i], &dp_uuid)) {
+            n_found++;
+        }
+    }
+    printf("find: %u lflows, %"PRIuSIZE" found in %lld us\n",
+           n_lflows, n_found, time_usec() - start);
+
+    start = time_usec();
+    for (unsigned int i = 0; i < n_lflows; i++) {
+        lflow_conj_ids_free(&conj_ids, &uuids[i]);
+    }
+    printf("free: %u lflows, %"PRIuSIZE" ids left in %lld us\n",
+           n_lflows, conj_ids.n_conj_ids, time_usec() - start);
+
+    /* In test mode the first word of the lflow uuid is the preferred id, so
+     * lflow i (counting from 1) has to skip the ids of all the previous ones
+     * and ends up at (i - 1) * n_conjs + 1. */
+    lflow_conj_ids_set_test_mode(true);
+    for (unsigned int i = 0; i < n_lflows; i++) {
+        uuids[i] = UUID_ZERO;
+        uuids[i].parts[0] = i + 1;
+    }
+    size_t n_unexpected = 0;
+    start = time_usec();
+    for (unsigned int i = 0; i < n_lflows; i++) {
+        uint32_t conj_id = lflow_conj_ids_alloc(&conj_ids, &uuids[i],
+                                                &dp_uuid, n_conjs);
+        if (conj_id != i * n_conjs + 1) {
+            n_unexpected++;
+        }
+    }
+    printf("dense alloc: %u lflows, %"PRIuSIZE" unexpected in %lld us\n",
+           n_lflows, n_unexpected, time_usec() - start);
+
+    start = time_usec();
+    for (unsigned int i = 0; i < n_lflows; i++) {
+        lflow_conj_ids_free(&conj_ids, &uuids[i]);
+    }
+    printf("dense free: %u lflows, %"PRIuSIZE" ids left in %lld us\n",
+           n_lflows, conj_ids.n_conj_ids, time_usec() - start);
+
+    lflow_conj_ids_destroy(&conj_ids);
+    free(uuids);
+}
+
 static void
 test_lflow_conj_ids_main(int argc, char *argv[])
 {
@@ -125,6 +209,8 @@ test_lflow_conj_ids_main(int argc, char *argv[])
     static const struct ovs_cmdl_command commands[] = {
         {"operations", NULL, 1, INT_MAX,
          test_conj_ids_operations, OVS_RO},
+        {"benchmark", NULL, 2, 2,
+         test_conj_ids_benchmark, OVS_RO},
         {NULL, NULL, 0, 0, NULL, OVS_RO},
     };
     struct ovs_cmdl_context ctx;
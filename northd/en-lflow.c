@@ -128,7 +128,8 @@ en_lflow_run(struct engine_node *node, void *data)
     lflow_table_clear(lflow_data->lflow_table,
         search_mode == LFLOW_TABLE_SEARCH_FIELDS);
     lflow_reset_northd_refs(&lflow_input);
-    lflow_ref_clear(lflow_input.igmp_lflow_ref);
+    multicast_igmp_clear_lflow_refs(
+        engine_get_input_data("multicast_igmp", node));
 
     build_lflows(eng_ctx->ovnsb_idl_txn, &lflow_input,
                  lflow_data->lflow_table);
@@ -229,41 +230,94 @@ lflow_ls_stateful_handler(struct engine_node *node, void *data)
     return EN_HANDLED_UPDATED;
 }
 
+static bool
+lflow_igmp_ref_sync(struct lflow_ref *lflow_ref,
+                    struct lflow_data *lflow_data,
+                    const struct lflow_input *lflow_input)
+{
+    const struct engine_context *eng_ctx = engine_get_context();
+
+    return lflow_ref_sync_lflows(lflow_ref, lflow_data->lflow_table,
+                                 eng_ctx->ovnsb_idl_txn, lflow_input->dps,
+                                 lflow_input->ovn_internal_version_changed,
+                                 lflow_input->sbrec_logical_flow_table,
+                                 lflow_input->sbrec_logical_dp_group_table);
+}
+
 enum engine_input_handler_result
 lflow_multicast_igmp_handler(struct engine_node *node, void *data)
 {
     struct multicast_igmp_data *mcast_igmp_data =
         engine_get_input_data("multicast_igmp", node);
+    struct vector *stale_lflow_refs = &mcast_igmp_data->stale_lflow_refs;
 
-    const struct engine_context *eng_ctx = engine_get_context();
     struct lflow_data *lflow_data = data;
     struct lflow_input lflow_input;
     lflow_get_input_data(node, &lflow_input);
 
-    if (!lflow_ref_resync_flows(mcast_igmp_data->lflow_ref,
-                                lflow_data->lflow_table,
-                                eng_ctx->ovnsb_idl_txn,
-                                lflow_input.dps,
-                                lflow_input.ovn_internal_version_changed,
-                                lflow_input.sbrec_logical_flow_table,
-                                lflow_input.sbrec_logical_dp_group_table)) {
-        return EN_UNHANDLED;
+    /* Unlink the flows of destroyed IGMP groups but only sync them after
+     * the new flows are built, so that flows which are still needed by the
+     * rebuilt groups are not removed from the SB and added back. */
+    struct lflow_ref *lflow_ref;
+    VECTOR_FOR_EACH (stale_lflow_refs, lflow_ref) {
+        lflow_ref_unlink_lflows(lflow_ref);
+    }
+
+    struct ovn_igmp_group *igmp_group;
+    struct hmapx_node *hmapx_node;
+
+    if (mcast_igmp_data->tracked) {
+        HMAPX_FOR_EACH (hmapx_node,
+                        &mcast_igmp_data->trk_data.crupdated_groups) {
+            igmp_group = hmapx_node->data;
+            lflow_ref_unlink_lflows(igmp_group->lflow_ref);
+            build_igmp_group_lflows(igmp_group, lflow_data->lflow_table);
+        }
+    } else {
+        /* The multicast_igmp node was recomputed, rebuild all IGMP flows. */
+        lflow_ref_unlink_lflows(mcast_igmp_data->lflow_ref);
+        HMAP_FOR_EACH (igmp_group, hmap_node,
+                       &mcast_igmp_data->igmp_groups) {
+            lflow_ref_unlink_lflows(igmp_group->lflow_ref);
+        }
+        build_igmp_lflows(&mcast_igmp_data->igmp_groups,
+                          &lflow_input.ls_datapaths->datapaths,
+                          lflow_data->lflow_table,
+                          mcast_igmp_data->lflow_ref);
+    }
+
+    while (!vector_is_empty(stale_lflow_refs)) {
+        vector_pop(stale_lflow_refs, &lflow_ref);
+        bool handled = lflow_igmp_ref_sync(lflow_ref, lflow_data,
+                                           &lflow_input);
+        lflow_ref_destroy(lflow_ref);
+        if (!handled) {
+            return EN_UNHANDLED;
+        }
     }
 
-    build_igmp_lflows(&mcast_igmp_data->igmp_groups,
-                      &lflow_input.ls_datapaths->datapaths,
-                      lflow_data->lflow_table,
-                      mcast_igmp_data->lflow_ref);
-
-    if (!lflow_ref_sync_lflows(mcast_igmp_data->lflow_ref,
-                               lflow_data->lflow_table,
-                               eng_ctx->ovnsb_idl_txn,
-                               lflow_input.dps,
-                               lflow_input.ovn_internal_version_changed,
-                               lflow_input.sbrec_logical_flow_table,
-                               lflow_input.sbrec_logical_dp_group_table)) {
+    if (mcast_igmp_data->tracked) {
+        HMAPX_FOR_EACH (hmapx_node,
+                        &mcast_igmp_data->trk_data.crupdated_groups) {
+            igmp_group = hmapx_node->data;
+            if (!lflow_igmp_ref_sync(igmp_group->lflow_ref, lflow_data,
+                                     &lflow_input)) {
+                return EN_UNHANDLED;
+            }
+        }
+        return EN_HANDLED_UPDATED;
+    }
+
+    if (!lflow_igmp_ref_sync(mcast_igmp_data->lflow_ref, lflow_data,
+                             &lflow_input)) {
         return EN_UNHANDLED;
     }
+    HMAP_FOR_EACH (igmp_group, hmap_node, &mcast_igmp_data->igmp_groups) {
+        if (!lflow_igmp_ref_sync(igmp_group->lflow_ref, lflow_data,
+                                 &lflow_input)) {
+            return EN_UNHANDLED;
+        }
+    }
 
     return EN_HANDLED_UPDATED;
 }
@@ -98,9 +98,23 @@ static void ovn_igmp_mrouter_aggregate_ports(struct ovn_igmp_group *,
                                              struct hmap *mcast_groups);
 static void ovn_igmp_group_aggregate_ports(struct ovn_igmp_group *,
                                            struct hmap *mcast_groups);
-static void ovn_igmp_group_destroy(struct hmap *igmp_groups,
+static void ovn_igmp_group_destroy(struct multicast_igmp_data *,
                                    struct ovn_igmp_group *);
-static void ovn_igmp_groups_destroy(struct hmap *igmp_groups);
+static void ovn_igmp_groups_destroy(struct multicast_igmp_data *);
+static bool ovn_igmp_group_is_relayed(const struct ovn_datapath *,
+                                      const struct in6_addr *);
+static void ovn_igmp_group_remove(
+    struct multicast_igmp_data *, struct ovn_igmp_group *,
+    struct ovsdb_idl_index *sbrec_mcast_group_by_name_dp);
+static bool ovn_igmp_group_rebuild(
+    struct multicast_igmp_data *, struct ovsdb_idl_txn *,
+    struct ovsdb_idl_index *sbrec_igmp_group_by_addr_dp,
+    struct ovsdb_idl_index *sbrec_mcast_group_by_name_dp,
+    struct ovn_datapath *, const struct in6_addr *, const char *address_s,
+    const struct hmap *ls_ports);
+static void ovn_multicast_sync_to_sb(
+    const struct ovn_multicast *, struct ovsdb_idl_txn *,
+    struct ovsdb_idl_index *sbrec_mcast_group_by_name_dp);
 
 void *
 en_multicast_igmp_init(struct engine_node *node OVS_UNUSED,
@@ -110,6 +124,9 @@ en_multicast_igmp_init(struct engine_node *node OVS_UNUSED,
     hmap_init(&data->mcast_groups);
     hmap_init(&data->igmp_groups);
     data->lflow_ref = lflow_ref_create();
+    data->stale_lflow_refs = VECTOR_EMPTY_INITIALIZER(struct lflow_ref *);
+    data->tracked = false;
+    hmapx_init(&data->trk_data.crupdated_groups);
 
     return data;
 }
@@ -129,8 +146,10 @@ en_multicast_igmp_run(struct engine_node *node, void *data_)
             "sbrec_mcast_group_by_name");
     const struct engine_context *eng_ctx = engine_get_context();
 
+    data->tracked = false;
+    hmapx_clear(&data->trk_data.crupdated_groups);
     ovn_multicast_groups_destroy(&data->mcast_groups);
-    ovn_igmp_groups_destroy(&data->igmp_groups);
+    ovn_igmp_groups_destroy(data);
 
     build_mcast_groups(data, sbrec_igmp_group_table,
                       sbrec_mcast_group_by_name_dp,
@@ -178,16 +197,205 @@ multicast_igmp_northd_handler(struct engine_node *node, void *data OVS_UNUSED)
     return EN_HANDLED_UNCHANGED;
 }
 
+/* A key identifying an IGMP group touched by SB IGMP_Group changes. */
+struct igmp_group_key {
+    struct hmap_node hmap_node;
+    struct ovn_datapath *datapath;
+    struct in6_addr address;
+    char address_s[INET6_ADDRSTRLEN];
+};
+
+/* Adds the IGMP group 'sb_igmp' belongs to, to 'keys'.  Returns false if
+ * the change can't be handled incrementally. */
+static bool
+igmp_group_key_add(struct hmap *keys, const struct sbrec_igmp_group *sb_igmp,
+                   const struct hmap *ls_datapaths)
+{
+    bool deleted = sbrec_igmp_group_is_deleted(sb_igmp);
+
+    /* ovn-controller never moves records between groups, don't try to
+     * figure out which group an updated record used to belong to. */
+    if (!deleted && !sbrec_igmp_group_is_new(sb_igmp) &&
+        (sbrec_igmp_group_is_updated(sb_igmp, SBREC_IGMP_GROUP_COL_ADDRESS)
+         || sbrec_igmp_group_is_updated(sb_igmp,
+                                        SBREC_IGMP_GROUP_COL_DATAPATH)
+         || sbrec_igmp_group_is_updated(sb_igmp,
+                                        SBREC_IGMP_GROUP_COL_CHASSIS))) {
+        return false;
+    }
+
+    /* Stale records are purged by the full recompute. */
+    if (!sb_igmp->datapath || (!deleted && !sb_igmp->chassis)) {
+        return false;
+    }
+
+    struct ovn_datapath *od =
+        ovn_datapath_from_sbrec_(ls_datapaths, sb_igmp->datapath);
+    if (!od || ovn_datapath_is_stale(od)) {
+        return deleted;
+    }
+
+    /* Mrouter records are aggregated together with the ports configured to
+     * flood reports. */
+    if (!strcmp(sb_igmp->address, OVN_IGMP_GROUP_MROUTERS)) {
+        return false;
+    }
+
+    /* Invalid addresses are ignored by the full recompute too. */
+    struct in6_addr address;
+    if (!ip46_parse(sb_igmp->address, &address)) {
+        return true;
+    }
+
+    /* The records of a group are looked up by their address string, only
+     * handle the canonical format written by ovn-controller. */
+    char address_s[INET6_ADDRSTRLEN];
+    if (!ipv6_string_mapped(address_s, &address)
+        || strcmp(address_s, sb_igmp->address)) {
+        return false;
+    }
+
+    /* Groups learnt by the switch also create groups on the routers with
+     * relay enabled. */
+    if (ovn_igmp_group_is_relayed(od, &address)) {
+        return false;
+    }
+
+    uint32_t hash = ovn_igmp_group_hash(od, &address);
+    struct igmp_group_key *key;
+    HMAP_FOR_EACH_WITH_HASH (key, hmap_node, hash, keys) {
+        if (key->datapath == od && ipv6_addr_equals(&key->address, &address)) {
+            return true;
+        }
+    }
+
+    key = xmalloc(sizeof *key);
+    key->datapath = od;
+    key->address = address;
+    ovs_strlcpy(key->address_s, address_s, sizeof key->address_s);
+    hmap_insert(keys, &key->hmap_node, hash);
+    return true;
+}
+
+/* Returns true if switch 'od' can take 'n_new' more IGMP groups without
+ * reaching its multicast table size.  Below that limit the logical flows of
+ * a group don't depend on the other groups of the switch. */
+static bool
+ovn_igmp_groups_below_limit(const struct hmap *igmp_groups,
+                            const struct ovn_datapath *od, size_t n_new)
+{
+    const struct ovn_igmp_group *igmp_group;
+    int64_t n_groups = n_new;
+
+    HMAP_FOR_EACH (igmp_group, hmap_node, igmp_groups) {
+        if (igmp_group->datapath == od) {
+            n_groups++;
+        }
+    }
+    return n_groups < od->mcast_info.sw.table_size;
+}
+
+/* Handles SB IGMP_Group changes by rebuilding only the IGMP groups (and
+ * their multicast groups) the changed records belong to.  Anything that
+ * has an effect beyond a single group falls back to a full recompute. */
+enum engine_input_handler_result
+multicast_igmp_sb_igmp_group_handler(struct engine_node *node, void *data_)
+{
+    struct multicast_igmp_data *data = data_;
+    struct northd_data *northd_data = engine_get_input_data("northd", node);
+    const struct sbrec_igmp_group_table *sbrec_igmp_group_table =
+        EN_OVSDB_GET(engine_get_input("SB_igmp_group", node));
+    struct ovsdb_idl_index *sbrec_igmp_group_by_addr_dp =
+        engine_ovsdb_node_get_index(
+            engine_get_input("SB_igmp_group", node),
+            "sbrec_igmp_group_by_addr_dp");
+    struct ovsdb_idl_index *sbrec_mcast_group_by_name_dp =
+        engine_ovsdb_node_get_index(
+            engine_get_input("SB_multicast_group", node),
+            "sbrec_mcast_group_by_name");
+    const struct engine_context *eng_ctx = engine_get_context();
+    enum engine_input_handler_result ret = EN_UNHANDLED;
+
+    struct hmap keys = HMAP_INITIALIZER(&keys);
+    const struct sbrec_igmp_group *sb_igmp;
+    struct igmp_group_key *key;
+
+    SBREC_IGMP_GROUP_TABLE_FOR_EACH_TRACKED (sb_igmp,
+                                             sbrec_igmp_group_table) {
+        if (!igmp_group_key_add(&keys, sb_igmp,
+                                &northd_data->ls_datapaths.datapaths)) {
+            goto out;
+        }
+    }
+
+    HMAP_FOR_EACH (key, hmap_node, &keys) {
+        if (!ovn_igmp_groups_below_limit(&data->igmp_groups, key->datapath,
+                                         hmap_count(&keys))) {
+            goto out;
+        }
+    }
+
+    bool changed = false;
+    HMAP_FOR_EACH (key, hmap_node, &keys) {
+        changed |= ovn_igmp_group_rebuild(data, eng_ctx->ovnsb_idl_txn,
+                                          sbrec_igmp_group_by_addr_dp,
+                                          sbrec_mcast_group_by_name_dp,
+                                          key->datapath, &key->address,
+                                          key->address_s,
+                                          &northd_data->ls_ports);
+    }
+
+    data->tracked = true;
+    ret = changed ? EN_HANDLED_UPDATED : EN_HANDLED_UNCHANGED;
+
+out:
+    HMAP_FOR_EACH_POP (key, hmap_node, &keys) {
+        free(key);
+    }
+    hmap_destroy(&keys);
+    return ret;
+}
+
+void
+en_multicast_igmp_clear_tracked_data(void *data_)
+{
+    struct multicast_igmp_data *data = data_;
+
+    data->tracked = false;
+    hmapx_clear(&data->trk_data.crupdated_groups);
+}
+
+/* Forgets all the logical flows referenced by the IGMP groups, to be used
+ * when the lflow table is rebuilt from scratch. */
+void
+multicast_igmp_clear_lflow_refs(struct multicast_igmp_data *data)
+{
+    struct ovn_igmp_group *igmp_group;
+    struct lflow_ref *lflow_ref;
+
+    lflow_ref_clear(data->lflow_ref);
+    HMAP_FOR_EACH (igmp_group, hmap_node, &data->igmp_groups) {
+        lflow_ref_clear(igmp_group->lflow_ref);
+    }
+    VECTOR_FOR_EACH (&data->stale_lflow_refs, lflow_ref) {
+        lflow_ref_destroy(lflow_ref);
+    }
+    vector_clear(&data->stale_lflow_refs);
+}
+
 void
 en_multicast_igmp_cleanup(void *data_)
 {
     struct multicast_igmp_data *data = data_;
 
     ovn_multicast_groups_destroy(&data->mcast_groups);
-    ovn_igmp_groups_destroy(&data->igmp_groups);
+    ovn_igmp_groups_destroy(data);
+    multicast_igmp_clear_lflow_refs(data);
     hmap_destroy(&data->mcast_groups);
     hmap_destroy(&data->igmp_groups);
     lflow_ref_destroy(data->lflow_ref);
+    vector_destroy(&data->stale_lflow_refs);
+    hmapx_destroy(&data->trk_data.crupdated_groups);
 }
 
 struct sbrec_multicast_group *
@@ -377,13 +585,13 @@ build_mcast_groups(struct multicast_igmp_data *data,
          * no more processing needed. */
         if (!strcmp(igmp_group->mcgroup.name, OVN_IGMP_GROUP_MROUTERS)) {
             ovn_igmp_mrouter_aggregate_ports(igmp_group, &data->mcast_groups);
-            ovn_igmp_group_destroy(&data->igmp_groups, igmp_group);
+            ovn_igmp_group_destroy(data, igmp_group);
             continue;
         }
 
         if (!ovn_igmp_group_allocate_id(igmp_group)) {
             /* If we ran out of keys just destroy the entry. */
-            ovn_igmp_group_destroy(&data->igmp_groups, igmp_group);
+            ovn_igmp_group_destroy(data, igmp_group);
             continue;
         }
 
@@ -532,6 +740,26 @@ ovn_multicast_update_sbrec(const struct ovn_multicast *mc,
     vector_destroy(&sb_ports);
 }
 
+static void
+ovn_multicast_sync_to_sb(const struct ovn_multicast *mc,
+                         struct ovsdb_idl_txn *ovnsb_txn,
+                         struct ovsdb_idl_index *sbrec_mcast_group_by_name_dp)
+{
+    const struct sbrec_multicast_group *sbmc =
+        mcast_group_lookup(sbrec_mcast_group_by_name_dp, mc->group->name,
+                           mc->datapath->sdp->sb_dp);
+
+    if (sbmc && sbmc->tunnel_key != mc->group->key) {
+        sbrec_multicast_group_delete(sbmc);
+        sbmc = NULL;
+    }
+    if (!sbmc) {
+        sbmc = create_sb_multicast_group(ovnsb_txn, mc->datapath->sdp->sb_dp,
+                                         mc->group->name, mc->group->key);
+    }
+    ovn_multicast_update_sbrec(mc, sbmc);
+}
+
 static void
 ovn_multicast_groups_destroy(struct hmap *mcast_groups)
 {
@@ -595,6 +823,7 @@ ovn_igmp_group_add(struct ovsdb_idl_index *sbrec_mcast_group_by_name_dp,
         }
         igmp_group->mcgroup.name = address_s;
         ovs_list_init(&igmp_group->entries);
+        igmp_group->lflow_ref = lflow_ref_create();
 
         hmap_insert(igmp_groups, &igmp_group->hmap_node,
                     ovn_igmp_group_hash(datapath, address));
@@ -719,7 +948,7 @@ ovn_igmp_group_aggregate_ports(struct ovn_igmp_group *igmp_group,
 }
 
 static void
-ovn_igmp_group_destroy(struct hmap *igmp_groups,
+ovn_igmp_group_destroy(struct multicast_igmp_data *data,
                        struct ovn_igmp_group *igmp_group)
 {
     if (igmp_group) {
@@ -729,16 +958,140 @@ ovn_igmp_group_destroy(struct hmap *igmp_groups,
             ovn_igmp_group_destroy_entry(entry);
             free(entry);
         }
-        hmap_remove(igmp_groups, &igmp_group->hmap_node);
+        /* The lflow engine node still has to remove the group's flows. */
+        vector_push(&data->stale_lflow_refs, &igmp_group->lflow_ref);
+        hmap_remove(&data->igmp_groups, &igmp_group->hmap_node);
         free(igmp_group);
     }
 }
 
 static void
-ovn_igmp_groups_destroy(struct hmap *igmp_groups)
+ovn_igmp_groups_destroy(struct multicast_igmp_data *data)
 {
     struct ovn_igmp_group *igmp_group;
-    HMAP_FOR_EACH_SAFE (igmp_group, hmap_node, igmp_groups) {
-        ovn_igmp_group_destroy(igmp_groups, igmp_group);
+    HMAP_FOR_EACH_SAFE (igmp_group, hmap_node, &data->igmp_groups) {
+        ovn_igmp_group_destroy(data, igmp_group);
     }
 }
+
+/* Returns true if groups learnt for 'address' on switch 'od' are also
+ * relayed by a multicast router connected to it. */
+static bool
+ovn_igmp_group_is_relayed(const struct ovn_datapath *od,
+                          const struct in6_addr *address)
+{
+    /* For IPv6 only relay routable multicast groups (RFC 4291 2.7). */
+    if (!IN6_IS_ADDR_V4MAPPED(address) &&
+        !ipv6_addr_is_routable_multicast(address)) {
+        return false;
+    }
+
+    struct ovn_port *op;
+    VECTOR_FOR_EACH (&od->router_ports, op) {
+        struct ovn_port *router_port = op->peer;
+
+        if (router_port && router_port->od &&
+            router_port->od->mcast_info.rtr.relay &&
+            !router_port->mcast_info.flood) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Destroys 'igmp_group' along with its SB Multicast_Group and releases its
+ * tunnel key. */
+static void
+ovn_igmp_group_remove(struct multicast_igmp_data *data,
+                      struct ovn_igmp_group *igmp_group,
+                      struct ovsdb_idl_index *sbrec_mcast_group_by_name_dp)
+{
+    struct ovn_datapath *od = igmp_group->datapath;
+
+    if (igmp_group->mcgroup.key) {
+        const struct sbrec_multicast_group *sbmc =
+            mcast_group_lookup(sbrec_mcast_group_by_name_dp,
+                               igmp_group->mcgroup.name, od->sdp->sb_dp);
+        if (sbmc && sbmc->tunnel_key == igmp_group->mcgroup.key) {
+            sbrec_multicast_group_delete(sbmc);
+        }
+        ovn_free_tnlid(&od->mcast_info.group_tnlids, igmp_group->mcgroup.key);
+    }
+    hmapx_find_and_delete(&data->trk_data.crupdated_groups, igmp_group);
+    ovn_igmp_group_destroy(data, igmp_group);
+}
+
+/* Rebuilds the IGMP group for 'address' on switch 'od' from its current SB
+ * IGMP_Group records and syncs the corresponding Multicast_Group to the SB.
+ * Returns true if the group existed before or exists now. */
+static bool
+ovn_igmp_group_rebuild(struct multicast_igmp_data *data,
+                       struct ovsdb_idl_txn *ovnsb_txn,
+                       struct ovsdb_idl_index *sbrec_igmp_group_by_addr_dp,
+                       struct ovsdb_idl_index *sbrec_mcast_group_by_name_dp,
+                       struct ovn_datapath *od,
+                       const struct in6_addr *address,
+                       const char *address_s,
+                       const struct hmap *ls_ports)
+{
+    struct ovn_igmp_group *igmp_group =
+        ovn_igmp_group_find(&data->igmp_groups, od, address);
+
+    /* The ports of all the entries are aggregated in the multicast group,
+     * start over from scratch. */
+    if (igmp_group) {
+        ovn_multicast_destroy(&data->mcast_groups,
+                              ovn_multicast_find(&data->mcast_groups, od,
+                                                 &igmp_group->mcgroup));
+    }
+
+    struct sbrec_igmp_group *target =
+        sbrec_igmp_group_index_init_row(sbrec_igmp_group_by_addr_dp);
+    sbrec_igmp_group_index_set_address(target, address_s);
+    sbrec_igmp_group_index_set_datapath(target, od->sdp->sb_dp);
+
+    const struct sbrec_igmp_group *sb_igmp;
+    const char *name = NULL;
+
+    SBREC_IGMP_GROUP_FOR_EACH_EQUAL (sb_igmp, target,
+                                     sbrec_igmp_group_by_addr_dp) {
+        /* Stale records are purged by the next full recompute. */
+        if (!sb_igmp->chassis) {
+            continue;
+        }
+
+        size_t n_igmp_ports;
+        struct ovn_port **igmp_ports =
+            ovn_igmp_group_get_ports(sb_igmp, &n_igmp_ports, ls_ports);
+        if (!igmp_ports) {
+            continue;
+        }
+
+        if (!igmp_group) {
+            igmp_group = ovn_igmp_group_add(sbrec_mcast_group_by_name_dp,
+                                            &data->igmp_groups, od, address,
+                                            sb_igmp->address);
+        }
+        ovn_igmp_group_add_entry(igmp_group, igmp_ports, n_igmp_ports);
+        name = sb_igmp->address;
+    }
+    sbrec_igmp_group_index_destroy_row(target);
+
+    if (!igmp_group) {
+        return false;
+    }
+
+    if (!name || !ovn_igmp_group_allocate_id(igmp_group)) {
+        ovn_igmp_group_remove(data, igmp_group, sbrec_mcast_group_by_name_dp);
+        return true;
+    }
+
+    /* The record the group name was taken from might be gone. */
+    igmp_group->mcgroup.name = name;
+    ovn_igmp_group_aggregate_ports(igmp_group, &data->mcast_groups);
+    ovn_multicast_sync_to_sb(ovn_multicast_find(&data->mcast_groups, od,
+                                                &igmp_group->mcgroup),
+                             ovnsb_txn, sbrec_mcast_group_by_name_dp);
+    hmapx_add(&data->trk_data.crupdated_groups, igmp_group);
+    return true;
+}
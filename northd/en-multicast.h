@@ -67,12 +67,28 @@ struct ovn_igmp_group {
     struct multicast_group mcgroup;
 
     struct ovs_list entries; /* List of SB entries for this group. */
+
+    struct lflow_ref *lflow_ref; /* Logical flows generated for the group. */
+};
+
+struct multicast_igmp_tracked_data {
+    /* 'ovn_igmp_group' records created or updated by the last incremental
+     * run.  Only valid if 'data->tracked' is true. */
+    struct hmapx crupdated_groups;
 };
 
 struct multicast_igmp_data {
     struct hmap mcast_groups;
     struct hmap igmp_groups;
     struct lflow_ref *lflow_ref;
+
+    /* Logical flow references of destroyed IGMP groups.  The flows they
+     * still point to are removed by the lflow engine node, which then
+     * destroys the references. */
+    struct vector stale_lflow_refs; /* Vector of struct lflow_ref *. */
+
+    bool tracked;
+    struct multicast_igmp_tracked_data trk_data;
 };
 
 struct ovn_mcast_sw_stats {
@@ -86,7 +102,11 @@ void *en_multicast_igmp_init(struct engine_node *,struct engine_arg *);
 enum engine_node_state en_multicast_igmp_run(struct engine_node *, void *);
 enum engine_input_handler_result
 multicast_igmp_northd_handler(struct engine_node *, void *);
+enum engine_input_handler_result
+multicast_igmp_sb_igmp_group_handler(struct engine_node *, void *);
 void en_multicast_igmp_cleanup(void *);
+void en_multicast_igmp_clear_tracked_data(void *);
+void multicast_igmp_clear_lflow_refs(struct multicast_igmp_data *);
 struct sbrec_multicast_group *create_sb_multicast_group(
     struct ovsdb_idl_txn *ovnsb_txn, const struct sbrec_datapath_binding *,
     const char *name, int64_t tunnel_key);
@@ -159,7 +159,7 @@ enum sb_engine_node {
 static ENGINE_NODE(northd, CLEAR_TRACKED_DATA, SB_WRITE);
 static ENGINE_NODE(sync_from_sb, SB_WRITE);
 static ENGINE_NODE(sampling_app);
-static ENGINE_NODE(lflow, SB_WRITE);
+static ENGINE_NODE(lflow, SB_WRITE, RESUMABLE);
 static ENGINE_NODE(mac_binding_aging, SB_WRITE);
 static ENGINE_NODE(mac_binding_aging_waker);
 static ENGINE_NODE(northd_output);
@@ -172,16 +172,16 @@ static ENGINE_NODE(fdb_aging_waker);
 static ENGINE_NODE(sync_to_sb_lb, SB_WRITE);
 static ENGINE_NODE(sync_to_sb_pb, SB_WRITE);
 static ENGINE_NODE(global_config, CLEAR_TRACKED_DATA, SB_WRITE);
-static ENGINE_NODE(lb_data, CLEAR_TRACKED_DATA);
-static ENGINE_NODE(lr_nat, CLEAR_TRACKED_DATA);
-static ENGINE_NODE(lr_stateful, CLEAR_TRACKED_DATA);
-static ENGINE_NODE(ls_stateful, CLEAR_TRACKED_DATA);
+static ENGINE_NODE(lb_data, CLEAR_TRACKED_DATA, THREAD_SAFE);
+static ENGINE_NODE(lr_nat, CLEAR_TRACKED_DATA, THREAD_SAFE);
+static ENGINE_NODE(lr_stateful, CLEAR_TRACKED_DATA, THREAD_SAFE);
+static ENGINE_NODE(ls_stateful, CLEAR_TRACKED_DATA, THREAD_SAFE);
 static ENGINE_NODE(route_policies);
 static ENGINE_NODE(routes);
 static ENGINE_NODE(bfd);
 static ENGINE_NODE(bfd_sync, SB_WRITE);
 static ENGINE_NODE(ecmp_nexthop, SB_WRITE);
-static ENGINE_NODE(multicast_igmp, SB_WRITE);
+static ENGINE_NODE(multicast_igmp, CLEAR_TRACKED_DATA, SB_WRITE);
 static ENGINE_NODE(acl_id, SB_WRITE);
 static ENGINE_NODE(advertised_route_sync, SB_WRITE);
 static ENGINE_NODE(advertised_mac_binding_sync, SB_WRITE);
@@ -386,7 +386,8 @@ void inc_proc_northd_init(struct ovsdb_idl_loop *nb,
     engine_add_input(&en_multicast_igmp, &en_northd,
                      multicast_igmp_northd_handler);
     engine_add_input(&en_multicast_igmp, &en_sb_multicast_group, NULL);
-    engine_add_input(&en_multicast_igmp, &en_sb_igmp_group, NULL);
+    engine_add_input(&en_multicast_igmp, &en_sb_igmp_group,
+                     multicast_igmp_sb_igmp_group_handler);
 
     engine_add_input(&en_lflow, &en_sync_meters, NULL);
     engine_add_input(&en_lflow, &en_sb_logical_flow, NULL);
@@ -565,6 +566,13 @@ void inc_proc_northd_init(struct ovsdb_idl_loop *nb,
                                 "sbrec_fdb_by_dp_and_port",
                                 sbrec_fdb_by_dp_and_port);
 
+    struct ovsdb_idl_index *sbrec_igmp_group_by_addr_dp
+        = ovsdb_idl_index_create2(sb->idl, &sbrec_igmp_group_col_address,
+                                  &sbrec_igmp_group_col_datapath);
+    engine_ovsdb_node_add_index(&en_sb_igmp_group,
+                                "sbrec_igmp_group_by_addr_dp",
+                                sbrec_igmp_group_by_addr_dp);
+
     struct ovsdb_idl_index *sbrec_port_binding_by_name
         = ovsdb_idl_index_create1(sb->idl,
                                   &sbrec_port_binding_col_logical_port);
@@ -631,8 +639,8 @@ bool inc_proc_northd_run(struct ovsdb_idl_txn *ovnnb_txn,
             VLOG_DBG("engine did not run, and it was not needed");
         }
     } else if (engine_canceled()) {
-        VLOG_DBG("engine was canceled, force recompute next time.");
-        engine_set_force_recompute_immediate();
+        VLOG_DBG("engine was canceled, resume next time.");
+        engine_set_resume_immediate();
     } else {
         engine_clear_force_recompute();
     }
@@ -654,7 +662,8 @@ void inc_proc_northd_cleanup(void)
 bool
 inc_proc_northd_can_run(struct northd_engine_context *ctx)
 {
-    if (engine_get_force_recompute() || time_msec() >= ctx->next_run_ms ||
+    if (engine_get_force_recompute() || engine_need_resume() ||
+        time_msec() >= ctx->next_run_ms ||
         ctx->nb_idl_duration_ms >= IDL_LOOP_MAX_DURATION_MS ||
         ctx->sb_idl_duration_ms >= IDL_LOOP_MAX_DURATION_MS) {
         return true;
@@ -39,4 +39,10 @@ inc_proc_northd_get_force_recompute(void)
     return engine_get_force_recompute();
 }
 
+static inline bool
+inc_proc_northd_need_resume(void)
+{
+    return engine_need_resume();
+}
+
 #endif /* INC_PROC_NORTHD */
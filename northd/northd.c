@@ -20078,8 +20078,9 @@ build_lswitch_and_lrouter_flows(
     free(svc_check_match);
 }
 
-/* The IGMP flows have to be built in main thread because there is
- * single lflow_ref for all of them which isn't thread safe.
+/* The IGMP flows have to be built in main thread because the lflow_refs
+ * they use aren't thread safe.  'lflow_ref' is used for the per switch
+ * flood flows, each IGMP group tracks its own flows.
  * This shouldn't affect performance as there is a limited how many
  * IGMP groups can be created. */
 void
@@ -20104,10 +20105,11 @@ build_igmp_lflows(struct hmap *igmp_groups, const struct hmap *ls_datapaths,
             struct shash_node *node =
                 shash_find(&ls_stats, igmp_group->datapath->nbs->name);
             build_lswitch_ip_mcast_igmp_mld(igmp_group, lflows, node->data,
-                                            &actions, &match, lflow_ref);
+                                            &actions, &match,
+                                            igmp_group->lflow_ref);
         } else {
             build_lrouter_ip_mcast_igmp_mld(igmp_group, lflows, &actions,
-                                            &match, lflow_ref);
+                                            &match, igmp_group->lflow_ref);
         }
     }
     stopwatch_stop(LFLOWS_IGMP_STOPWATCH_NAME, time_msec());
@@ -20117,6 +20119,30 @@ build_igmp_lflows(struct hmap *igmp_groups, const struct hmap *ls_datapaths,
     ds_destroy(&match);
 }
 
+/* Builds the flows of a single IGMP group.  The caller must make sure the
+ * group's switch hasn't reached its multicast table size, as the flows
+ * that don't fit anymore depend on the order in which groups are built. */
+void
+build_igmp_group_lflows(struct ovn_igmp_group *igmp_group,
+                        struct lflow_table *lflows)
+{
+    struct ovn_mcast_sw_stats stats = { 0 };
+    struct ds actions = DS_EMPTY_INITIALIZER;
+    struct ds match = DS_EMPTY_INITIALIZER;
+
+    if (igmp_group->datapath->nbs) {
+        build_lswitch_ip_mcast_igmp_mld(igmp_group, lflows, &stats,
+                                        &actions, &match,
+                                        igmp_group->lflow_ref);
+    } else {
+        build_lrouter_ip_mcast_igmp_mld(igmp_group, lflows, &actions,
+                                        &match, igmp_group->lflow_ref);
+    }
+
+    ds_destroy(&actions);
+    ds_destroy(&match);
+}
+
 void run_update_worker_pool(int n_threads)
 {
     /* If number of threads has been updated (or initially set),
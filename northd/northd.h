@@ -1177,10 +1177,13 @@ od_is_centralized(const struct ovn_datapath *od)
 
 struct ovn_port *ovn_port_find(const struct hmap *ports, const char *name);
 
+struct ovn_igmp_group;
 void build_igmp_lflows(struct hmap *igmp_groups,
                        const struct hmap *ls_datapaths,
                        struct lflow_table *lflows,
                        struct lflow_ref *lflow_ref);
+void build_igmp_group_lflows(struct ovn_igmp_group *,
+                             struct lflow_table *lflows);
 void build_lswitch_arp_nd_ic_learned_svc_mon(
     struct svc_monitors_map_data *svc_mons_data,
     const struct hmap *ls_ports,
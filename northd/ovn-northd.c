@@ -29,6 +29,7 @@
 #include "memory.h"
 #include "northd.h"
 #include "ovs-numa.h"
+#include "ovs-replay.h"
 #include "ovsdb-idl.h"
 #include "lib/ovn-l7.h"
 #include "lib/ovn-nb-idl.h"
@@ -621,6 +622,8 @@ Options:\n\
   --n-threads=N             specify number of threads\n\
   --dump-inc-proc-graph[=NODE]\n\
                             dump incremental processing graph and exit\n\
+  --record[=DIR]            record database traffic into DIR\n\
+  --replay[=DIR]            replay database traffic recorded in DIR\n\
   --unixctl=SOCKET          override default control socket name\n\
   -h, --help                display this help message\n\
   -o, --options             list available options\n\
@@ -642,6 +645,7 @@ parse_options(int argc OVS_UNUSED, char *argv[] OVS_UNUSED,
         OPT_DRY_RUN,
         OPT_N_THREADS,
         OPT_DUMP_INC_PROC_GRAPH,
+        OVS_REPLAY_OPTION_ENUMS,
     };
     static const struct option long_options[] = {
         {"ovnsb-db", required_argument, NULL, 'd'},
@@ -657,6 +661,7 @@ parse_options(int argc OVS_UNUSED, char *argv[] OVS_UNUSED,
         OVN_DAEMON_LONG_OPTIONS,
         VLOG_LONG_OPTIONS,
         STREAM_SSL_LONG_OPTIONS,
+        OVS_REPLAY_LONG_OPTIONS,
         {NULL, 0, NULL, 0},
     };
     char *short_options = ovs_cmdl_long_options_to_short_options(long_options);
@@ -672,6 +677,7 @@ parse_options(int argc OVS_UNUSED, char *argv[] OVS_UNUSED,
         switch (c) {
         OVN_DAEMON_OPTION_HANDLERS;
         VLOG_OPTION_HANDLERS;
+        OVS_REPLAY_OPTION_HANDLERS;
 
         case 'p':
             ssl_private_key_file = optarg;
@@ -1103,11 +1109,15 @@ main(int argc, char *argv[])
                     check_and_update_rbac(
                                  ovnsb_txn, ovnsb_idl_loop.idl);
 
-                    update_sequence_numbers(loop_start_time,
-                                            ovnnb_idl_loop.idl,
-                                            ovnsb_idl_loop.idl,
-                                            ovnnb_txn, ovnsb_txn,
-                                            &ovnsb_idl_loop);
+                    /* A recompute that yielded isn't complete yet, don't
+                     * report the NB configuration as applied. */
+                    if (!inc_proc_northd_need_resume()) {
+                        update_sequence_numbers(loop_start_time,
+                                                ovnnb_idl_loop.idl,
+                                                ovnsb_idl_loop.idl,
+                                                ovnnb_txn, ovnsb_txn,
+                                                &ovnsb_idl_loop);
+                    }
                 } else if (!inc_proc_northd_get_force_recompute()) {
                     clear_idl_track = false;
                 }
@@ -278,6 +278,8 @@ tests_ovstest_SOURCES = \
 	tests/ovstest.h \
 	tests/test-utils.c \
 	tests/test-utils.h \
+	tests/test-extend-table.c \
+	tests/test-objdep.c \
 	tests/test-ovn.c \
 	tests/test-sparse-array.c \
 	tests/test-vector.c \
@@ -0,0 +1,200 @@
+/* Copyright (c) 2026, Red Hat, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "lib/extend-table.h"
+#include "lib/ovn-util.h"
+#include "openvswitch/util.h"
+#include "tests/ovstest.h"
+
+#define N_IDS 16
+
+static struct uuid
+test_lflow_uuid(uint32_t i)
+{
+    struct uuid uuid = UUID_ZERO;
+    uuid.parts[0] = i;
+    return uuid;
+}
+
+static uint32_t
+test_assign(struct ovn_extend_table *table, const char *name, uint32_t lflow)
+{
+    return ovn_extend_table_assign_id(table, name, test_lflow_uuid(lflow));
+}
+
+static void
+test_remove(struct ovn_extend_table *table, uint32_t lflow)
+{
+    struct uuid uuid = test_lflow_uuid(lflow);
+    ovn_extend_table_remove_desired(table, &uuid);
+}
+
+/* Does what ofctrl_put() does with the table: removes the installed items
+ * that are not desired anymore and installs the new desired ones. */
+static void
+test_install(struct ovn_extend_table *table)
+{
+    struct ovn_extend_table_info *installed;
+    EXTEND_TABLE_FOR_EACH_INSTALLED (installed, table) {
+        ovn_extend_table_remove_existing(table, installed);
+    }
+    ovn_extend_table_sync(table);
+}
+
+/* Checks that the peers of 'table' are consistent, that the 'uninstalled'
+ * and 'stale' lists hold exactly the items without a peer and that their
+ * lengths are 'n_uninstalled' and 'n_stale'. */
+static void
+test_check(struct ovn_extend_table *table, size_t n_uninstalled,
+           size_t n_stale)
+{
+    size_t n_no_peer = 0;
+    struct ovn_extend_table_info *e;
+    HMAP_FOR_EACH (e, hmap_node, &table->desired) {
+        if (e->peer) {
+            ovs_assert(e->peer->peer == e);
+            ovs_assert(e->peer->table_id == e->table_id);
+            ovs_assert(!strcmp(e->peer->name, e->name));
+        } else {
+            n_no_peer++;
+        }
+        ovs_assert(!hmap_is_empty(&e->references));
+    }
+    ovs_assert(n_no_peer == n_uninstalled);
+    ovs_assert(ovs_list_size(&table->uninstalled) == n_uninstalled);
+    LIST_FOR_EACH (e, list_node, &table->uninstalled) {
+        ovs_assert(!e->peer);
+        ovs_assert(ovn_extend_table_desired_lookup_by_name(table, e->name)
+                   == e);
+    }
+
+    n_no_peer = 0;
+    HMAP_FOR_EACH (e, hmap_node, &table->existing) {
+        if (e->peer) {
+            ovs_assert(e->peer->peer == e);
+        } else {
+            n_no_peer++;
+        }
+    }
+    ovs_assert(n_no_peer == n_stale);
+    ovs_assert(ovs_list_size(&table->stale) == n_stale);
+    LIST_FOR_EACH (e, list_node, &table->stale) {
+        ovs_assert(!e->peer);
+        ovs_assert(!ovn_extend_table_desired_lookup_by_name(table, e->name));
+    }
+}
+
+static void
+test_ids(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    struct ovn_extend_table table;
+    char name[16];
+
+    ovn_extend_table_init(&table, "test", N_IDS);
+    test_check(&table, 0, 0);
+
+    /* Ids are assigned from the bottom, one per name. */
+    for (uint32_t i = 0; i < 8; i++) {
+        snprintf(name, sizeof name, "g%"PRIu32, i);
+        ovs_assert(test_assign(&table, name, i + 1) == i + 1);
+    }
+    /* A name that is already desired keeps its id. */
+    ovs_assert(test_assign(&table, "g0", 9) == 1);
+    ovs_assert(hmap_count(&table.desired) == 8);
+    test_check(&table, 8, 0);
+
+    test_install(&table);
+    ovs_assert(hmap_count(&table.existing) == 8);
+    test_check(&table, 0, 0);
+
+    /* Removing the desired items of an lflow makes the installed ones stale,
+     * their ids stay in use until they are removed from the switch. */
+    test_remove(&table, 3);
+    test_remove(&table, 5);
+    test_check(&table, 0, 2);
+    ovs_assert(test_assign(&table, "h0", 10) == 9);
+    test_check(&table, 1, 2);
+
+    /* A stale item that is wanted again gets its installed id back. */
+    ovs_assert(test_assign(&table, "g2", 11) == 3);
+    test_check(&table, 1, 1);
+
+    test_install(&table);
+    ovs_assert(hmap_count(&table.existing) == 8);
+    test_check(&table, 0, 0);
+
+    /* The id of the removed stale item is reused first. */
+    ovs_assert(test_assign(&table, "h1", 12) == 5);
+    test_check(&table, 1, 0);
+
+    /* An item stays desired as long as an lflow uses it. */
+    test_remove(&table, 9);
+    ovs_assert(ovn_extend_table_desired_lookup_by_name(&table, "g0"));
+    test_remove(&table, 1);
+    ovs_assert(!ovn_extend_table_desired_lookup_by_name(&table, "g0"));
+    test_check(&table, 1, 1);
+
+    test_install(&table);
+    test_check(&table, 0, 0);
+
+    /* Fill up the table, id 1 is reused first, then the ones above 9. */
+    ovs_assert(test_assign(&table, "h2", 13) == 1);
+    for (uint32_t i = 10; i <= N_IDS; i++) {
+        snprintf(name, sizeof name, "f%"PRIu32, i);
+        ovs_assert(test_assign(&table, name, 100 + i) == i);
+    }
+    ovs_assert(test_assign(&table, "full", 200) == EXT_TABLE_ID_INVALID);
+    ovs_assert(hmap_count(&table.desired) == N_IDS);
+    test_check(&table, N_IDS - 8, 0);
+
+    test_install(&table);
+    test_check(&table, 0, 0);
+
+    /* Clearing the desired table makes everything stale, and removing the
+     * stale items frees all the ids. */
+    ovn_extend_table_clear(&table, false);
+    ovs_assert(hmap_is_empty(&table.lflow_to_desired));
+    test_check(&table, 0, N_IDS);
+
+    test_install(&table);
+    ovs_assert(hmap_is_empty(&table.existing));
+    test_check(&table, 0, 0);
+
+    ovs_assert(test_assign(&table, "x", 300) == 1);
+    test_check(&table, 1, 0);
+
+    ovn_extend_table_destroy(&table);
+}
+
+static void
+test_extend_table_main(int argc, char *argv[])
+{
+    ovn_set_program_name(argv[0]);
+    static const struct ovs_cmdl_command commands[] = {
+        {"ids",  NULL, 0, 0, test_ids, OVS_RO},
+        {NULL,   NULL, 0, 0, NULL,     OVS_RO},
+    };
+    struct ovs_cmdl_context ctx;
+    ctx.argc = argc - 1;
+    ctx.argv = argv + 1;
+    ovs_cmdl_run_command(&ctx, commands);
+}
+
+OVSTEST_REGISTER("test-extend-table", test_extend_table_main);
@@ -0,0 +1,278 @@
+/* Copyright (c) 2026, Red Hat, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "lib/objdep.h"
+#include "lib/ovn-util.h"
+#include "openvswitch/util.h"
+#include "simap.h"
+#include "tests/ovstest.h"
+
+#define N_OBJS 8
+#define N_BIG_RES 20
+
+struct test_res {
+    enum objdep_type type;
+    char name[16];
+};
+
+/* All the resources the test objects may refer to:
+ * - "as1" and "pg1", shared by all objects,
+ * - "pbN", only referred by object N,
+ * - "bigN", referred by the last object only, enough of them for the object
+ *   to get a hash index over its references. */
+#define N_RES (2 + N_OBJS + N_BIG_RES)
+static struct test_res test_res[N_RES];
+
+/* Expected state of the manager: refs[i][j] is true if object 'i' refers to
+ * resource 'j', with reference count ref_counts[i][j]. */
+struct test_model {
+    bool present[N_OBJS];
+    bool refs[N_OBJS][N_RES];
+    size_t ref_counts[N_OBJS][N_RES];
+};
+
+static void
+test_res_init(void)
+{
+    size_t n = 0;
+
+    test_res[n].type = OBJDEP_TYPE_ADDRSET;
+    snprintf(test_res[n++].name, sizeof test_res[0].name, "as1");
+    test_res[n].type = OBJDEP_TYPE_PORTGROUP;
+    snprintf(test_res[n++].name, sizeof test_res[0].name, "pg1");
+    for (size_t i = 0; i < N_OBJS; i++) {
+        test_res[n].type = OBJDEP_TYPE_PORTBINDING;
+        snprintf(test_res[n++].name, sizeof test_res[0].name, "pb%"PRIuSIZE,
+                 i);
+    }
+    for (size_t i = 0; i < N_BIG_RES; i++) {
+        test_res[n].type = OBJDEP_TYPE_TEMPLATE;
+        snprintf(test_res[n++].name, sizeof test_res[0].name, "big%"PRIuSIZE,
+                 i);
+    }
+    ovs_assert(n == N_RES);
+}
+
+static struct uuid
+test_obj_uuid(size_t i)
+{
+    struct uuid uuid = UUID_ZERO;
+    uuid.parts[0] = i + 1;
+    return uuid;
+}
+
+static void
+test_add_ref(struct objdep_mgr *mgr, struct test_model *model,
+             size_t obj, size_t res, size_t ref_count)
+{
+    struct uuid uuid = test_obj_uuid(obj);
+
+    objdep_mgr_add_with_refcount(mgr, test_res[res].type, test_res[res].name,
+                                 &uuid, ref_count);
+    if (!model->refs[obj][res]) {
+        model->refs[obj][res] = true;
+        model->ref_counts[obj][res] = ref_count;
+    }
+    model->present[obj] = true;
+}
+
+static void
+test_add_obj(struct objdep_mgr *mgr, struct test_model *model, size_t obj)
+{
+    test_add_ref(mgr, model, obj, 0, obj + 1);
+    test_add_ref(mgr, model, obj, 1, 0);
+    test_add_ref(mgr, model, obj, 2 + obj, 0);
+    if (obj == N_OBJS - 1) {
+        for (size_t i = 0; i < N_BIG_RES; i++) {
+            test_add_ref(mgr, model, obj, 2 + N_OBJS + i, 0);
+        }
+    }
+    /* Adding an existing reference again is a no-op. */
+    test_add_ref(mgr, model, obj, 1, 0);
+}
+
+static void
+test_remove_obj(struct objdep_mgr *mgr, struct test_model *model, size_t obj)
+{
+    struct uuid uuid = test_obj_uuid(obj);
+
+    objdep_mgr_remove_obj(mgr, &uuid);
+    model->present[obj] = false;
+    memset(model->refs[obj], 0, sizeof model->refs[obj]);
+    memset(model->ref_counts[obj], 0, sizeof model->ref_counts[obj]);
+}
+
+static size_t
+test_obj_index(const struct object_to_resources_node *obj_node)
+{
+    ovs_assert(obj_node->obj_uuid.parts[0] >= 1
+               && obj_node->obj_uuid.parts[0] <= N_OBJS);
+    return obj_node->obj_uuid.parts[0] - 1;
+}
+
+static size_t
+test_res_index(const struct resource_to_objects_node *res_node)
+{
+    for (size_t i = 0; i < N_RES; i++) {
+        if (test_res[i].type == res_node->type
+            && !strcmp(test_res[i].name, res_node->res_name)) {
+            return i;
+        }
+    }
+    OVS_NOT_REACHED();
+}
+
+/* Checks that the lookups in both directions and the memory usage report of
+ * 'mgr' match 'model'. */
+static void
+test_check(struct objdep_mgr *mgr, const struct test_model *model)
+{
+    size_t n_objs = 0;
+    size_t n_refs = 0;
+
+    for (size_t i = 0; i < N_OBJS; i++) {
+        struct uuid uuid = test_obj_uuid(i);
+        struct object_to_resources_node *obj_node =
+            objdep_mgr_find_resources(mgr, &uuid);
+
+        ovs_assert(objdep_mgr_contains_obj(mgr, &uuid) == model->present[i]);
+        if (!model->present[i]) {
+            ovs_assert(!obj_node);
+            continue;
+        }
+        ovs_assert(obj_node);
+        n_objs++;
+
+        size_t n_obj_refs = 0;
+        for (size_t j = 0; j < N_RES; j++) {
+            n_obj_refs += model->refs[i][j];
+        }
+        ovs_assert(vector_len(&obj_node->resources) == n_obj_refs);
+        n_refs += n_obj_refs;
+
+        /* Every reference of the object must point back to it. */
+        const struct objdep_res_ref *res_ref;
+        VECTOR_FOR_EACH_PTR (&obj_node->resources, res_ref) {
+            const struct resource_to_objects_node *res_node =
+                res_ref->resource_node;
+
+            ovs_assert(model->refs[i][test_res_index(res_node)]);
+            ovs_assert(res_ref->index < vector_len(&res_node->objs));
+
+            const struct objdep_obj_ref *obj_ref =
+                vector_get_ptr(&res_node->objs, res_ref->index);
+            ovs_assert(obj_ref->obj_node == obj_node);
+        }
+    }
+
+    size_t n_res = 0;
+    for (size_t j = 0; j < N_RES; j++) {
+        struct resource_to_objects_node *res_node =
+            objdep_mgr_find_objs(mgr, test_res[j].type, test_res[j].name);
+
+        size_t n_res_refs = 0;
+        for (size_t i = 0; i < N_OBJS; i++) {
+            n_res_refs += model->refs[i][j];
+        }
+        if (!n_res_refs) {
+            ovs_assert(!res_node);
+            continue;
+        }
+        ovs_assert(res_node);
+        ovs_assert(vector_len(&res_node->objs) == n_res_refs);
+        n_res++;
+
+        bool seen[N_OBJS] = { false };
+        struct objdep_obj_ref *obj_ref;
+        RESOURCE_FOR_EACH_OBJ (obj_ref, res_node) {
+            size_t i = test_obj_index(obj_ref->obj_node);
+
+            ovs_assert(model->refs[i][j]);
+            ovs_assert(!seen[i]);
+            ovs_assert(obj_ref->ref_count == model->ref_counts[i][j]);
+            seen[i] = true;
+        }
+    }
+
+    struct simap usage = SIMAP_INITIALIZER(&usage);
+    objdep_mgr_get_memory_usage(mgr, "test", &usage);
+    ovs_assert(simap_get(&usage, "test-resources") == n_res);
+    ovs_assert(simap_get(&usage, "test-objects") == n_objs);
+    ovs_assert(simap_get(&usage, "test-refs") == n_refs);
+    ovs_assert(simap_get(&usage, "test-size-KB") > 0);
+    simap_destroy(&usage);
+}
+
+static void
+test_remove(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    struct test_model model;
+    struct objdep_mgr mgr;
+
+    test_res_init();
+    memset(&model, 0, sizeof model);
+    objdep_mgr_init(&mgr);
+
+    for (size_t i = 0; i < N_OBJS; i++) {
+        test_add_obj(&mgr, &model, i);
+        test_check(&mgr, &model);
+    }
+
+    /* Remove objects from the middle, the start and the end of the shared
+     * resources' object arrays, so that the swap-remove moves references of
+     * other objects, including the one with a hash index. */
+    static const size_t remove_order[] = { 3, 0, 7, 5, 1 };
+    for (size_t i = 0; i < ARRAY_SIZE(remove_order); i++) {
+        test_remove_obj(&mgr, &model, remove_order[i]);
+        test_check(&mgr, &model);
+    }
+
+    /* Removing an object that doesn't exist is a no-op. */
+    test_remove_obj(&mgr, &model, 3);
+    test_check(&mgr, &model);
+
+    /* Re-added objects are found again. */
+    test_add_obj(&mgr, &model, 7);
+    test_add_obj(&mgr, &model, 3);
+    test_check(&mgr, &model);
+
+    for (size_t i = 0; i < N_OBJS; i++) {
+        test_remove_obj(&mgr, &model, i);
+        test_check(&mgr, &model);
+    }
+
+    objdep_mgr_destroy(&mgr);
+}
+
+static void
+test_objdep_main(int argc, char *argv[])
+{
+    ovn_set_program_name(argv[0]);
+    static const struct ovs_cmdl_command commands[] = {
+        {"remove", NULL, 0, 0, test_remove, OVS_RO},
+        {NULL,     NULL, 0, 0, NULL,        OVS_RO},
+    };
+    struct ovs_cmdl_context ctx;
+    ctx.argc = argc - 1;
+    ctx.argv = argv + 1;
+    ovs_cmdl_run_command(&ctx, commands);
+}
+
+OVSTEST_REGISTER("test-objdep", test_objdep_main);
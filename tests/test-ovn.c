@@ -39,6 +39,8 @@
 #include "ovstest.h"
 #include "openvswitch/shash.h"
 #include "simap.h"
+#include "svec.h"
+#include "timeval.h"
 #include "util.h"
 #include "controller/lflow.h"
 
@@ -61,6 +63,9 @@ static enum { OP_CONVERT, OP_SIMPLIFY, OP_NORMALIZE, OP_FLOW } operation
 /* --parallel: Number of parallel processes to use in test. */
 static int test_parallel = 1;
 
+/* --benchmark: Number of iterations, in normalize-expr benchmark mode. */
+static int test_benchmark;
+
 /* -m, --more: Message verbosity */
 static int verbosity;
 
@@ -155,6 +160,8 @@ create_symtab(struct shash *symtab)
     expr_symtab_add_field(symtab, "mutual_recurse_2", MFF_XREG0,
                           "mutual_recurse_1 != 0", false);
     expr_symtab_add_string(symtab, "big_string", MFF_XREG0, NULL);
+
+    expr_symtab_freeze(symtab);
 }
 
 static void
@@ -371,6 +378,86 @@ test_parse_expr__(int steps)
     smap_destroy(&template_vars);
 }
 
+/* Lexes and then parses each expression read from stdin, N times over, and
+ * prints how long each of the two passes took. */
+static void
+test_benchmark_parse(struct ovs_cmdl_context *ctx)
+{
+    int n_iterations = atoi(ctx->argv[1]);
+    struct shash symtab;
+    struct shash addr_sets;
+    struct shash port_groups;
+    struct svec lines;
+    struct ds input;
+
+    if (n_iterations <= 0) {
+        ovs_fatal(0, "number of iterations must be positive");
+    }
+
+    create_symtab(&symtab);
+    create_addr_sets(&addr_sets);
+    create_port_groups(&port_groups);
+
+    svec_init(&lines);
+    ds_init(&input);
+    while (!ds_get_test_line(&input, stdin)) {
+        svec_add(&lines, ds_cstr(&input));
+    }
+    ds_destroy(&input);
+
+    uint64_t n_tokens = 0;
+    long long int start = time_usec();
+    for (int i = 0; i < n_iterations; i++) {
+        const char *line;
+        size_t j;
+
+        SVEC_FOR_EACH (j, line, &lines) {
+            struct lexer lexer;
+
+            lexer_init(&lexer, line);
+            while (lexer_get(&lexer) != LEX_T_END) {
+                n_tokens++;
+            }
+            lexer_destroy(&lexer);
+        }
+    }
+    long long int lex_usec = time_usec() - start;
+
+    size_t n_errors = 0;
+    start = time_usec();
+    for (int i = 0; i < n_iterations; i++) {
+        const char *line;
+        size_t j;
+
+        SVEC_FOR_EACH (j, line, &lines) {
+            char *error;
+            struct expr *expr = expr_parse_string(line, &symtab, &addr_sets,
+                                                  &port_groups, NULL, NULL, 0,
+                                                  &error);
+            if (error) {
+                n_errors++;
+                free(error);
+            }
+            expr_destroy(expr);
+        }
+    }
+    long long int parse_usec = time_usec() - start;
+
+    size_t n_lines = lines.n * n_iterations;
+    printf("lex: %"PRIuSIZE" expressions, %"PRIu64" tokens in %lld us\n",
+           n_lines, n_tokens, lex_usec);
+    printf("parse: %"PRIuSIZE" expressions, %"PRIuSIZE" errors in %lld us\n",
+           n_lines, n_errors, parse_usec);
+
+    svec_destroy(&lines);
+    expr_symtab_destroy(&symtab);
+    shash_destroy(&symtab);
+    expr_const_sets_destroy(&addr_sets);
+    shash_destroy(&addr_sets);
+    expr_const_sets_destroy(&port_groups);
+    shash_destroy(&port_groups);
+}
+
 static void
 test_parse_expr(struct ovs_cmdl_context *ctx OVS_UNUSED)
 {
@@ -389,10 +476,114 @@ test_simplify_expr(struct ovs_cmdl_context *ctx OVS_UNUSED)
     test_parse_expr__(2);
 }
 
+/* Normalizes each expression read from stdin 'test_benchmark' times, first
+ * without and then with an expr_memo, checks that both give the same result,
+ * and prints how long each took. */
+static void
+test_benchmark_normalize(void)
+{
+    struct shash symtab;
+    struct shash addr_sets;
+    struct shash port_groups;
+    struct simap ports;
+    struct ds input;
+
+    create_symtab(&symtab);
+    create_addr_sets(&addr_sets);
+    create_port_groups(&port_groups);
+    simap_init(&ports);
+
+    struct expr **exprs = NULL;
+    size_t n_exprs = 0, allocated_exprs = 0;
+
+    ds_init(&input);
+    while (!ds_get_test_line(&input, stdin)) {
+        char *error;
+        struct expr *expr = expr_parse_string(ds_cstr(&input), &symtab,
+                                              &addr_sets, &port_groups,
+                                              NULL, NULL, 0, &error);
+        if (!error) {
+            expr = expr_annotate(expr, &symtab, &error);
+        }
+        if (error) {
+            ovs_fatal(0, "%s: %s", ds_cstr(&input), error);
+        }
+        expr = expr_simplify(expr);
+        expr = expr_evaluate_condition(expr, is_chassis_resident_cb, &ports);
+
+        if (n_exprs >= allocated_exprs) {
+            exprs = x2nrealloc(exprs, &allocated_exprs, sizeof *exprs);
+        }
+        exprs[n_exprs++] = expr;
+    }
+    ds_destroy(&input);
+
+    long long int start = time_usec();
+    for (int i = 0; i < test_benchmark; i++) {
+        for (size_t j = 0; j < n_exprs; j++) {
+            expr_destroy(expr_normalize(expr_clone(exprs[j])));
+        }
+    }
+    long long int plain_usec = time_usec() - start;
+
+    struct expr_memo *memo = expr_memo_create(SIZE_MAX);
+    struct ds plain = DS_EMPTY_INITIALIZER;
+    struct ds memoized = DS_EMPTY_INITIALIZER;
+    long long int memo_usec = 0;
+    for (int i = 0; i < test_benchmark; i++) {
+        for (size_t j = 0; j < n_exprs; j++) {
+            start = time_usec();
+            struct expr *expr = expr_normalize_memo(expr_clone(exprs[j]),
+                                                    memo);
+            memo_usec += time_usec() - start;
+
+            struct expr *ref = expr_normalize(expr_clone(exprs[j]));
+            ds_clear(&plain);
+            ds_clear(&memoized);
+            expr_format(ref, &plain);
+            expr_format(expr, &memoized);
+            if (strcmp(ds_cstr(&plain), ds_cstr(&memoized))) {
+                ovs_fatal(0, "memoized normalization differs: %s vs %s",
+                          ds_cstr(&memoized), ds_cstr(&plain));
+            }
+            expr_destroy(ref);
+            expr_destroy(expr);
+        }
+    }
+    ds_destroy(&plain);
+    ds_destroy(&memoized);
+
+    uint64_t n_hits, n_misses;
+    expr_memo_get_stats(memo, &n_hits, &n_misses);
+    expr_memo_destroy(memo);
+
+    size_t n = n_exprs * test_benchmark;
+    printf("normalize: %"PRIuSIZE" expressions in %lld us\n", n, plain_usec);
+    printf("normalize with memo: %"PRIuSIZE" expressions, "
+           "%"PRIu64" hits, %"PRIu64" misses in %lld us\n",
+           n, n_hits, n_misses, memo_usec);
+
+    for (size_t j = 0; j < n_exprs; j++) {
+        expr_destroy(exprs[j]);
+    }
+    free(exprs);
+    simap_destroy(&ports);
+    expr_symtab_destroy(&symtab);
+    shash_destroy(&symtab);
+    expr_const_sets_destroy(&addr_sets);
+    shash_destroy(&addr_sets);
+    expr_const_sets_destroy(&port_groups);
+    shash_destroy(&port_groups);
+}
+
 static void
 test_normalize_expr(struct ovs_cmdl_context *ctx OVS_UNUSED)
 {
-    test_parse_expr__(3);
+    if (test_benchmark) {
+        test_benchmark_normalize();
+    } else {
+        test_parse_expr__(3);
+    }
 }
 
 static void
@@ -458,7 +649,14 @@ test_evaluate_expr(struct ovs_cmdl_context *ctx)
             expr = expr_annotate(expr, &symtab, &error);
         }
         if (!error) {
-            printf("%d\n", expr_evaluate(expr, &uflow, lookup_atoi_cb, NULL));
+            struct expr_program *prog = expr_compile(expr);
+            bool result = expr_program_evaluate(prog, &uflow,
+                                                lookup_atoi_cb, NULL);
+            ovs_assert(result == expr_evaluate(expr, &uflow,
+                                               lookup_atoi_cb, NULL));
+            expr_program_destroy(prog);
+
+            printf("%d\n", result);
         } else {
             puts(error);
             free(error);
@@ -965,6 +1163,7 @@ test_tree_shape_exhaustively(struct expr *expr, struct shash *symtab,
                                   vector_len(&m->conjunctions));
             }
         }
+        struct expr_program *modified_prog = expr_compile(modified);
         for (int subst = 0; subst < 1 << (n_bits * n_nvars + n_svars);
              subst++) {
             for (int i = 0; i < n_nvars; i++) {
@@ -976,7 +1175,8 @@ test_tree_shape_exhaustively(struct expr *expr, struct shash *symtab,
             }
 
             bool expected = expr_evaluate(expr, &f, lookup_atoi_cb, NULL);
-            bool actual = expr_evaluate(modified, &f, lookup_atoi_cb, NULL);
+            bool actual = expr_program_evaluate(modified_prog, &f,
+                                                lookup_atoi_cb, NULL);
             if (actual != expected) {
                 struct ds expr_s, modified_s;
 
@@ -1042,6 +1242,7 @@ test_tree_shape_exhaustively(struct expr *expr, struct shash *symtab,
                 }
             }
         }
+        expr_program_destroy(modified_prog);
         if (operation >= OP_FLOW) {
             struct test_rule *test_rule;
 
@@ -1525,12 +1726,17 @@ normalize-expr\n\
 expr-to-flows\n\
   Parses OVN expressions from stdin and prints them back on stdout after\n\
   differing degrees of analysis.  Available fields are based on packet\n\
-  headers.\n\
+  headers.  With --benchmark=N, normalize-expr instead normalizes each\n\
+  expression N times, with and without memoization, and prints timings.\n\
 \n\
 expr-to-packets\n\
   Parses OVN expressions from stdin and prints out matching packets in\n\
   hexadecimal on stdout.\n\
 \n\
+benchmark-parse N\n\
+  Lexes and parses the OVN expressions from stdin N times and prints the\n\
+  time taken by the lexer and by the parser on stdout.\n\
+\n\
 evaluate-expr MICROFLOW\n\
   Parses OVN expressions from stdin and evaluates them against the flow\n\
   specified in MICROFLOW, which must be an expression that constrains\n\
@@ -1585,7 +1791,8 @@ test_ovn_main(int argc, char *argv[])
         OPT_SVARS,
         OPT_BITS,
         OPT_OPERATION,
-        OPT_PARALLEL
+        OPT_PARALLEL,
+        OPT_BENCHMARK
     };
     static const struct option long_options[] = {
         {"relops", required_argument, NULL, OPT_RELOPS},
@@ -1594,6 +1801,7 @@ test_ovn_main(int argc, char *argv[])
         {"bits", required_argument, NULL, OPT_BITS},
         {"operation", required_argument, NULL, OPT_OPERATION},
         {"parallel", required_argument, NULL, OPT_PARALLEL},
+        {"benchmark", required_argument, NULL, OPT_BENCHMARK},
         {"more", no_argument, NULL, 'm'},
         {"help", no_argument, NULL, 'h'},
         {NULL, 0, NULL, 0},
@@ -1657,6 +1865,13 @@ test_ovn_main(int argc, char *argv[])
             test_parallel = atoi(optarg);
             break;
 
+        case OPT_BENCHMARK:
+            test_benchmark = atoi(optarg);
+            if (test_benchmark <= 0) {
+                ovs_fatal(0, "number of iterations must be positive");
+            }
+            break;
+
         case 'm':
             verbosity++;
             break;
@@ -1692,6 +1907,7 @@ test_ovn_main(int argc, char *argv[])
         {"tree-shape", NULL, 1, 1, test_tree_shape, OVS_RO},
         {"exhaustive", NULL, 1, 1, test_exhaustive, OVS_RO},
         {"expr-to-packets", NULL, 0, 0, test_expr_to_packets, OVS_RO},
+        {"benchmark-parse", NULL, 1, 1, test_benchmark_parse, OVS_RO},
 
         /* Actions. */
         {"parse-actions", NULL, 0, 0, test_parse_actions, OVS_RO},
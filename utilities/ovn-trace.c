@@ -16,6 +16,7 @@
 
 #include <config.h>
 
+#include <errno.h>
 #include <getopt.h>
 
 #include "command-line.h"
@@ -24,6 +25,8 @@
 #include "dirs.h"
 #include "fatal-signal.h"
 #include "flow.h"
+#include "hash.h"
+#include "hmapx.h"
 #include "nx-match.h"
 #include "openvswitch/dynamic-string.h"
 #include "openvswitch/json.h"
@@ -44,6 +47,7 @@
 #include "openvswitch/poll-loop.h"
 #include "stream-ssl.h"
 #include "stream.h"
+#include "timeval.h"
 #include "unixctl.h"
 #include "util.h"
 #include "random.h"
@@ -75,6 +79,9 @@ static bool summary;
 /* --minimal: Show a trace with only minimal information. */
 static bool minimal;
 
+/* --batch: File of microflows to trace, one per line. */
+static const char *batch_file;
+
 /* --ovs: OVS instance to contact to get OpenFlow flows. */
 static const char *ovs;
 static struct vconn *vconn;
@@ -95,12 +102,19 @@ static uint16_t select_id;
  * logical flows. */
 static bool use_friendly_names = true;
 
+/* --no-lflow-index: Whether to index the logical flow tables, instead of
+ * scanning all the flows of a table on each lookup. */
+static bool use_lflow_index = true;
+
 OVS_NO_RETURN static void usage(void);
 static void parse_options(int argc, char *argv[]);
 static char *trace(const char *datapath, const char *flow);
+static void trace_batch(const char *file_name);
 static void read_db(void);
+static void update_db(void);
 static unixctl_cb_func ovntrace_exit;
 static unixctl_cb_func ovntrace_trace;
+static unixctl_cb_func ovntrace_trace_batch;
 
 int
 main(int argc, char *argv[])
@@ -119,6 +133,15 @@ main(int argc, char *argv[])
             ovs_fatal(0, "non-option arguments not supported with --detach "
                       "(use --help for help)");
         }
+        if (batch_file) {
+            ovs_fatal(0, "--batch not supported with --detach "
+                      "(use --help for help)");
+        }
+    } else if (batch_file) {
+        if (argc != 0) {
+            ovs_fatal(0, "non-option arguments not supported with --batch "
+                      "(use --help for help)");
+        }
     } else {
         if (argc != 1 && argc != 2) {
             ovs_fatal(0, "one or two non-option arguments are required "
@@ -141,9 +164,15 @@ main(int argc, char *argv[])
         unixctl_command_register("exit", "", 0, 0, ovntrace_exit, &exiting);
         unixctl_command_register("trace", "[OPTIONS] [DATAPATH] MICROFLOW",
                                  1, INT_MAX, ovntrace_trace, NULL);
+        unixctl_command_register("trace-batch", "MICROFLOW...",
+                                 1, INT_MAX, ovntrace_trace_batch, NULL);
     }
     ovnsb_idl = ovsdb_idl_create(db, &sbrec_idl_class, true, false);
     ovsdb_idl_set_leader_only(ovnsb_idl, leader_only);
+    if (get_detach()) {
+        /* Keep the data read from the database up to date. */
+        ovsdb_idl_track_add_all(ovnsb_idl);
+    }
 
     bool already_read = false;
     for (;;) {
@@ -159,15 +188,22 @@ main(int argc, char *argv[])
             if (!already_read) {
                 already_read = true;
                 read_db();
+                ovsdb_idl_track_clear(ovnsb_idl);
+            } else {
+                update_db();
             }
 
             daemonize_complete();
             if (!get_detach()) {
-                const char *dp_s = argc > 1 ? argv[0] : NULL;
-                const char *flow_s = argv[argc - 1];
-                char *output = trace(dp_s, flow_s);
-                fputs(output, stdout);
-                free(output);
+                if (batch_file) {
+                    trace_batch(batch_file);
+                } else {
+                    const char *dp_s = argc > 1 ? argv[0] : NULL;
+                    const char *flow_s = argv[argc - 1];
+                    char *output = trace(dp_s, flow_s);
+                    fputs(output, stdout);
+                    free(output);
+                }
                 return 0;
             }
         }
@@ -260,11 +296,13 @@ parse_options(int argc, char *argv[])
         OPT_CT,
         OPT_FRIENDLY_NAMES,
         OPT_NO_FRIENDLY_NAMES,
+        OPT_NO_LFLOW_INDEX,
         OVN_DAEMON_OPTION_ENUMS,
         SSL_OPTION_ENUMS,
         VLOG_OPTION_ENUMS,
         OPT_LB_DST,
-        OPT_SELECT_ID
+        OPT_SELECT_ID,
+        OPT_BATCH
     };
     static const struct option long_options[] = {
         {"db", required_argument, NULL, OPT_DB},
@@ -279,10 +317,12 @@ parse_options(int argc, char *argv[])
         {"ct", required_argument, NULL, OPT_CT},
         {"friendly-names", no_argument, NULL, OPT_FRIENDLY_NAMES},
         {"no-friendly-names", no_argument, NULL, OPT_NO_FRIENDLY_NAMES},
+        {"no-lflow-index", no_argument, NULL, OPT_NO_LFLOW_INDEX},
         {"help", no_argument, NULL, 'h'},
         {"version", no_argument, NULL, 'V'},
         {"lb-dst", required_argument, NULL, OPT_LB_DST},
         {"select-id", required_argument, NULL, OPT_SELECT_ID},
+        {"batch", required_argument, NULL, OPT_BATCH},
         OVN_DAEMON_LONG_OPTIONS,
         VLOG_LONG_OPTIONS,
         STREAM_SSL_LONG_OPTIONS,
@@ -348,6 +388,10 @@ parse_options(int argc, char *argv[])
             use_friendly_names = false;
             break;
 
+        case OPT_NO_LFLOW_INDEX:
+            use_lflow_index = false;
+            break;
+
         case OPT_LB_DST:
             parse_lb_option(optarg);
             break;
@@ -356,6 +400,10 @@ parse_options(int argc, char *argv[])
             parse_select_option(optarg);
             break;
 
+        case OPT_BATCH:
+            batch_file = optarg;
+            break;
+
         case 'h':
             usage();
 
@@ -392,6 +440,7 @@ usage(void)
     printf("\
 %s: OVN trace utility\n\
 usage: %s [OPTIONS] [DATAPATH] MICROFLOW\n\
+       %s [OPTIONS] --batch=FILE\n\
        %s [OPTIONS] --detach\n\
 \n\
 Output format options:\n\
@@ -399,9 +448,11 @@ Output format options:\n\
   --summary               less detailed, more parseable\n\
   --minimal               minimum to explain externally visible behavior\n\
   --all                   provide all forms of output\n\
+  --batch=FILE            trace each microflow in FILE, one line of output\n\
+                          per microflow\n\
 Output style options:\n\
   --no-friendly-names     do not substitute human friendly names for UUIDs\n",
-           program_name, program_name, program_name);
+           program_name, program_name, program_name, program_name);
     daemon_usage();
     vlog_usage();
     printf("\n\
@@ -412,6 +463,7 @@ Other options:\n\
   --ovs[=REMOTE]          obtain corresponding OpenFlow flows from REMOTE\n\
                           (default: %s)\n\
   --unixctl=SOCKET        set control socket name\n\
+  --no-lflow-index        scan all logical flows of a table on each lookup\n\
   -h, --help              display this help message\n\
   -V, --version           display version information\n",
            default_sb_db(), default_ovs());
@@ -431,7 +483,7 @@ struct ovntrace_datapath {
 
     struct ovs_list mcgroups;   /* Contains "struct ovntrace_mcgroup"s. */
 
-    struct vector flows; /* Vector of struct ovntrace_flow *. */
+    struct hmap tables;         /* Contains "struct ovntrace_table"s. */
 
     struct hmap mac_bindings;   /* Contains "struct ovntrace_mac_binding"s. */
     struct hmap fdbs;   /* Contains "struct ovntrace_fdb"s. */
@@ -467,6 +519,8 @@ struct ovntrace_mcgroup {
 
 struct ovntrace_flow {
     struct uuid uuid;
+    struct ovntrace_table *table; /* Table that contains this flow. */
+    bool removed;                 /* To be removed from 'table'. */
     enum ovnact_pipeline pipeline;
     int table_id;
     char *stage_name;
@@ -474,19 +528,68 @@ struct ovntrace_flow {
     int priority;
     char *match_s;
     struct expr *match;
+    struct expr_program *match_prog; /* Compiled from 'match'. */
     struct ovnact *ovnacts;
     size_t ovnacts_len;
 };
 
+/* The logical flows in one table of one pipeline of a datapath.
+ *
+ * ovntrace_flow_lookup() must return the first flow in 'flows' that matches.
+ * To avoid evaluating every flow's match, the table is indexed on
+ * 'key_field', one of a few fields that logical flows commonly match exactly.
+ * A flow whose match can only be true if 'key_field' has one of a few
+ * particular values is in the bucket in 'buckets' for each of those values.
+ * Every other flow is in 'wildcards'.  For a given microflow, only the flows
+ * in 'wildcards' and in the bucket for the microflow's value of 'key_field'
+ * can match.
+ *
+ * 'key_field' is NULL if no flow in the table matches any of the candidate
+ * fields exactly, in which case the buckets and 'wildcards' are empty. */
+struct ovntrace_table {
+    struct hmap_node node;      /* In struct ovntrace_datapath's 'tables'. */
+    enum ovnact_pipeline pipeline;
+    uint8_t table_id;
+
+    struct vector flows;        /* Contains "struct ovntrace_flow *". */
+    bool stale;                 /* 'flows' changed since last indexed. */
+
+    const struct mf_field *key_field;
+    struct hmap buckets;        /* Contains "struct ovntrace_bucket"s. */
+    struct vector wildcards;    /* Contains "size_t" indexes into 'flows'. */
+};
+
+struct ovntrace_bucket {
+    struct hmap_node node;      /* In struct ovntrace_table's 'buckets'. */
+    uint64_t key;               /* See ovntrace_bytes_to_key(). */
+    struct vector flows;        /* Contains "size_t" indexes into the
+                                 * table's 'flows', in increasing order. */
+};
+
+/* The ovntrace_flows parsed from one southbound Logical_Flow, one for each
+ * of its datapaths. */
+struct ovntrace_lflow {
+    struct hmap_node node;      /* In 'lflows', by 'uuid'. */
+    struct uuid uuid;           /* Southbound Logical_Flow record UUID. */
+    struct vector flows;        /* Contains "struct ovntrace_flow *". */
+};
+
 struct ovntrace_mac_binding {
-    struct hmap_node node;
+    struct hmap_node node;      /* In struct ovntrace_datapath's
+                                 * 'mac_bindings'. */
+    struct hmap_node uuid_node; /* In 'mac_bindings_by_uuid'. */
+    struct uuid uuid;           /* Southbound MAC_Binding record UUID. */
+    struct ovntrace_datapath *dp;
     uint16_t port_key;
     struct in6_addr ip;
     struct eth_addr mac;
 };
 
 struct ovntrace_fdb {
-    struct hmap_node node;
+    struct hmap_node node;      /* In struct ovntrace_datapath's 'fdbs'. */
+    struct hmap_node uuid_node; /* In 'fdbs_by_uuid'. */
+    struct uuid uuid;           /* Southbound FDB record UUID. */
+    struct ovntrace_datapath *dp;
     uint16_t port_key;
     struct eth_addr mac;
 };
@@ -509,6 +612,14 @@ static struct hmap datapaths;
 /* Every ovntrace_port, by name. */
 static struct shash ports;
 
+/* Every ovntrace_lflow, by southbound Logical_Flow record UUID. */
+static struct hmap lflows;
+
+/* Every ovntrace_mac_binding and ovntrace_fdb, by southbound record UUID, so
+ * that daemon mode can apply changes to them one by one. */
+static struct hmap mac_bindings_by_uuid;
+static struct hmap fdbs_by_uuid;
+
 /* Symbol table for expressions and actions. */
 static struct shash symtab;
 
@@ -720,7 +831,7 @@ read_datapaths(void)
                              : shorten_uuid(dp->name2 ? dp->name2 : dp->name));
 
         dp->tunnel_key = sbdb->tunnel_key;
-        dp->flows = VECTOR_EMPTY_INITIALIZER(struct ovntrace_flow *);
+        hmap_init(&dp->tables);
 
         ovs_list_init(&dp->mcgroups);
         hmap_init(&dp->mac_bindings);
@@ -940,6 +1051,252 @@ compare_flow(const void *a_, const void *b_)
     }
 }
 
+static bool ovntrace_lookup_port__(const struct ovntrace_datapath *,
+                                   const char *port_name, unsigned int *portp,
+                                   bool warn);
+
+static struct ovntrace_table *
+ovntrace_table_find(const struct ovntrace_datapath *dp, uint8_t table_id,
+                    enum ovnact_pipeline pipeline)
+{
+    struct ovntrace_table *table;
+    HMAP_FOR_EACH_WITH_HASH (table, node, hash_2words(table_id, pipeline),
+                             &dp->tables) {
+        if (table->table_id == table_id && table->pipeline == pipeline) {
+            return table;
+        }
+    }
+    return NULL;
+}
+
+static struct ovntrace_table *
+ovntrace_table_create(struct ovntrace_datapath *dp, uint8_t table_id,
+                      enum ovnact_pipeline pipeline)
+{
+    struct ovntrace_table *table = xzalloc(sizeof *table);
+    table->pipeline = pipeline;
+    table->table_id = table_id;
+    table->flows = VECTOR_EMPTY_INITIALIZER(struct ovntrace_flow *);
+    table->stale = true;
+    hmap_init(&table->buckets);
+    table->wildcards = VECTOR_EMPTY_INITIALIZER(size_t);
+    hmap_insert(&dp->tables, &table->node, hash_2words(table_id, pipeline));
+    return table;
+}
+
+/* Folds the 'n' bytes in 'b', which must be at most 8, into an integer for use
+ * as a key in struct ovntrace_table's 'buckets'. */
+static uint64_t
+ovntrace_bytes_to_key(const uint8_t *b, int n)
+{
+    uint64_t key = 0;
+    for (int i = 0; i < n; i++) {
+        key = (key << 8) | b[i];
+    }
+    return key;
+}
+
+static struct ovntrace_bucket *
+ovntrace_bucket_find(const struct ovntrace_table *table, uint64_t key)
+{
+    struct ovntrace_bucket *bucket;
+    HMAP_FOR_EACH_WITH_HASH (bucket, node, hash_uint64(key),
+                             &table->buckets) {
+        if (bucket->key == key) {
+            return bucket;
+        }
+    }
+    return NULL;
+}
+
+/* If 'e' is a comparison that is true only if 'field' has a particular value,
+ * stores that value's key in '*key' and returns true.  Otherwise returns
+ * false. */
+static bool
+ovntrace_cmp_to_key(const struct expr *e, const struct mf_field *field,
+                    const struct ovntrace_datapath *dp, uint64_t *key)
+{
+    if (e->type != EXPR_T_CMP ||
+        e->cmp.relop != EXPR_R_EQ ||
+        e->cmp.symbol->field != field) {
+        return false;
+    }
+
+    if (e->cmp.symbol->width) {
+        int n_bytes = field->n_bytes;
+        const uint8_t *mask = &e->cmp.mask.u8[sizeof e->cmp.mask - n_bytes];
+        for (int i = 0; i < n_bytes; i++) {
+            if (mask[i] != 0xff) {
+                return false;
+            }
+        }
+        *key = ovntrace_bytes_to_key(
+            &e->cmp.value.u8[sizeof e->cmp.value - n_bytes], n_bytes);
+    } else {
+        /* String fields hold port numbers, which expr_evaluate() compares
+         * against the whole field. */
+        unsigned int port;
+        if (!ovntrace_lookup_port__(dp, e->cmp.string, &port, false)) {
+            return false;
+        }
+        *key = port;
+    }
+    return true;
+}
+
+/* If 'flow''s match can only be true if 'field' has one of a few particular
+ * values, appends the keys for those values to 'keys' and returns true.
+ * Otherwise returns false without modifying 'keys'. */
+static bool
+ovntrace_flow_to_keys(const struct ovntrace_flow *flow,
+                      const struct mf_field *field,
+                      const struct ovntrace_datapath *dp, struct vector *keys)
+{
+    const struct expr *match = flow->match;
+    uint64_t key;
+
+    if (match->type == EXPR_T_CMP) {
+        if (ovntrace_cmp_to_key(match, field, dp, &key)) {
+            vector_push(keys, &key);
+            return true;
+        }
+        return false;
+    } else if (match->type != EXPR_T_AND) {
+        return false;
+    }
+
+    /* Any conjunct that constrains 'field' will do. */
+    const struct expr *term;
+    LIST_FOR_EACH (term, node, &match->andor) {
+        if (ovntrace_cmp_to_key(term, field, dp, &key)) {
+            vector_push(keys, &key);
+            return true;
+        } else if (term->type == EXPR_T_OR) {
+            size_t n = vector_len(keys);
+            bool all = true;
+            const struct expr *sub;
+            LIST_FOR_EACH (sub, node, &term->andor) {
+                if (!ovntrace_cmp_to_key(sub, field, dp, &key)) {
+                    all = false;
+                    break;
+                }
+                vector_push(keys, &key);
+            }
+            if (all) {
+                return true;
+            }
+            vector_remove_block(keys, n, vector_len(keys));
+        }
+    }
+    return false;
+}
+
+/* Builds the index for 'table', whose 'flows' must already be sorted. */
+static void
+ovntrace_table_index(struct ovntrace_table *table,
+                     const struct ovntrace_datapath *dp)
+{
+    static const char *const candidates[] = {
+        "inport", "outport", "eth.dst", "ip4.dst",
+    };
+
+    /* Index on the candidate field that the most flows constrain. */
+    struct vector keys = VECTOR_EMPTY_INITIALIZER(uint64_t);
+    size_t best_n = 0;
+    for (size_t i = 0; i < ARRAY_SIZE(candidates); i++) {
+        const struct expr_symbol *symbol = shash_find_data(&symtab,
+                                                           candidates[i]);
+        const struct mf_field *field = symbol ? symbol->field : NULL;
+        if (!field || field->n_bytes > sizeof(uint64_t)) {
+            continue;
+        }
+
+        size_t n = 0;
+        const struct ovntrace_flow *flow;
+        VECTOR_FOR_EACH (&table->flows, flow) {
+            vector_clear(&keys);
+            n += ovntrace_flow_to_keys(flow, field, dp, &keys);
+        }
+        if (n > best_n) {
+            best_n = n;
+            table->key_field = field;
+        }
+    }
+    if (!table->key_field) {
+        vector_destroy(&keys);
+        return;
+    }
+
+    for (size_t i = 0; i < vector_len(&table->flows); i++) {
+        const struct ovntrace_flow *flow = vector_get(&table->flows, i,
+                                                      struct ovntrace_flow *);
+        vector_clear(&keys);
+        if (!ovntrace_flow_to_keys(flow, table->key_field, dp, &keys)) {
+            vector_push(&table->wildcards, &i);
+            continue;
+        }
+
+        const uint64_t *key;
+        VECTOR_FOR_EACH_PTR (&keys, key) {
+            struct ovntrace_bucket *bucket = ovntrace_bucket_find(table, *key);
+            if (!bucket) {
+                bucket = xmalloc(sizeof *bucket);
+                bucket->key = *key;
+                bucket->flows = VECTOR_EMPTY_INITIALIZER(size_t);
+                hmap_insert(&table->buckets, &bucket->node,
+                            hash_uint64(*key));
+            }
+
+            /* A flow may list the same value more than once. */
+            size_t n = vector_len(&bucket->flows);
+            if (!n || vector_get(&bucket->flows, n - 1, size_t) != i) {
+                vector_push(&bucket->flows, &i);
+            }
+        }
+    }
+    vector_destroy(&keys);
+}
+
+static void
+ovntrace_table_clear_index(struct ovntrace_table *table)
+{
+    struct ovntrace_bucket *bucket;
+    HMAP_FOR_EACH_POP (bucket, node, &table->buckets) {
+        vector_destroy(&bucket->flows);
+        free(bucket);
+    }
+    vector_clear(&table->wildcards);
+    table->key_field = NULL;
+}
+
+static void
+ovntrace_flow_destroy(struct ovntrace_flow *flow)
+{
+    free(flow->stage_name);
+    free(flow->source);
+    free(flow->match_s);
+    expr_destroy(flow->match);
+    expr_program_destroy(flow->match_prog);
+    ovnacts_free(flow->ovnacts, flow->ovnacts_len);
+    free(flow->ovnacts);
+    free(flow);
+}
+
+static void
+ovntrace_table_destroy(struct ovntrace_table *table)
+{
+    struct ovntrace_flow *flow;
+    VECTOR_FOR_EACH (&table->flows, flow) {
+        ovntrace_flow_destroy(flow);
+    }
+    vector_destroy(&table->flows);
+
+    ovntrace_table_clear_index(table);
+    hmap_destroy(&table->buckets);
+    vector_destroy(&table->wildcards);
+    free(table);
+}
+
 static char *
 ovntrace_make_names_friendly(const char *in)
 {
@@ -974,6 +1331,18 @@ ovntrace_make_names_friendly(const char *in)
     return ds_steal_cstr(&out);
 }
 
+static struct ovntrace_lflow *
+ovntrace_lflow_find(const struct uuid *uuid)
+{
+    struct ovntrace_lflow *lflow;
+    HMAP_FOR_EACH_WITH_HASH (lflow, node, uuid_hash(uuid), &lflows) {
+        if (uuid_equals(&lflow->uuid, uuid)) {
+            return lflow;
+        }
+    }
+    return NULL;
+}
+
 static void
 parse_lflow_for_datapath(const struct sbrec_logical_flow *sblf,
                         const struct sbrec_datapath_binding *sbdb)
@@ -1068,40 +1437,158 @@ parse_lflow_for_datapath(const struct sbrec_logical_flow *sblf,
         flow->priority = sblf->priority;
         flow->match_s = ovntrace_make_names_friendly(sblf->match);
         flow->match = match;
+        flow->match_prog = match ? expr_compile(match) : NULL;
         flow->ovnacts_len = ovnacts.size;
         flow->ovnacts = ofpbuf_steal_data(&ovnacts);
 
-        vector_push(&dp->flows, &flow);
+        struct ovntrace_table *table = ovntrace_table_find(dp, flow->table_id,
+                                                           flow->pipeline);
+        if (!table) {
+            table = ovntrace_table_create(dp, flow->table_id, flow->pipeline);
+        }
+        flow->table = table;
+        vector_push(&table->flows, &flow);
+        table->stale = true;
+
+        struct ovntrace_lflow *lflow = ovntrace_lflow_find(&flow->uuid);
+        if (!lflow) {
+            lflow = xmalloc(sizeof *lflow);
+            lflow->uuid = flow->uuid;
+            lflow->flows = VECTOR_EMPTY_INITIALIZER(struct ovntrace_flow *);
+            hmap_insert(&lflows, &lflow->node, uuid_hash(&lflow->uuid));
+        }
+        vector_push(&lflow->flows, &flow);
+}
+
+static void
+read_flow(const struct sbrec_logical_flow *sblf)
+{
+    bool missing_datapath = true;
+
+    if (sblf->logical_datapath) {
+        parse_lflow_for_datapath(sblf, sblf->logical_datapath);
+        missing_datapath = false;
+    }
+
+    const struct sbrec_logical_dp_group *g = sblf->logical_dp_group;
+    for (size_t i = 0; g && i < g->n_datapaths; i++) {
+        parse_lflow_for_datapath(sblf, g->datapaths[i]);
+        missing_datapath = false;
+    }
+    if (missing_datapath) {
+        VLOG_WARN_RL(&rl, "logical flow missing datapath");
+    }
+}
+
+/* Sorts and indexes the flows in every table whose flows changed since it was
+ * last indexed, and frees the tables that no longer have any flows.  'start'
+ * is the time at which parsing of the flows began, for logging. */
+static void
+index_flows(long long int start)
+{
+    long long int parsed = time_msec();
+
+    size_t n_flows = 0;
+    size_t n_tables = 0;
+    size_t n_indexed = 0;
+    struct ovntrace_datapath *dp;
+    HMAP_FOR_EACH (dp, sb_uuid_node, &datapaths) {
+        struct ovntrace_table *table;
+        HMAP_FOR_EACH_SAFE (table, node, &dp->tables) {
+            if (!table->stale) {
+                continue;
+            }
+            if (vector_is_empty(&table->flows)) {
+                hmap_remove(&dp->tables, &table->node);
+                ovntrace_table_destroy(table);
+                continue;
+            }
+
+            ovntrace_table_clear_index(table);
+            vector_qsort(&table->flows, compare_flow);
+            if (use_lflow_index) {
+                ovntrace_table_index(table, dp);
+            }
+            table->stale = false;
+
+            n_flows += vector_len(&table->flows);
+            n_tables++;
+            n_indexed += table->key_field != NULL;
+        }
+    }
+    VLOG_DBG("parsed logical flows in %lld ms, indexed %"PRIuSIZE" of "
+             "%"PRIuSIZE" changed tables (%"PRIuSIZE" flows) in %lld ms",
+             parsed - start, n_indexed, n_tables, n_flows,
+             time_msec() - parsed);
 }
 
 static void
 read_flows(void)
 {
+    hmap_init(&lflows);
     ovn_init_symtab(&symtab);
+    expr_symtab_freeze(&symtab);
 
+    long long int start = time_msec();
     const struct sbrec_logical_flow *sblf;
     SBREC_LOGICAL_FLOW_FOR_EACH (sblf, ovnsb_idl) {
-        bool missing_datapath = true;
+        read_flow(sblf);
+    }
+    index_flows(start);
+}
+
+/* Applies the changes to the Logical_Flow table tracked by the IDL. */
+static void
+update_flows(void)
+{
+    long long int start = time_msec();
 
-        if (sblf->logical_datapath) {
-            parse_lflow_for_datapath(sblf, sblf->logical_datapath);
-            missing_datapath = false;
+    /* Remove the old versions of the changed flows from their tables... */
+    struct hmapx tables = HMAPX_INITIALIZER(&tables);
+    const struct sbrec_logical_flow *sblf;
+    SBREC_LOGICAL_FLOW_FOR_EACH_TRACKED (sblf, ovnsb_idl) {
+        struct ovntrace_lflow *lflow =
+            ovntrace_lflow_find(&sblf->header_.uuid);
+        if (!lflow) {
+            continue;
         }
 
-        const struct sbrec_logical_dp_group *g = sblf->logical_dp_group;
-        for (size_t i = 0; g && i < g->n_datapaths; i++) {
-            parse_lflow_for_datapath(sblf, g->datapaths[i]);
-            missing_datapath = false;
+        struct ovntrace_flow *flow;
+        VECTOR_FOR_EACH (&lflow->flows, flow) {
+            flow->removed = true;
+            hmapx_add(&tables, flow->table);
         }
-        if (missing_datapath) {
-            VLOG_WARN_RL(&rl, "logical flow missing datapath");
+        hmap_remove(&lflows, &lflow->node);
+        vector_destroy(&lflow->flows);
+        free(lflow);
+    }
+
+    struct hmapx_node *node;
+    HMAPX_FOR_EACH (node, &tables) {
+        struct ovntrace_table *table = node->data;
+        struct ovntrace_flow **flows = vector_get_array(&table->flows);
+        size_t n = vector_len(&table->flows);
+        size_t n_kept = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (flows[i]->removed) {
+                ovntrace_flow_destroy(flows[i]);
+            } else {
+                flows[n_kept++] = flows[i];
+            }
         }
+        vector_remove_block(&table->flows, n_kept, n);
+        table->stale = true;
     }
+    hmapx_destroy(&tables);
 
-    struct ovntrace_datapath *dp;
-    HMAP_FOR_EACH (dp, sb_uuid_node, &datapaths) {
-        vector_qsort(&dp->flows, compare_flow);
+    /* ...then add their new versions. */
+    SBREC_LOGICAL_FLOW_FOR_EACH_TRACKED (sblf, ovnsb_idl) {
+        if (!sbrec_logical_flow_is_deleted(sblf)) {
+            read_flow(sblf);
+        }
     }
+
+    index_flows(start);
 }
 
 static void
@@ -1127,66 +1614,86 @@ read_gen_opts(void)
     smap_init(&template_vars);
 }
 
+static void
+read_mac_binding(const struct sbrec_mac_binding *sbmb)
+{
+    const struct ovntrace_port *port = shash_find_data(
+        &ports, sbmb->logical_port);
+    if (!port) {
+        VLOG_WARN_RL(&rl, "missing port %s", sbmb->logical_port);
+        return;
+    }
+
+    if (!uuid_equals(&port->dp->sb_uuid, &sbmb->datapath->header_.uuid)) {
+        VLOG_WARN_RL(&rl, "port %s is in wrong datapath",
+                     sbmb->logical_port);
+        return;
+    }
+
+    struct in6_addr ip6;
+    if (!ip46_parse(sbmb->ip, &ip6)) {
+        VLOG_WARN_RL(&rl, "%s: bad IP address", sbmb->ip);
+        return;
+    }
+
+    struct eth_addr mac;
+    if (!eth_addr_from_string(sbmb->mac, &mac)) {
+        VLOG_WARN_RL(&rl, "%s: bad Ethernet address", sbmb->mac);
+        return;
+    }
+
+    struct ovntrace_mac_binding *binding = xmalloc(sizeof *binding);
+    binding->uuid = sbmb->header_.uuid;
+    binding->dp = port->dp;
+    binding->port_key = port->tunnel_key;
+    binding->ip = ip6;
+    binding->mac = mac;
+    hmap_insert(&port->dp->mac_bindings, &binding->node,
+                hash_mac_binding(binding->port_key, &ip6));
+    hmap_insert(&mac_bindings_by_uuid, &binding->uuid_node,
+                uuid_hash(&binding->uuid));
+}
+
 static void
 read_mac_bindings(void)
 {
+    hmap_init(&mac_bindings_by_uuid);
     const struct sbrec_mac_binding *sbmb;
     SBREC_MAC_BINDING_FOR_EACH (sbmb, ovnsb_idl) {
-        const struct ovntrace_port *port = shash_find_data(
-            &ports, sbmb->logical_port);
-        if (!port) {
-            VLOG_WARN_RL(&rl, "missing port %s", sbmb->logical_port);
-            continue;
-        }
-
-        if (!uuid_equals(&port->dp->sb_uuid, &sbmb->datapath->header_.uuid)) {
-            VLOG_WARN_RL(&rl, "port %s is in wrong datapath",
-                         sbmb->logical_port);
-            continue;
-        }
-
-        struct in6_addr ip6;
-        if (!ip46_parse(sbmb->ip, &ip6)) {
-            VLOG_WARN_RL(&rl, "%s: bad IP address", sbmb->ip);
-            continue;
-        }
+        read_mac_binding(sbmb);
+    }
+}
 
-        struct eth_addr mac;
-        if (!eth_addr_from_string(sbmb->mac, &mac)) {
-            VLOG_WARN_RL(&rl, "%s: bad Ethernet address", sbmb->mac);
-            continue;
-        }
+static void
+read_fdb(const struct sbrec_fdb *fdb)
+{
+    struct eth_addr mac;
+    if (!eth_addr_from_string(fdb->mac, &mac)) {
+        VLOG_WARN_RL(&rl, "%s: bad Ethernet address", fdb->mac);
+        return;
+    }
 
-        struct ovntrace_mac_binding *binding = xmalloc(sizeof *binding);
-        binding->port_key = port->tunnel_key;
-        binding->ip = ip6;
-        binding->mac = mac;
-        hmap_insert(&port->dp->mac_bindings, &binding->node,
-                    hash_mac_binding(binding->port_key, &ip6));
+    struct ovntrace_datapath *dp = ovntrace_datapath_find_by_key(fdb->dp_key);
+    if (!dp) {
+        return;
     }
+
+    struct ovntrace_fdb *fdb_t = xmalloc(sizeof *fdb_t);
+    fdb_t->uuid = fdb->header_.uuid;
+    fdb_t->dp = dp;
+    fdb_t->mac = mac;
+    fdb_t->port_key = fdb->port_key;
+    hmap_insert(&dp->fdbs, &fdb_t->node, hash_fdb(&mac));
+    hmap_insert(&fdbs_by_uuid, &fdb_t->uuid_node, uuid_hash(&fdb_t->uuid));
 }
 
 static void
 read_fdbs(void)
 {
+    hmap_init(&fdbs_by_uuid);
     const struct sbrec_fdb *fdb;
     SBREC_FDB_FOR_EACH (fdb, ovnsb_idl) {
-        struct eth_addr mac;
-        if (!eth_addr_from_string(fdb->mac, &mac)) {
-            VLOG_WARN_RL(&rl, "%s: bad Ethernet address", fdb->mac);
-            continue;
-        }
-
-        struct ovntrace_datapath *dp =
-            ovntrace_datapath_find_by_key(fdb->dp_key);
-        if (!dp) {
-            continue;
-        }
-
-        struct ovntrace_fdb *fdb_t = xmalloc(sizeof *fdb_t);
-        fdb_t->mac = mac;
-        fdb_t->port_key = fdb->port_key;
-        hmap_insert(&dp->fdbs, &fdb_t->node, hash_fdb(&mac));
+        read_fdb(fdb);
     }
 }
 
@@ -1204,6 +1711,196 @@ read_db(void)
     read_fdbs();
 }
 
+static void
+clear_mac_bindings(struct ovntrace_datapath *dp)
+{
+    struct ovntrace_mac_binding *binding;
+    HMAP_FOR_EACH_POP (binding, node, &dp->mac_bindings) {
+        free(binding);
+    }
+
+    struct ovntrace_fdb *fdb;
+    HMAP_FOR_EACH_POP (fdb, node, &dp->fdbs) {
+        free(fdb);
+    }
+}
+
+/* Frees everything that read_db() read. */
+static void
+destroy_db(void)
+{
+    struct ovntrace_datapath *dp;
+    HMAP_FOR_EACH_POP (dp, sb_uuid_node, &datapaths) {
+        struct ovntrace_mcgroup *mcgroup;
+        LIST_FOR_EACH_POP (mcgroup, list_node, &dp->mcgroups) {
+            free(mcgroup->name);
+            free(mcgroup->ports);
+            free(mcgroup);
+        }
+
+        struct ovntrace_table *table;
+        HMAP_FOR_EACH_POP (table, node, &dp->tables) {
+            ovntrace_table_destroy(table);
+        }
+        hmap_destroy(&dp->tables);
+
+        clear_mac_bindings(dp);
+        hmap_destroy(&dp->mac_bindings);
+        hmap_destroy(&dp->fdbs);
+
+        free(dp->name);
+        free(dp->name2);
+        free(dp->friendly_name);
+        free(dp);
+    }
+    hmap_destroy(&datapaths);
+    hmap_destroy(&mac_bindings_by_uuid);
+    hmap_destroy(&fdbs_by_uuid);
+
+    struct ovntrace_lflow *lflow;
+    HMAP_FOR_EACH_POP (lflow, node, &lflows) {
+        vector_destroy(&lflow->flows);
+        free(lflow);
+    }
+    hmap_destroy(&lflows);
+
+    struct shash_node *node;
+    SHASH_FOR_EACH (node, &ports) {
+        struct ovntrace_port *port = node->data;
+        free(port->name);
+        free(port->name2);
+        free(CONST_CAST(char *, port->friendly_name));
+        free(port->type);
+        for (size_t i = 0; i < port->n_ps_addrs; i++) {
+            destroy_lport_addresses(&port->ps_addrs[i]);
+        }
+        free(port->ps_addrs);
+        free(port);
+    }
+    shash_destroy(&ports);
+
+    expr_const_sets_destroy(&address_sets);
+    shash_destroy(&address_sets);
+    expr_const_sets_destroy(&port_groups);
+    shash_destroy(&port_groups);
+
+    dhcp_opts_destroy(&dhcp_opts);
+    dhcp_opts_destroy(&dhcpv6_opts);
+    nd_ra_opts_destroy(&nd_ra_opts);
+    controller_event_opts_destroy(&event_opts);
+    smap_destroy(&template_vars);
+
+    expr_symtab_destroy(&symtab);
+    shash_destroy(&symtab);
+}
+
+/* Returns true if the IDL tracked a change to a Port_Binding column that
+ * read_ports() uses.  Other columns, such as "chassis" and "up", change far
+ * more often and don't matter to ovn-trace. */
+static bool
+port_bindings_changed(void)
+{
+    const struct sbrec_port_binding *sbpb;
+    SBREC_PORT_BINDING_FOR_EACH_TRACKED (sbpb, ovnsb_idl) {
+        if (sbrec_port_binding_is_new(sbpb) ||
+            sbrec_port_binding_is_deleted(sbpb) ||
+            sbrec_port_binding_is_updated(
+                sbpb, SBREC_PORT_BINDING_COL_LOGICAL_PORT) ||
+            sbrec_port_binding_is_updated(
+                sbpb, SBREC_PORT_BINDING_COL_DATAPATH) ||
+            sbrec_port_binding_is_updated(sbpb, SBREC_PORT_BINDING_COL_TYPE) ||
+            sbrec_port_binding_is_updated(
+                sbpb, SBREC_PORT_BINDING_COL_TUNNEL_KEY) ||
+            sbrec_port_binding_is_updated(
+                sbpb, SBREC_PORT_BINDING_COL_EXTERNAL_IDS) ||
+            sbrec_port_binding_is_updated(
+                sbpb, SBREC_PORT_BINDING_COL_OPTIONS) ||
+            sbrec_port_binding_is_updated(
+                sbpb, SBREC_PORT_BINDING_COL_PORT_SECURITY)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Applies the changes to the MAC_Binding table tracked by the IDL. */
+static void
+update_mac_bindings(void)
+{
+    const struct sbrec_mac_binding *sbmb;
+    SBREC_MAC_BINDING_FOR_EACH_TRACKED (sbmb, ovnsb_idl) {
+        struct ovntrace_mac_binding *binding;
+        HMAP_FOR_EACH_WITH_HASH (binding, uuid_node,
+                                 uuid_hash(&sbmb->header_.uuid),
+                                 &mac_bindings_by_uuid) {
+            if (uuid_equals(&binding->uuid, &sbmb->header_.uuid)) {
+                hmap_remove(&binding->dp->mac_bindings, &binding->node);
+                hmap_remove(&mac_bindings_by_uuid, &binding->uuid_node);
+                free(binding);
+                break;
+            }
+        }
+        if (!sbrec_mac_binding_is_deleted(sbmb)) {
+            read_mac_binding(sbmb);
+        }
+    }
+}
+
+/* Applies the changes to the FDB table tracked by the IDL. */
+static void
+update_fdbs(void)
+{
+    const struct sbrec_fdb *sbfdb;
+    SBREC_FDB_FOR_EACH_TRACKED (sbfdb, ovnsb_idl) {
+        struct ovntrace_fdb *fdb;
+        HMAP_FOR_EACH_WITH_HASH (fdb, uuid_node,
+                                 uuid_hash(&sbfdb->header_.uuid),
+                                 &fdbs_by_uuid) {
+            if (uuid_equals(&fdb->uuid, &sbfdb->header_.uuid)) {
+                hmap_remove(&fdb->dp->fdbs, &fdb->node);
+                hmap_remove(&fdbs_by_uuid, &fdb->uuid_node);
+                free(fdb);
+                break;
+            }
+        }
+        if (!sbrec_fdb_is_deleted(sbfdb)) {
+            read_fdb(sbfdb);
+        }
+    }
+}
+
+/* Brings the data read by read_db() up to date with the changes tracked by
+ * the IDL, for daemon mode.
+ *
+ * Logical flows, which are by far the most expensive to read, are updated
+ * incrementally, as are MAC bindings and FDB entries.  Logical flow matches
+ * and actions depend on the rest of the data, so any other relevant change
+ * causes everything to be read again. */
+static void
+update_db(void)
+{
+    bool reload = (port_bindings_changed() ||
+                   sbrec_datapath_binding_track_get_first(ovnsb_idl) ||
+                   sbrec_multicast_group_track_get_first(ovnsb_idl) ||
+                   sbrec_address_set_track_get_first(ovnsb_idl) ||
+                   sbrec_port_group_track_get_first(ovnsb_idl) ||
+                   sbrec_dhcp_options_track_get_first(ovnsb_idl) ||
+                   sbrec_dhcpv6_options_track_get_first(ovnsb_idl) ||
+                   sbrec_logical_dp_group_track_get_first(ovnsb_idl));
+
+    if (reload) {
+        destroy_db();
+        read_db();
+    } else {
+        if (sbrec_logical_flow_track_get_first(ovnsb_idl)) {
+            update_flows();
+        }
+        update_mac_bindings();
+        update_fdbs();
+    }
+    ovsdb_idl_track_clear(ovnsb_idl);
+}
+
 static const struct ovntrace_port *
 ovntrace_port_lookup_by_name(const char *name)
 {
@@ -1249,11 +1946,9 @@ ovntrace_port_lookup_by_name(const char *name)
 }
 
 static bool
-ovntrace_lookup_port(const void *dp_, const char *port_name,
-                     unsigned int *portp)
+ovntrace_lookup_port__(const struct ovntrace_datapath *dp,
+                       const char *port_name, unsigned int *portp, bool warn)
 {
-    const struct ovntrace_datapath *dp = dp_;
-
     if (port_name[0] == '\0') {
         *portp = 0;
         return true;
@@ -1281,21 +1976,73 @@ ovntrace_lookup_port(const void *dp_, const char *port_name,
         return true;
     }
 
-    VLOG_WARN_RL(&rl, "%s: unknown logical port", port_name);
+    if (warn) {
+        VLOG_WARN_RL(&rl, "%s: unknown logical port", port_name);
+    }
     return false;
 }
 
+static bool
+ovntrace_lookup_port(const void *dp, const char *port_name,
+                     unsigned int *portp)
+{
+    return ovntrace_lookup_port__(dp, port_name, portp, true);
+}
+
+/* Statistics for the trace in progress, for logging. */
+static unsigned int n_flow_lookups;
+static unsigned int n_flows_evaluated;
+
+static bool
+ovntrace_flow_matches(const struct ovntrace_datapath *dp,
+                      const struct ovntrace_flow *flow,
+                      const struct flow *uflow)
+{
+    n_flows_evaluated++;
+    return expr_program_evaluate(flow->match_prog, uflow,
+                                 ovntrace_lookup_port, dp);
+}
+
 static const struct ovntrace_flow *
 ovntrace_flow_lookup(const struct ovntrace_datapath *dp,
                      const struct flow *uflow,
                      uint8_t table_id, enum ovnact_pipeline pipeline)
 {
-    const struct ovntrace_flow *flow;
-    VECTOR_FOR_EACH (&dp->flows, flow) {
-        if (flow->pipeline == pipeline &&
-            flow->table_id == table_id &&
-            expr_evaluate(flow->match, uflow, ovntrace_lookup_port, dp)) {
-            return flow;
+    const struct ovntrace_table *table = ovntrace_table_find(dp, table_id,
+                                                             pipeline);
+    if (!table) {
+        return NULL;
+    }
+    n_flow_lookups++;
+
+    struct ovntrace_flow *const *flows = vector_get_array(&table->flows);
+    if (!table->key_field) {
+        for (size_t i = 0; i < vector_len(&table->flows); i++) {
+            if (ovntrace_flow_matches(dp, flows[i], uflow)) {
+                return flows[i];
+            }
+        }
+        return NULL;
+    }
+
+    union mf_value value;
+    mf_get_value(table->key_field, uflow, &value);
+    const struct ovntrace_bucket *bucket = ovntrace_bucket_find(
+        table, ovntrace_bytes_to_key(value.b, table->key_field->n_bytes));
+
+    /* Merge the bucket's flows with the wildcarded flows, to consider them in
+     * the same order as 'flows'. */
+    const size_t *a = vector_get_array(&table->wildcards);
+    size_t n_a = vector_len(&table->wildcards);
+    const size_t *b = bucket ? vector_get_array(&bucket->flows) : NULL;
+    size_t n_b = bucket ? vector_len(&bucket->flows) : 0;
+    size_t i = 0, j = 0;
+    while (i < n_a || j < n_b) {
+        size_t idx = (j >= n_b || (i < n_a && a[i] < b[j])
+                      ? a[i++]
+                      : b[j++]);
+        if (ovntrace_flow_matches(dp, flows[idx], uflow)) {
+            return flows[idx];
         }
     }
     return NULL;
@@ -1305,11 +2052,12 @@ static char *
 ovntrace_stage_name(const struct ovntrace_datapath *dp,
                     uint8_t table_id, enum ovnact_pipeline pipeline)
 {
-    const struct ovntrace_flow *flow;
-    VECTOR_FOR_EACH (&dp->flows, flow) {
-        if (flow->pipeline == pipeline && flow->table_id == table_id) {
-            return xstrdup(flow->stage_name);;
-        }
+    const struct ovntrace_table *table = ovntrace_table_find(dp, table_id,
+                                                             pipeline);
+    if (table && !vector_is_empty(&table->flows)) {
+        const struct ovntrace_flow *flow = vector_get(&table->flows, 0,
+                                                      struct ovntrace_flow *);
+        return xstrdup(flow->stage_name);
     }
     return NULL;
 }
@@ -1485,6 +2233,35 @@ ovntrace_node_print_summary(struct ds *output, const struct ovs_list *nodes,
     }
 }
 
+/* Like ovntrace_node_print_summary(), but prints 'nodes' on a single line. */
+static void
+ovntrace_node_print_compact(struct ds *output, const struct ovs_list *nodes)
+{
+    const struct ovntrace_node *sub;
+    bool first = true;
+    LIST_FOR_EACH (sub, node, nodes) {
+        if (sub->type == OVNTRACE_NODE_ACTION
+            && !strncmp(sub->name, "next(", 5)) {
+            continue;
+        }
+
+        if (!first) {
+            ds_put_char(output, ' ');
+        }
+        first = false;
+
+        ds_put_cstr(output, sub->name);
+        if (!ovs_list_is_empty(&sub->subs)) {
+            ds_put_cstr(output, " { ");
+            ovntrace_node_print_compact(output, &sub->subs);
+            ds_put_cstr(output, " }");
+        }
+        if (sub->type != OVNTRACE_NODE_ACTION) {
+            ds_put_char(output, ';');
+        }
+    }
+}
+
 static void
 ovntrace_node_prune_hard(struct ovs_list *nodes)
 {
@@ -3782,28 +4559,26 @@ trace_parse(const char *dp_s, const char *flow_s,
     return NULL;
 }
 
-static char *
-trace(const char *dp_s, const char *flow_s)
+/* Traces 'flow_s' through the datapath named 'dp_s' or, if 'dp_s' is NULL,
+ * through the datapath of the microflow's ingress port, and appends the trace
+ * to 'root'.  Returns NULL and stores the parsed microflow in '*uflow' if
+ * successful, otherwise returns an error message that the caller must free. */
+static char * OVS_WARN_UNUSED_RESULT
+trace_to_nodes(const char *dp_s, const char *flow_s, struct flow *uflow,
+               struct ovs_list *root)
 {
     const struct ovntrace_datapath *dp;
-    struct flow uflow;
-    char *error = trace_parse(dp_s, flow_s, &dp, &uflow);
+    char *error = trace_parse(dp_s, flow_s, &dp, uflow);
     if (error) {
         return error;
     }
-    uint32_t in_key = uflow.regs[MFF_LOG_INPORT - MFF_REG0];
+    uint32_t in_key = uflow->regs[MFF_LOG_INPORT - MFF_REG0];
     if (!in_key) {
         return xstrdup("microflow does not specify ingress port");
     }
     const struct ovntrace_port *inport = ovntrace_port_find_by_key(dp, in_key);
     const char *inport_name = inport ? inport->friendly_name : "(unnamed)";
 
-    struct ds output = DS_EMPTY_INITIALIZER;
-
-    ds_put_cstr(&output, "# ");
-    flow_format(&output, &uflow, NULL);
-    ds_put_char(&output, '\n');
-
     if (ovs) {
         int retval = vconn_open_block(ovs, 1 << OFP15_VERSION, 0, -1, &vconn);
         if (retval) {
@@ -3812,11 +4587,38 @@ trace(const char *dp_s, const char *flow_s)
         }
     }
 
-    struct ovs_list root = OVS_LIST_INITIALIZER(&root);
     struct ovntrace_node *node = ovntrace_node_append(
-        &root, OVNTRACE_NODE_PIPELINE, "ingress(dp=\"%s\", inport=\"%s\")",
+        root, OVNTRACE_NODE_PIPELINE, "ingress(dp=\"%s\", inport=\"%s\")",
         dp->friendly_name, inport_name);
-    trace__(dp, &uflow, 0, OVNACT_P_INGRESS, &node->subs);
+
+    long long int start = time_usec();
+    n_flow_lookups = n_flows_evaluated = 0;
+    trace__(dp, uflow, 0, OVNACT_P_INGRESS, &node->subs);
+    VLOG_DBG("traced microflow in %lld us (%u table lookups, "
+             "%u logical flow matches evaluated)",
+             time_usec() - start, n_flow_lookups, n_flows_evaluated);
+
+    vconn_close(vconn);
+    vconn = NULL;
+
+    return NULL;
+}
+
+static char *
+trace(const char *dp_s, const char *flow_s)
+{
+    struct ovs_list root = OVS_LIST_INITIALIZER(&root);
+    struct flow uflow;
+    char *error = trace_to_nodes(dp_s, flow_s, &uflow, &root);
+    if (error) {
+        return error;
+    }
+
+    struct ds output = DS_EMPTY_INITIALIZER;
+
+    ds_put_cstr(&output, "# ");
+    flow_format(&output, &uflow, NULL);
+    ds_put_char(&output, '\n');
 
     bool multiple = (detailed + summary + minimal) > 1;
     if (detailed) {
@@ -3847,10 +4649,68 @@ trace(const char *dp_s, const char *flow_s)
 
     ovntrace_node_list_destroy(&root);
 
-    vconn_close(vconn);
-
     return ds_steal_cstr(&output);
 }
+
+/* Traces 'flow_s' for batch mode, in the same way as trace() but with the
+ * datapath taken from the microflow's ingress port, and appends a single line
+ * with the microflow and the minimal form of the trace to 'output'. */
+static void
+trace_compact(const char *flow_s, struct ds *output)
+{
+    struct ovs_list root = OVS_LIST_INITIALIZER(&root);
+    struct flow uflow;
+
+    /* Each microflow starts over with the --ct states. */
+    ct_state_idx = 0;
+
+    ds_put_format(output, "%s => ", flow_s);
+    char *error = trace_to_nodes(NULL, flow_s, &uflow, &root);
+    if (error) {
+        ds_put_format(output, "error: %s", error);
+        ds_chomp(output, '\n');
+        free(error);
+    } else {
+        size_t length = output->length;
+        ovntrace_node_prune_hard(&root);
+        ovntrace_node_print_compact(output, &root);
+        if (output->length == length) {
+            ds_put_cstr(output, "(no output)");
+        }
+    }
+    ds_put_char(output, '\n');
+
+    ovntrace_node_list_destroy(&root);
+}
+
+/* Traces each microflow in the file named 'file_name', or stdin if it is
+ * "-", one per line, and prints the results in the form of trace_compact().
+ * Blank lines and lines that begin with "#" are ignored. */
+static void
+trace_batch(const char *file_name)
+{
+    FILE *stream = !strcmp(file_name, "-") ? stdin : fopen(file_name, "r");
+    if (!stream) {
+        ovs_fatal(errno, "%s: open failed", file_name);
+    }
+
+    struct ds line = DS_EMPTY_INITIALIZER;
+    struct ds output = DS_EMPTY_INITIALIZER;
+    while (!ds_get_line(&line, stream)) {
+        const char *flow_s = ds_cstr(&line) + strspn(ds_cstr(&line), " \t");
+        if (*flow_s && *flow_s != '#') {
+            ds_clear(&output);
+            trace_compact(flow_s, &output);
+            fputs(ds_cstr(&output), stdout);
+        }
+    }
+    ds_destroy(&line);
+    ds_destroy(&output);
+
+    if (stream != stdin) {
+        fclose(stream);
+    }
+}
 
 static void
 ovntrace_exit(struct unixctl_conn *conn, int argc OVS_UNUSED,
@@ -3898,3 +4758,15 @@ ovntrace_trace(struct unixctl_conn *conn, int argc,
     unixctl_command_reply(conn, output);
     free(output);
 }
+
+static void
+ovntrace_trace_batch(struct unixctl_conn *conn, int argc,
+                     const char *argv[], void *aux OVS_UNUSED)
+{
+    struct ds output = DS_EMPTY_INITIALIZER;
+    for (int i = 1; i < argc; i++) {
+        trace_compact(argv[i], &output);
+    }
+    unixctl_command_reply(conn, ds_cstr(&output));
+    ds_destroy(&output);
+}